@@ -40,7 +40,11 @@ typedef CRITICAL_SECTION pthread_mutex_t;
 #include <xjni_stringwriter.h>
 #include <xjni_va_list.h>
 #include <xjni_log.h>
+#include <xjni_pool.h>
 #include <xjni2d.h>
+#include <xjni_nd.h>
+#include <xjni_arrow.h>
+#include <xjni_marshal.h>
 
 /** @defgroup XJNI_VERSION Version Macros
  *  @brief Version information for XJNI
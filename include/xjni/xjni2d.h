@@ -14,6 +14,16 @@
 #define __XJNI2D_H__
 
 #include <jni.h>
+#include <xjni_pool.h>
+#include <xjni_nd.h>
+
+/** @enum xjni_Order
+ *  @brief Memory layout of a native matrix
+ */
+typedef enum xjni_Order {
+	XJNI_ROW_MAJOR = 0, /**< rows are contiguous (C order) */
+	XJNI_COL_MAJOR = 1, /**< columns are contiguous (Fortran / BLAS order) */
+} xjni_Order;
 
 #ifdef __cplusplus
 extern "C" {
@@ -96,6 +106,87 @@ JNIEXPORT void JNICALL SetBoolean2DArrayRegion(JNIEnv *env, jobjectArray array,
 JNIEXPORT void JNICALL GetBoolean2DArrayRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jboolean **buf);
 //@}
 
+/** @name Contiguous 2D Array Transfer
+ *  Copy rows [start, start + len) of a rectangular `T[][]` from / to one
+ *  row-major native buffer of `len * cols` elements. Every row must hold
+ *  exactly `cols` elements. The Parallel variants split the rows across the
+ *  workers of @p pool once the transfer reaches xjni_GetParallelThreshold()
+ *  elements and fall back to the calling thread otherwise (or when @p pool is
+ *  NULL). All return JNI_OK on success and JNI_ERR on a NULL or short row.
+ */
+//@{
+JNIEXPORT jint JNICALL GetByte2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jbyte *buf);
+JNIEXPORT jint JNICALL SetByte2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jbyte *buf);
+JNIEXPORT jint JNICALL GetByte2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jbyte *buf);
+JNIEXPORT jint JNICALL SetByte2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jbyte *buf);
+JNIEXPORT jint JNICALL GetInt2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jint *buf);
+JNIEXPORT jint JNICALL SetInt2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jint *buf);
+JNIEXPORT jint JNICALL GetInt2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jint *buf);
+JNIEXPORT jint JNICALL SetInt2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jint *buf);
+JNIEXPORT jint JNICALL GetLong2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jlong *buf);
+JNIEXPORT jint JNICALL SetLong2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jlong *buf);
+JNIEXPORT jint JNICALL GetLong2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jlong *buf);
+JNIEXPORT jint JNICALL SetLong2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jlong *buf);
+JNIEXPORT jint JNICALL GetFloat2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jfloat *buf);
+JNIEXPORT jint JNICALL SetFloat2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jfloat *buf);
+JNIEXPORT jint JNICALL GetFloat2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jfloat *buf);
+JNIEXPORT jint JNICALL SetFloat2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jfloat *buf);
+JNIEXPORT jint JNICALL GetDouble2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jdouble *buf);
+JNIEXPORT jint JNICALL SetDouble2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jdouble *buf);
+JNIEXPORT jint JNICALL GetDouble2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jdouble *buf);
+JNIEXPORT jint JNICALL SetDouble2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jdouble *buf);
+JNIEXPORT jint JNICALL GetShort2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jshort *buf);
+JNIEXPORT jint JNICALL SetShort2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jshort *buf);
+JNIEXPORT jint JNICALL GetShort2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jshort *buf);
+JNIEXPORT jint JNICALL SetShort2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jshort *buf);
+JNIEXPORT jint JNICALL GetChar2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jchar *buf);
+JNIEXPORT jint JNICALL SetChar2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jchar *buf);
+JNIEXPORT jint JNICALL GetChar2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jchar *buf);
+JNIEXPORT jint JNICALL SetChar2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jchar *buf);
+JNIEXPORT jint JNICALL GetBoolean2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, jboolean *buf);
+JNIEXPORT jint JNICALL SetBoolean2DArrayFlatRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, jsize cols, const jboolean *buf);
+JNIEXPORT jint JNICALL GetBoolean2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, jboolean *buf);
+JNIEXPORT jint JNICALL SetBoolean2DArrayFlatRegionParallel(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jsize start, jsize len, jsize cols, const jboolean *buf);
+//@}
+
+/** @name Converting 2D Array Transfer */
+//@{
+/**
+ * @brief Export a rectangular primitive `T[][]` to a native matrix of another element type
+ *
+ * Elements are converted with Java cast semantics (floating point to integral
+ * saturates, NaN becomes 0). Column-major output is produced by a
+ * cache-blocked transpose.
+ *
+ * @param env JNI environment pointer
+ * @param array Java 2D array, every row holding exactly @p cols elements
+ * @param type Element type of the rows of @p array
+ * @param rows Number of rows to export (from row 0)
+ * @param cols Number of columns
+ * @param dtype Element type of @p dst (e.g. XJNI_TYPE_FLOAT for sgemm)
+ * @param order Layout of @p dst
+ * @param ld Leading dimension of @p dst in elements, or 0 for packed
+ * @param dst Destination matrix
+ * @return JNI_OK on success, JNI_ERR on a bad argument or a NULL or short row
+ */
+JNIEXPORT jint JNICALL xjni_Export2DArray(JNIEnv *env, jobjectArray array, xjni_ElementType type, jsize rows, jsize cols, xjni_ElementType dtype, xjni_Order order, size_t ld, void *dst);
+
+/**
+ * @brief Import a native matrix of any element type into a rectangular primitive `T[][]`
+ * @param env JNI environment pointer
+ * @param array Java 2D array, every row holding exactly @p cols elements
+ * @param type Element type of the rows of @p array
+ * @param rows Number of rows to import (from row 0)
+ * @param cols Number of columns
+ * @param stype Element type of @p src
+ * @param order Layout of @p src
+ * @param ld Leading dimension of @p src in elements, or 0 for packed
+ * @param src Source matrix
+ * @return JNI_OK on success, JNI_ERR on a bad argument or a NULL or short row
+ */
+JNIEXPORT jint JNICALL xjni_Import2DArray(JNIEnv *env, jobjectArray array, xjni_ElementType type, jsize rows, jsize cols, xjni_ElementType stype, xjni_Order order, size_t ld, const void *src);
+//@}
+
 /** @name String UTF 2D Array Utility **/
 //@{
 JNIEXPORT jobjectArray JNICALL NewStringUTF2DArray(JNIEnv *env,const char ***utf,jsize row,jsize col);
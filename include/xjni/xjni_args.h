@@ -20,10 +20,49 @@
  */
 typedef jobjectArray jargs_t;
 
+/** @typedef jargs_stage_t
+ *  @brief Native staging vector of arguments (opaque), see XJNI_Args_Stage
+ */
+typedef struct jargs_stage jargs_stage_t;
+
+/** @typedef jargs_builder_t
+ *  @brief Argument array with a native fill cursor (opaque), see XJNI_Args_Builder
+ */
+typedef struct jargs_builder jargs_builder_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** @defgroup XJNI_Args_Lifecycle Lifecycle
+ *  @brief Resolution of the box classes used by the typed functions
+ *
+ *  The box classes, their `valueOf` factories and unboxing methods are
+ *  resolved once, together with global references to the canonical boxes of
+ *  `Boolean.FALSE` / `Boolean.TRUE`, characters 0..127 and Integer / Long
+ *  values -128..127, which are then reused instead of calling `valueOf`.
+ *  Resolution happens on first use when XJNI_Args_OnLoad() was not called.
+ *  @{
+ */
+
+/**
+ * @brief Resolve the box classes and preload the small value tables
+ * @param vm JavaVM pointer
+ * @param reserved Reserved pointer (JNI spec)
+ * @param ver JNI version
+ * @return @p ver on success, JNI_ERR on failure
+ */
+JNIEXPORT jint JNICALL XJNI_Args_OnLoad(JavaVM* vm, void* reserved, jint ver);
+
+/**
+ * @brief Release the box classes and tables
+ * @param vm JavaVM pointer
+ * @param reserved Reserved pointer (JNI spec)
+ * @param ver JNI version
+ */
+JNIEXPORT void JNICALL XJNI_Args_OnUnload(JavaVM* vm, void* reserved, jint ver);
+/** @} */
+
 /** @defgroup XJNI_Args Creation
  *  @brief Functions for creating Java argument arrays
  *  @{
@@ -40,6 +79,88 @@ extern "C" {
 JNIEXPORT jargs_t JNICALL NewJArgs(JNIEnv *env, jsize index, jclass cls, jobject init);
 /** @} */
 
+/** @defgroup XJNI_Args_Builder Builder
+ *  @brief Argument arrays filled through a native cursor
+ *
+ *  A builder owns a Java array and its fill position, so appends cost one
+ *  `SetObjectArrayElement` instead of a scan for the first free slot. The
+ *  elements are stored into the array as they are added and no references
+ *  are kept on the native side: JArgsBuilderArray() can be passed to the
+ *  plain JArgs* and GetJArgs* functions at any time, but only the
+ *  JArgsBuilder* functions move the cursor. The array is a local reference,
+ *  so the builder must be finished or freed before the native method returns.
+ *  @{
+ */
+
+/**
+ * @brief Create a Java argument array with a native fill cursor
+ * @param env JNI environment pointer
+ * @param capacity Array length
+ * @param cls Java class of array elements
+ * @return New builder, or NULL on failure
+ */
+JNIEXPORT jargs_builder_t* JNICALL NewJArgsBuilder(JNIEnv *env, jsize capacity, jclass cls);
+
+/**
+ * @brief Release a builder and keep its array
+ * @param builder Builder (may be NULL)
+ * @return The array, a local reference now owned by the caller
+ */
+JNIEXPORT jargs_t JNICALL JArgsBuilderFinish(jargs_builder_t *builder);
+
+/**
+ * @brief Release a builder together with its array
+ * @param env JNI environment pointer
+ * @param builder Builder (may be NULL)
+ */
+JNIEXPORT void JNICALL JArgsBuilderFree(JNIEnv *env, jargs_builder_t *builder);
+
+/**
+ * @brief Get the array of a builder
+ * @param builder Builder
+ * @return The array, still owned by the builder
+ */
+JNIEXPORT jargs_t JNICALL JArgsBuilderArray(const jargs_builder_t *builder);
+
+/**
+ * @brief Get the fill position of a builder
+ * @param builder Builder
+ * @return Index one past the last stored element
+ */
+JNIEXPORT jsize JNICALL JArgsBuilderSize(const jargs_builder_t *builder);
+
+JNIEXPORT void JNICALL JArgsBuilderAppendObject(JNIEnv *env, jargs_builder_t *builder, jobject obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendString(JNIEnv *env, jargs_builder_t *builder, jstring obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendStringUTF(JNIEnv *env, jargs_builder_t *builder, const char* utf);
+JNIEXPORT void JNICALL JArgsBuilderAppendChar(JNIEnv *env, jargs_builder_t *builder, jchar obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendBoolean(JNIEnv *env, jargs_builder_t *builder, jboolean obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendInt(JNIEnv *env, jargs_builder_t *builder, jint obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendLong(JNIEnv *env, jargs_builder_t *builder, jlong obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendFloat(JNIEnv *env, jargs_builder_t *builder, jfloat obj);
+JNIEXPORT void JNICALL JArgsBuilderAppendDouble(JNIEnv *env, jargs_builder_t *builder, jdouble obj);
+
+/** Inserting before the fill position shifts the filled elements right, the last one falls off a full array */
+JNIEXPORT void JNICALL JArgsBuilderInsertObject(JNIEnv *env, jargs_builder_t *builder, jobject obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertString(JNIEnv *env, jargs_builder_t *builder, jstring obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertStringUTF(JNIEnv *env, jargs_builder_t *builder, const char* utf, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertChar(JNIEnv *env, jargs_builder_t *builder, jchar obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertBoolean(JNIEnv *env, jargs_builder_t *builder, jboolean obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertInt(JNIEnv *env, jargs_builder_t *builder, jint obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertLong(JNIEnv *env, jargs_builder_t *builder, jlong obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertFloat(JNIEnv *env, jargs_builder_t *builder, jfloat obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderInsertDouble(JNIEnv *env, jargs_builder_t *builder, jdouble obj, jsize index);
+
+JNIEXPORT void JNICALL JArgsBuilderReplaceObject(JNIEnv *env, jargs_builder_t *builder, jobject obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceString(JNIEnv *env, jargs_builder_t *builder, jstring obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceStringUTF(JNIEnv *env, jargs_builder_t *builder, const char* utf, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceChar(JNIEnv *env, jargs_builder_t *builder, jchar obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceBoolean(JNIEnv *env, jargs_builder_t *builder, jboolean obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceInt(JNIEnv *env, jargs_builder_t *builder, jint obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceLong(JNIEnv *env, jargs_builder_t *builder, jlong obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceFloat(JNIEnv *env, jargs_builder_t *builder, jfloat obj, jsize index);
+JNIEXPORT void JNICALL JArgsBuilderReplaceDouble(JNIEnv *env, jargs_builder_t *builder, jdouble obj, jsize index);
+/** @} */
+
 /** @defgroup XJNI_Args_Append Append Elements
  *  @brief Functions to append elements to a Java argument array
  *  @{
@@ -85,6 +206,87 @@ JNIEXPORT void JNICALL JArgsReplaceFloat(JNIEnv *env, jargs_t args, jfloat obj,
 JNIEXPORT void JNICALL JArgsReplaceDouble(JNIEnv *env, jargs_t args, jdouble obj, jsize index);
 /** @} */
 
+/** @defgroup XJNI_Args_Stage Staging
+ *  @brief Argument lists built natively and boxed into a `jargs_t` once
+ *
+ *  A stage stores each argument as a type tag and a `jvalue`; append, insert,
+ *  replace and delete are memory operations with no JNI calls. Boxing, through
+ *  the cached `valueOf` factories, happens in one pass when the stage is
+ *  materialized by JArgsStageToJArgs() or one of the `*Stage` print functions,
+ *  where small values come from the preloaded tables without any call.
+ *  Objects and jstrings are not referenced by the stage: the caller keeps them
+ *  valid until the stage is materialized. StringUTF arguments are copied.
+ *  @{
+ */
+
+/**
+ * @brief Create an empty stage
+ * @param capacity Number of arguments to reserve room for (the stage grows as needed)
+ * @return New stage, or NULL on failure
+ */
+JNIEXPORT jargs_stage_t* JNICALL JArgsStageNew(jsize capacity);
+
+/**
+ * @brief Remove every argument, keeping the storage
+ * @param stage Stage
+ */
+JNIEXPORT void JNICALL JArgsStageClear(jargs_stage_t *stage);
+
+/**
+ * @brief Free a stage
+ * @param stage Stage (may be NULL)
+ */
+JNIEXPORT void JNICALL JArgsStageFree(jargs_stage_t *stage);
+
+/**
+ * @brief Get the number of staged arguments
+ * @param stage Stage
+ * @return Argument count
+ */
+JNIEXPORT jsize JNICALL JArgsStageSize(const jargs_stage_t *stage);
+
+JNIEXPORT void JNICALL JArgsStageAppendObject(jargs_stage_t *stage, jobject obj);
+JNIEXPORT void JNICALL JArgsStageAppendString(jargs_stage_t *stage, jstring obj);
+JNIEXPORT void JNICALL JArgsStageAppendStringUTF(jargs_stage_t *stage, const char* utf);
+JNIEXPORT void JNICALL JArgsStageAppendChar(jargs_stage_t *stage, jchar obj);
+JNIEXPORT void JNICALL JArgsStageAppendBoolean(jargs_stage_t *stage, jboolean obj);
+JNIEXPORT void JNICALL JArgsStageAppendInt(jargs_stage_t *stage, jint obj);
+JNIEXPORT void JNICALL JArgsStageAppendLong(jargs_stage_t *stage, jlong obj);
+JNIEXPORT void JNICALL JArgsStageAppendFloat(jargs_stage_t *stage, jfloat obj);
+JNIEXPORT void JNICALL JArgsStageAppendDouble(jargs_stage_t *stage, jdouble obj);
+
+/* Insert before index; index may equal the size to append */
+JNIEXPORT void JNICALL JArgsStageInsertObject(jargs_stage_t *stage, jobject obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertString(jargs_stage_t *stage, jstring obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertStringUTF(jargs_stage_t *stage, const char* utf, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertChar(jargs_stage_t *stage, jchar obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertBoolean(jargs_stage_t *stage, jboolean obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertInt(jargs_stage_t *stage, jint obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertLong(jargs_stage_t *stage, jlong obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertFloat(jargs_stage_t *stage, jfloat obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageInsertDouble(jargs_stage_t *stage, jdouble obj, jsize index);
+
+JNIEXPORT void JNICALL JArgsStageReplaceObject(jargs_stage_t *stage, jobject obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceString(jargs_stage_t *stage, jstring obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceStringUTF(jargs_stage_t *stage, const char* utf, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceChar(jargs_stage_t *stage, jchar obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceBoolean(jargs_stage_t *stage, jboolean obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceInt(jargs_stage_t *stage, jint obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceLong(jargs_stage_t *stage, jlong obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceFloat(jargs_stage_t *stage, jfloat obj, jsize index);
+JNIEXPORT void JNICALL JArgsStageReplaceDouble(jargs_stage_t *stage, jdouble obj, jsize index);
+
+JNIEXPORT void JNICALL JArgsStageDelete(jargs_stage_t *stage, jsize index);
+
+/**
+ * @brief Box every staged argument into a new Object[]
+ * @param env JNI environment
+ * @param stage Stage (left unchanged)
+ * @return New argument array (local reference), or NULL on failure
+ */
+JNIEXPORT jargs_t JNICALL JArgsStageToJArgs(JNIEnv *env, const jargs_stage_t *stage);
+/** @} */
+
 /** @defgroup XJNI_Args_Delete Delete Elements
  *  @brief Remove elements from Java argument array
  *  @{
@@ -110,9 +312,27 @@ JNIEXPORT char* JNICALL GetJArgsStringUTF(JNIEnv *env, jargs_t args, jsize index
 
 JNIEXPORT jchar JNICALL GetJArgsChar(JNIEnv *env, jargs_t args, jsize index);
 JNIEXPORT jboolean JNICALL GetJArgsBoolean(JNIEnv *env, jargs_t args, jsize index);
+JNIEXPORT jint JNICALL GetJArgsInt(JNIEnv *env, jargs_t args, jsize index);
 JNIEXPORT jlong JNICALL GetJArgsLong(JNIEnv *env, jargs_t args, jsize index);
 JNIEXPORT jfloat JNICALL GetJArgsFloat(JNIEnv *env, jargs_t args, jsize index);
 JNIEXPORT jdouble JNICALL GetJArgsDouble(JNIEnv *env, jargs_t args, jsize index);
+
+/**
+ * @brief Unbox every element of a Java argument array in one pass
+ *
+ * Each element is matched against the cached box classes by its class and
+ * read through the box's value field (or its unboxing method when the field
+ * is not available). @p types receives the JNI type letter of each element:
+ * 'Z' 'B' 'C' 'S' 'I' 'J' 'F' 'D' for boxes, 'L' for any other object (its
+ * value is not decoded, `out[i].l` is NULL) and '\0' for null elements.
+ *
+ * @param env JNI environment
+ * @param args Argument array
+ * @param out Receives one value per element
+ * @param types Receives one type letter per element
+ * @return Number of elements decoded, or -1 on failure
+ */
+JNIEXPORT jsize JNICALL GetJArgsAll(JNIEnv *env, jargs_t args, jvalue *out, char *types);
 /** @} */
 
 #ifdef __cplusplus
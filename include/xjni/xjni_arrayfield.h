@@ -15,6 +15,14 @@
 
 #include <jni.h>
 
+/**
+ * Number of slots of the field ID cache behind the *ByName accessors
+ * (a power of two). Can be overridden at build time.
+ */
+#ifndef XJNI_FIELD_CACHE_SIZE
+#define XJNI_FIELD_CACHE_SIZE 256
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -39,6 +47,14 @@ JNIEXPORT void JNICALL SetArrayField(JNIEnv *env, jobject obj, jfieldID fid, jar
 JNIEXPORT void JNICALL SetStaticArrayField(JNIEnv *env, jclass cls, jfieldID fid, jarray value);
 //@}
 
+/** @name Boolean Array Field Accessors */
+//@{
+JNIEXPORT jbooleanArray JNICALL GetBooleanArrayField(JNIEnv *env, jobject obj, jfieldID fid);
+JNIEXPORT jbooleanArray JNICALL GetStaticBooleanArrayField(JNIEnv *env, jclass cls, jfieldID fid);
+JNIEXPORT void JNICALL SetBooleanArrayField(JNIEnv *env, jobject obj, jfieldID fid, jbooleanArray value);
+JNIEXPORT void JNICALL SetStaticBooleanArrayField(JNIEnv *env, jclass cls, jfieldID fid, jbooleanArray value);
+//@}
+
 /** @name Byte Array Field Accessors */
 //@{
 JNIEXPORT jbyteArray JNICALL GetByteArrayField(JNIEnv *env, jobject obj, jfieldID fid);
@@ -47,6 +63,22 @@ JNIEXPORT void JNICALL SetByteArrayField(JNIEnv *env, jobject obj, jfieldID fid,
 JNIEXPORT void JNICALL SetStaticByteArrayField(JNIEnv *env, jclass cls, jfieldID fid, jbyteArray value);
 //@}
 
+/** @name Char Array Field Accessors */
+//@{
+JNIEXPORT jcharArray JNICALL GetCharArrayField(JNIEnv *env, jobject obj, jfieldID fid);
+JNIEXPORT jcharArray JNICALL GetStaticCharArrayField(JNIEnv *env, jclass cls, jfieldID fid);
+JNIEXPORT void JNICALL SetCharArrayField(JNIEnv *env, jobject obj, jfieldID fid, jcharArray value);
+JNIEXPORT void JNICALL SetStaticCharArrayField(JNIEnv *env, jclass cls, jfieldID fid, jcharArray value);
+//@}
+
+/** @name Short Array Field Accessors */
+//@{
+JNIEXPORT jshortArray JNICALL GetShortArrayField(JNIEnv *env, jobject obj, jfieldID fid);
+JNIEXPORT jshortArray JNICALL GetStaticShortArrayField(JNIEnv *env, jclass cls, jfieldID fid);
+JNIEXPORT void JNICALL SetShortArrayField(JNIEnv *env, jobject obj, jfieldID fid, jshortArray value);
+JNIEXPORT void JNICALL SetStaticShortArrayField(JNIEnv *env, jclass cls, jfieldID fid, jshortArray value);
+//@}
+
 /** @name Int Array Field Accessors */
 //@{
 JNIEXPORT jintArray JNICALL GetIntArrayField(JNIEnv *env, jobject obj, jfieldID fid);
@@ -79,6 +111,119 @@ JNIEXPORT void JNICALL SetDoubleArrayField(JNIEnv *env, jobject obj, jfieldID fi
 JNIEXPORT void JNICALL SetStaticDoubleArrayField(JNIEnv *env, jclass cls, jfieldID fid, jdoubleArray value);
 //@}
 
+/** @name Cached Field IDs
+ *  Field IDs resolved once per (class, name, signature) and kept in a
+ *  lock-free cache; concurrent lookups never block each other. The cache
+ *  holds weak class references and is emptied by XJNI_ArrayField_OnUnload().
+ */
+//@{
+/**
+ * @brief Cached GetFieldID().
+ * @param env JNI environment pointer
+ * @param cls Class declaring or inheriting the field
+ * @param name Field name
+ * @param sig Field signature
+ * @return Field ID, or NULL with NoSuchFieldError pending
+ */
+JNIEXPORT jfieldID JNICALL xjni_GetFieldIDCached(JNIEnv *env, jclass cls, const char *name, const char *sig);
+
+/**
+ * @brief Cached GetStaticFieldID().
+ * @param env JNI environment pointer
+ * @param cls Class declaring the field
+ * @param name Field name
+ * @param sig Field signature
+ * @return Field ID, or NULL with NoSuchFieldError pending
+ */
+JNIEXPORT jfieldID JNICALL xjni_GetStaticFieldIDCached(JNIEnv *env, jclass cls, const char *name, const char *sig);
+
+/**
+ * @brief Called when the array field module is unloaded; frees the field ID cache.
+ * @param vm JavaVM pointer
+ * @param reserved Reserved pointer (JNI spec)
+ * @param ver JNI version
+ */
+JNIEXPORT void JNICALL XJNI_ArrayField_OnUnload(JavaVM* vm, void* reserved, jint ver);
+//@}
+
+/** @name Array Field Accessors by Name
+ *  Same as the jfieldID accessors, with the field ID looked up in the cache
+ *  from the class of @p obj (or @p cls for static fields) and the field
+ *  name. The signature is implied by the element type, and given explicitly
+ *  for object arrays. A missing field leaves NoSuchFieldError pending.
+ */
+//@{
+JNIEXPORT jobjectArray JNICALL GetObjectArrayFieldByName(JNIEnv *env, jobject obj, const char *name, const char *sig);
+JNIEXPORT jobjectArray JNICALL GetStaticObjectArrayFieldByName(JNIEnv *env, jclass cls, const char *name, const char *sig);
+JNIEXPORT void JNICALL SetObjectArrayFieldByName(JNIEnv *env, jobject obj, const char *name, const char *sig, jobjectArray value);
+JNIEXPORT void JNICALL SetStaticObjectArrayFieldByName(JNIEnv *env, jclass cls, const char *name, const char *sig, jobjectArray value);
+
+JNIEXPORT jbooleanArray JNICALL GetBooleanArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jbooleanArray JNICALL GetStaticBooleanArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetBooleanArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jbooleanArray value);
+JNIEXPORT void JNICALL SetStaticBooleanArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jbooleanArray value);
+
+JNIEXPORT jbyteArray JNICALL GetByteArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jbyteArray JNICALL GetStaticByteArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetByteArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jbyteArray value);
+JNIEXPORT void JNICALL SetStaticByteArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jbyteArray value);
+
+JNIEXPORT jcharArray JNICALL GetCharArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jcharArray JNICALL GetStaticCharArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetCharArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jcharArray value);
+JNIEXPORT void JNICALL SetStaticCharArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jcharArray value);
+
+JNIEXPORT jshortArray JNICALL GetShortArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jshortArray JNICALL GetStaticShortArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetShortArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jshortArray value);
+JNIEXPORT void JNICALL SetStaticShortArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jshortArray value);
+
+JNIEXPORT jintArray JNICALL GetIntArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jintArray JNICALL GetStaticIntArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetIntArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jintArray value);
+JNIEXPORT void JNICALL SetStaticIntArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jintArray value);
+
+JNIEXPORT jlongArray JNICALL GetLongArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jlongArray JNICALL GetStaticLongArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetLongArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jlongArray value);
+JNIEXPORT void JNICALL SetStaticLongArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jlongArray value);
+
+JNIEXPORT jfloatArray JNICALL GetFloatArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jfloatArray JNICALL GetStaticFloatArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetFloatArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jfloatArray value);
+JNIEXPORT void JNICALL SetStaticFloatArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jfloatArray value);
+
+JNIEXPORT jdoubleArray JNICALL GetDoubleArrayFieldByName(JNIEnv *env, jobject obj, const char *name);
+JNIEXPORT jdoubleArray JNICALL GetStaticDoubleArrayFieldByName(JNIEnv *env, jclass cls, const char *name);
+JNIEXPORT void JNICALL SetDoubleArrayFieldByName(JNIEnv *env, jobject obj, const char *name, jdoubleArray value);
+JNIEXPORT void JNICALL SetStaticDoubleArrayFieldByName(JNIEnv *env, jclass cls, const char *name, jdoubleArray value);
+//@}
+
+/** @name Array Field Elements
+ *  Read an instance array field by name and pin its elements in one call.
+ *  @p array receives the field value (a local reference, NULL if the field
+ *  is null or missing). Release<T>ArrayFieldElements() releases the
+ *  elements with @p mode and deletes that reference.
+ */
+//@{
+JNIEXPORT jboolean* JNICALL GetBooleanArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jbooleanArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseBooleanArrayFieldElements(JNIEnv *env, jbooleanArray array, jboolean *elems, jint mode);
+JNIEXPORT jbyte* JNICALL GetByteArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jbyteArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseByteArrayFieldElements(JNIEnv *env, jbyteArray array, jbyte *elems, jint mode);
+JNIEXPORT jchar* JNICALL GetCharArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jcharArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseCharArrayFieldElements(JNIEnv *env, jcharArray array, jchar *elems, jint mode);
+JNIEXPORT jshort* JNICALL GetShortArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jshortArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseShortArrayFieldElements(JNIEnv *env, jshortArray array, jshort *elems, jint mode);
+JNIEXPORT jint* JNICALL GetIntArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jintArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseIntArrayFieldElements(JNIEnv *env, jintArray array, jint *elems, jint mode);
+JNIEXPORT jlong* JNICALL GetLongArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jlongArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseLongArrayFieldElements(JNIEnv *env, jlongArray array, jlong *elems, jint mode);
+JNIEXPORT jfloat* JNICALL GetFloatArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jfloatArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseFloatArrayFieldElements(JNIEnv *env, jfloatArray array, jfloat *elems, jint mode);
+JNIEXPORT jdouble* JNICALL GetDoubleArrayFieldElements(JNIEnv *env, jobject obj, const char *name, jdoubleArray *array, jboolean *isCopy);
+JNIEXPORT void JNICALL ReleaseDoubleArrayFieldElements(JNIEnv *env, jdoubleArray array, jdouble *elems, jint mode);
+//@}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,152 @@
+/**
+ * @file xjni_arrow.h
+ * @brief Extern JNI Arrow C Data Interface Utility
+ *
+ * Exports Java primitive arrays, primitive 2D arrays and String[] into
+ * Arrow C Data Interface structures (ArrowArray / ArrowSchema), and imports
+ * such structures back into Java arrays. Only the C ABI is used, no Arrow
+ * library is needed. The structure definitions are the ones from the Arrow
+ * specification and are skipped when another header already provided them.
+ *
+ * @author MrR736
+ * @date 2026
+ * @copyright GPL-3
+ */
+
+#ifndef __XJNI_ARROW_H__
+#define __XJNI_ARROW_H__
+
+#include <stdint.h>
+#include <jni.h>
+#include <xjni_nd.h>
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+	// Array type description
+	const char *format;
+	const char *name;
+	const char *metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema **children;
+	struct ArrowSchema *dictionary;
+
+	// Release callback
+	void (*release)(struct ArrowSchema *);
+	// Opaque producer-specific data
+	void *private_data;
+};
+
+struct ArrowArray {
+	// Array data description
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void **buffers;
+	struct ArrowArray **children;
+	struct ArrowArray *dictionary;
+
+	// Release callback
+	void (*release)(struct ArrowArray *);
+	// Opaque producer-specific data
+	void *private_data;
+};
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup JNI_Arrow Java Arrow C Data Interface Utilities
+ *  Functions to move Java arrays to and from Arrow C Data Interface structures.
+ *
+ *  Primitive element types map to Arrow as follows: boolean "b" (bit-packed),
+ *  byte "c", char "S", short "s", int "i", long "l", float "f", double "g".
+ *  @{
+ */
+
+/** @name Export */
+//@{
+/**
+ * @brief Export a Java primitive array into an Arrow array.
+ *
+ * The elements are copied once, with a single region transfer, into a
+ * buffer owned by @p out.
+ *
+ * @param env JNI environment pointer
+ * @param array Java primitive array
+ * @param type Element type of @p array
+ * @param out Receives the array; the consumer calls its release callback
+ * @param schema Receives the matching schema; released the same way
+ * @return JNI_OK on success, JNI_ERR on failure (nothing to release then)
+ */
+JNIEXPORT jint JNICALL xjni_ExportArrowArray(JNIEnv *env, jarray array, xjni_ElementType type, struct ArrowArray *out, struct ArrowSchema *schema);
+
+/**
+ * @brief Export a Java primitive 2D array into an Arrow list array.
+ *
+ * A rectangular array without null rows becomes a FixedSizeList ("+w:N");
+ * otherwise it becomes a List ("+l", or "+L" past 2^31 - 1 values) whose
+ * validity bitmap marks the null rows. Each row is copied once into the
+ * shared child buffer, with a bounded number of local references.
+ *
+ * @param env JNI environment pointer
+ * @param array Java 2D array (`T[][]`)
+ * @param type Element type of the rows
+ * @param out Receives the array; the consumer calls its release callback
+ * @param schema Receives the matching schema; released the same way
+ * @return JNI_OK on success, JNI_ERR on failure (nothing to release then)
+ */
+JNIEXPORT jint JNICALL xjni_Export2DArrowArray(JNIEnv *env, jobjectArray array, xjni_ElementType type, struct ArrowArray *out, struct ArrowSchema *schema);
+
+/**
+ * @brief Export a Java String[] into an Arrow UTF-8 string array.
+ *
+ * Uses the packed UTF-8 export; the result is "u" with 32-bit offsets, or
+ * "U" with 64-bit offsets past 2^31 - 1 bytes. Null elements are marked in
+ * the validity bitmap.
+ *
+ * @param env JNI environment pointer
+ * @param array Java String[] object
+ * @param out Receives the array; the consumer calls its release callback
+ * @param schema Receives the matching schema; released the same way
+ * @return JNI_OK on success, JNI_ERR on failure (nothing to release then)
+ */
+JNIEXPORT jint JNICALL xjni_ExportArrowStringArray(JNIEnv *env, jobjectArray array, struct ArrowArray *out, struct ArrowSchema *schema);
+//@}
+
+/** @name Import */
+//@{
+/**
+ * @brief Create a Java array from an Arrow array.
+ *
+ * Supports the primitive formats listed above, "u" / "U" strings (to
+ * String[]) and "+w:N" / "+l" / "+L" lists of a primitive type (to `T[][]`,
+ * null list entries becoming null rows). Null slots of primitive values
+ * import as zero / false. The Arrow structures are only read: the caller
+ * still owns them and releases them afterwards.
+ *
+ * @param env JNI environment pointer
+ * @param array Arrow array
+ * @param schema Schema of @p array
+ * @return New Java array, or NULL for an unsupported format or on failure
+ */
+JNIEXPORT jobject JNICALL xjni_ImportArrowArray(JNIEnv *env, const struct ArrowArray *array, const struct ArrowSchema *schema);
+//@}
+
+/** @} */ // end of JNI_Arrow group
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __XJNI_ARROW_H__ */
@@ -0,0 +1,215 @@
+/**
+ * @file xjni_marshal.h
+ * @brief Extern JNI Object Marshalling Utility
+ *
+ * Copies the fields of Java objects into C structs from a descriptor table,
+ * and builds Java objects back from such structs.
+ * The table maps Java field names and signatures to struct offsets; it is
+ * compiled once, which resolves every jfieldID, and then used for single
+ * objects or whole Object[] arrays. String and array fields are copied into
+ * an arena that owns their storage.
+ *
+ * Field signatures and the matching C member types:
+ * - "Z" "B" "C" "S" "I" "J" "F" "D": jboolean ... jdouble
+ * - "Ljava/lang/String;": const char *, modified UTF-8 in the arena, NULL for null
+ * - "[Z" ... "[D": xjni_view_t, elements in the arena, data NULL for a null array
+ *
+ * @author MrR736
+ * @date 2026
+ * @copyright GPL-3
+ */
+
+#ifndef __XJNI_MARSHAL_H__
+#define __XJNI_MARSHAL_H__
+
+#include <stddef.h>
+#include <jni.h>
+#include <xjni_nd.h>
+
+/** Default size of the blocks an arena allocates. */
+#ifndef XJNI_ARENA_BLOCK
+#define XJNI_ARENA_BLOCK (64 * 1024)
+#endif
+
+/** @brief One Java field mapped to a C struct member */
+typedef struct xjni_field_t {
+	const char *name;  /**< Java field name */
+	const char *sig;   /**< JNI field signature */
+	size_t offset;     /**< Offset of the member in the C struct */
+} xjni_field_t;
+
+/** @brief Descriptor entry for member @p member of struct @p type */
+#define XJNI_FIELD(type, member, name, sig) { (name), (sig), offsetof(type, member) }
+
+/** @brief Copied primitive array field */
+typedef struct xjni_view_t {
+	const void *data; /**< Elements in the arena, NULL for a null array */
+	jsize length;     /**< Number of elements */
+} xjni_view_t;
+
+/** @brief Compiled descriptor table (opaque) */
+typedef struct xjni_marshal xjni_marshal_t;
+
+/** @brief Bump allocator owning the strings and arrays of marshalled structs (opaque) */
+typedef struct xjni_arena xjni_arena_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup JNI_Marshal Java Object Marshalling Utilities
+ *  Functions to copy Java objects to and from C structs.
+ *  @{
+ */
+
+/** @name Arena */
+//@{
+/**
+ * @brief Create an arena.
+ * @param blockSize Size of each block, or 0 for XJNI_ARENA_BLOCK
+ * @return New arena, or NULL on failure
+ */
+JNIEXPORT xjni_arena_t* JNICALL xjni_ArenaNew(size_t blockSize);
+
+/**
+ * @brief Allocate from an arena; the memory stays valid until reset or free.
+ * @param arena Arena
+ * @param size Number of bytes
+ * @return 8-byte aligned memory, or NULL on failure
+ */
+JNIEXPORT void* JNICALL xjni_ArenaAlloc(xjni_arena_t *arena, size_t size);
+
+/**
+ * @brief Drop every allocation but keep the first block for reuse.
+ * @param arena Arena
+ */
+JNIEXPORT void JNICALL xjni_ArenaReset(xjni_arena_t *arena);
+
+/**
+ * @brief Free an arena and everything allocated from it.
+ * @param arena Arena (may be NULL)
+ */
+JNIEXPORT void JNICALL xjni_ArenaFree(xjni_arena_t *arena);
+//@}
+
+/** @name Extraction */
+//@{
+/**
+ * @brief Compile a descriptor table against a class.
+ *
+ * Every field ID is resolved here, through the array field ID cache, so
+ * the copy loops make no lookups.
+ *
+ * @param env JNI environment pointer
+ * @param cls Class of the objects (a global reference is kept)
+ * @param fields Descriptor table
+ * @param count Number of entries in @p fields
+ * @param structSize sizeof the C struct
+ * @return Compiled table, or NULL if a field is missing (NoSuchFieldError
+ *         pending) or has an unsupported signature
+ */
+JNIEXPORT xjni_marshal_t* JNICALL xjni_MarshalCompile(JNIEnv *env, jclass cls, const xjni_field_t *fields, jsize count, size_t structSize);
+
+/**
+ * @brief Free a compiled table.
+ * @param env JNI environment pointer
+ * @param marshal Compiled table (may be NULL)
+ */
+JNIEXPORT void JNICALL xjni_MarshalFree(JNIEnv *env, xjni_marshal_t *marshal);
+
+/**
+ * @brief Copy the fields of one object into a C struct.
+ * @param env JNI environment pointer
+ * @param marshal Compiled table
+ * @param obj Java object of the compiled class
+ * @param out Destination struct
+ * @param arena Arena for String and array fields (may be NULL if there are none)
+ * @return JNI_OK on success, JNI_ERR on failure
+ */
+JNIEXPORT jint JNICALL xjni_MarshalObject(JNIEnv *env, const xjni_marshal_t *marshal, jobject obj, void *out, xjni_arena_t *arena);
+
+/**
+ * @brief Copy every object of an Object[] into an array of C structs.
+ *
+ * Null elements give zero-filled structs. At most a few local references
+ * are live at any time, whatever the array length.
+ *
+ * @param env JNI environment pointer
+ * @param marshal Compiled table
+ * @param objects Java array of objects of the compiled class
+ * @param out Destination, room for one struct per element
+ * @param arena Arena for String and array fields (may be NULL if there are none)
+ * @return JNI_OK on success, JNI_ERR on failure
+ */
+JNIEXPORT jint JNICALL xjni_MarshalObjectArray(JNIEnv *env, const xjni_marshal_t *marshal, jobjectArray objects, void *out, xjni_arena_t *arena);
+//@}
+
+/** @name Construction */
+//@{
+/**
+ * @brief Compile a descriptor table for building objects of a class.
+ *
+ * With @p constructor set, objects are created by the constructor whose
+ * parameters are the descriptor signatures in table order, and field names
+ * are not used. Otherwise they are created with AllocObject (no
+ * constructor runs) and every field is set through its cached field ID.
+ *
+ * @param env JNI environment pointer
+ * @param cls Class of the objects (a global reference is kept)
+ * @param fields Descriptor table
+ * @param count Number of entries in @p fields
+ * @param structSize sizeof the C struct
+ * @param constructor JNI_TRUE to use the matching constructor
+ * @return Compiled table, or NULL if a field or the constructor is missing
+ */
+JNIEXPORT xjni_marshal_t* JNICALL xjni_MarshalCompileBuilder(JNIEnv *env, jclass cls, const xjni_field_t *fields, jsize count, size_t structSize, jboolean constructor);
+
+/**
+ * @brief Route xjni_BuildObjectArray() through one static Java factory call.
+ *
+ * The factory takes one array per descriptor entry, in table order: `T[]`
+ * for primitives, `String[]` for strings and `T[][]` for array members. It
+ * returns the built array, `Object[]` unless @p returnSig says otherwise.
+ *
+ * @param env JNI environment pointer
+ * @param marshal Compiled table
+ * @param fields Descriptor table @p marshal was compiled from
+ * @param factoryCls Class declaring the factory (a global reference is kept)
+ * @param name Static method name
+ * @param returnSig Return type signature, or NULL for "[Ljava/lang/Object;"
+ * @return JNI_OK on success, JNI_ERR if the method is missing (NoSuchMethodError pending)
+ */
+JNIEXPORT jint JNICALL xjni_MarshalSetFactory(JNIEnv *env, xjni_marshal_t *marshal, const xjni_field_t *fields, jclass factoryCls, const char *name, const char *returnSig);
+
+/**
+ * @brief Build one Java object from a C struct.
+ * @param env JNI environment pointer
+ * @param marshal Table from xjni_MarshalCompileBuilder()
+ * @param in Source struct
+ * @return New object (local reference), or NULL on failure
+ */
+JNIEXPORT jobject JNICALL xjni_BuildObject(JNIEnv *env, const xjni_marshal_t *marshal, const void *in);
+
+/**
+ * @brief Build an array of Java objects from an array of C structs.
+ *
+ * Uses the factory when one is set. Otherwise the objects are created one by
+ * one into an array of the compiled class; at most a few hundred local
+ * references are live at any time, whatever the count.
+ *
+ * @param env JNI environment pointer
+ * @param marshal Table from xjni_MarshalCompileBuilder()
+ * @param in Source structs
+ * @param count Number of structs
+ * @return New array (local reference), or NULL on failure
+ */
+JNIEXPORT jobjectArray JNICALL xjni_BuildObjectArray(JNIEnv *env, const xjni_marshal_t *marshal, const void *in, jsize count);
+//@}
+
+/** @} */ // end of JNI_Marshal group
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __XJNI_MARSHAL_H__ */
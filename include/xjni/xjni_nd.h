@@ -0,0 +1,203 @@
+/**
+ * @file xjni_nd.h
+ * @brief Extern JNI N-Dimensional Array Utility
+ *
+ * Provides a generic engine for Java primitive arrays of any rank
+ * (`float[][][]`, `double[][][][]`, ...). Nested arrays are walked with
+ * a bounded number of local references, their shape is computed (ragged
+ * arrays are detected) and their contents are exported to / imported from
+ * one contiguous row-major native buffer.
+ *
+ * @author MrR736
+ * @date 2026
+ * @copyright GPL-3
+ */
+
+#ifndef __XJNI_ND_H__
+#define __XJNI_ND_H__
+
+#include <stddef.h>
+#include <jni.h>
+
+/** Maximum rank supported by the N-D engine (the JVM limit for array dimensions) */
+#define XJNI_ND_MAX_RANK 255
+
+/** @enum xjni_ElementType
+ *  @brief Java primitive element types, valued by their JNI signature character
+ */
+typedef enum xjni_ElementType {
+	XJNI_TYPE_BOOLEAN = 'Z', /**< jboolean */
+	XJNI_TYPE_BYTE = 'B',    /**< jbyte */
+	XJNI_TYPE_CHAR = 'C',    /**< jchar */
+	XJNI_TYPE_SHORT = 'S',   /**< jshort */
+	XJNI_TYPE_INT = 'I',     /**< jint */
+	XJNI_TYPE_LONG = 'J',    /**< jlong */
+	XJNI_TYPE_FLOAT = 'F',   /**< jfloat */
+	XJNI_TYPE_DOUBLE = 'D',  /**< jdouble */
+} xjni_ElementType;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup JNI_NDArray Java N-Dimensional Array Utilities
+ *  Functions to create, inspect, export and import Java arrays of any rank.
+ *  @{
+ */
+
+/** @name Primitive Array Dispatch */
+//@{
+/**
+ * @brief Size in bytes of one element of the given type
+ * @param type Element type
+ * @return Element size, or 0 for an unknown type
+ */
+JNIEXPORT size_t JNICALL xjni_ElementSize(xjni_ElementType type);
+
+/**
+ * @brief Create a one-dimensional primitive array of the given type
+ * @param env JNI environment pointer
+ * @param type Element type
+ * @param len Number of elements
+ * @return New primitive array, or NULL on failure
+ */
+JNIEXPORT jarray JNICALL NewPrimitiveArray(JNIEnv *env, xjni_ElementType type, jsize len);
+
+/**
+ * @brief Copy a region of a primitive array of the given type into a native buffer
+ * @param env JNI environment pointer
+ * @param type Element type of @p array
+ * @param array Java primitive array
+ * @param start Starting index
+ * @param len Number of elements
+ * @param buf Destination buffer of @p len elements
+ */
+JNIEXPORT void JNICALL GetPrimitiveArrayRegion(JNIEnv *env, xjni_ElementType type, jarray array, jsize start, jsize len, void *buf);
+
+/**
+ * @brief Copy a native buffer into a region of a primitive array of the given type
+ * @param env JNI environment pointer
+ * @param type Element type of @p array
+ * @param array Java primitive array
+ * @param start Starting index
+ * @param len Number of elements
+ * @param buf Source buffer of @p len elements
+ */
+JNIEXPORT void JNICALL SetPrimitiveArrayRegion(JNIEnv *env, xjni_ElementType type, jarray array, jsize start, jsize len, const void *buf);
+//@}
+
+/** @name Shape Utility */
+//@{
+/**
+ * @brief Compute the shape of a nested Java array of the given rank
+ *
+ * Every sub-array is visited, so a ragged array (rows of different lengths)
+ * or a NULL sub-array is reported as an error.
+ *
+ * @param env JNI environment pointer
+ * @param array Outer Java array (`T[]`, `T[][]`, ...)
+ * @param rank Number of dimensions of @p array (1..XJNI_ND_MAX_RANK)
+ * @param shape Output, receives @p rank dimension lengths
+ * @return JNI_OK if the array is rectangular, JNI_ERR otherwise
+ */
+JNIEXPORT jint JNICALL GetNDArrayShape(JNIEnv *env, jarray array, jint rank, jsize *shape);
+
+/**
+ * @brief Number of elements described by a shape
+ * @param rank Number of dimensions
+ * @param shape Dimension lengths
+ * @return Product of all dimensions, or 0 on overflow
+ */
+JNIEXPORT size_t JNICALL GetNDArrayCount(jint rank, const jsize *shape);
+
+/**
+ * @brief Compute packed row-major strides (in elements) for a shape
+ * @param rank Number of dimensions
+ * @param shape Dimension lengths
+ * @param strides Output, receives @p rank strides; the last one is 1
+ */
+JNIEXPORT void JNICALL GetNDArrayStrides(jint rank, const jsize *shape, size_t *strides);
+//@}
+
+/** @name Generic N-D Array Transfer */
+//@{
+/**
+ * @brief Export a nested Java array into one contiguous native buffer
+ * @param env JNI environment pointer
+ * @param array Outer Java array
+ * @param type Element type of the innermost arrays
+ * @param rank Number of dimensions
+ * @param shape Expected shape (see GetNDArrayShape())
+ * @param strides Element strides of @p buf per dimension, or NULL for packed row-major
+ * @param buf Destination buffer
+ * @return JNI_OK on success, JNI_ERR if the array does not match @p shape
+ */
+JNIEXPORT jint JNICALL GetNDArrayRegion(JNIEnv *env, jarray array, xjni_ElementType type, jint rank, const jsize *shape, const size_t *strides, void *buf);
+
+/**
+ * @brief Import one contiguous native buffer into an existing nested Java array
+ * @param env JNI environment pointer
+ * @param array Outer Java array
+ * @param type Element type of the innermost arrays
+ * @param rank Number of dimensions
+ * @param shape Expected shape (see GetNDArrayShape())
+ * @param strides Element strides of @p buf per dimension, or NULL for packed row-major
+ * @param buf Source buffer
+ * @return JNI_OK on success, JNI_ERR if the array does not match @p shape
+ */
+JNIEXPORT jint JNICALL SetNDArrayRegion(JNIEnv *env, jarray array, xjni_ElementType type, jint rank, const jsize *shape, const size_t *strides, const void *buf);
+
+/**
+ * @brief Create a nested Java array of the given shape
+ * @param env JNI environment pointer
+ * @param type Element type of the innermost arrays
+ * @param rank Number of dimensions
+ * @param shape Dimension lengths
+ * @param data Optional packed row-major contents (may be NULL)
+ * @return New Java array (`T[]` for rank 1, `T[][]...` otherwise), or NULL on failure
+ */
+JNIEXPORT jarray JNICALL NewNDArray(JNIEnv *env, xjni_ElementType type, jint rank, const jsize *shape, const void *data);
+//@}
+
+/** @name Typed N-D Array Utility (packed row-major) */
+//@{
+JNIEXPORT jarray JNICALL NewBooleanNDArray(JNIEnv *env, jint rank, const jsize *shape, const jboolean *data);
+JNIEXPORT jint JNICALL GetBooleanNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jboolean *buf);
+JNIEXPORT jint JNICALL SetBooleanNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jboolean *buf);
+
+JNIEXPORT jarray JNICALL NewByteNDArray(JNIEnv *env, jint rank, const jsize *shape, const jbyte *data);
+JNIEXPORT jint JNICALL GetByteNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jbyte *buf);
+JNIEXPORT jint JNICALL SetByteNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jbyte *buf);
+
+JNIEXPORT jarray JNICALL NewCharNDArray(JNIEnv *env, jint rank, const jsize *shape, const jchar *data);
+JNIEXPORT jint JNICALL GetCharNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jchar *buf);
+JNIEXPORT jint JNICALL SetCharNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jchar *buf);
+
+JNIEXPORT jarray JNICALL NewShortNDArray(JNIEnv *env, jint rank, const jsize *shape, const jshort *data);
+JNIEXPORT jint JNICALL GetShortNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jshort *buf);
+JNIEXPORT jint JNICALL SetShortNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jshort *buf);
+
+JNIEXPORT jarray JNICALL NewIntNDArray(JNIEnv *env, jint rank, const jsize *shape, const jint *data);
+JNIEXPORT jint JNICALL GetIntNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jint *buf);
+JNIEXPORT jint JNICALL SetIntNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jint *buf);
+
+JNIEXPORT jarray JNICALL NewLongNDArray(JNIEnv *env, jint rank, const jsize *shape, const jlong *data);
+JNIEXPORT jint JNICALL GetLongNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jlong *buf);
+JNIEXPORT jint JNICALL SetLongNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jlong *buf);
+
+JNIEXPORT jarray JNICALL NewFloatNDArray(JNIEnv *env, jint rank, const jsize *shape, const jfloat *data);
+JNIEXPORT jint JNICALL GetFloatNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jfloat *buf);
+JNIEXPORT jint JNICALL SetFloatNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jfloat *buf);
+
+JNIEXPORT jarray JNICALL NewDoubleNDArray(JNIEnv *env, jint rank, const jsize *shape, const jdouble *data);
+JNIEXPORT jint JNICALL GetDoubleNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, jdouble *buf);
+JNIEXPORT jint JNICALL SetDoubleNDArrayRegion(JNIEnv *env, jarray array, jint rank, const jsize *shape, const jdouble *buf);
+//@}
+
+/** @} */ // end of JNI_NDArray group
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __XJNI_ND_H__ */
@@ -2,7 +2,8 @@
  * @file xjni_new.h
  * @brief Extern JNI "New" Utility - Create Java objects and arrays from native code
  *
- * Provides functions to create Java arrays and objects from C/C++ native data.
+ * Provides functions to create Java arrays and objects from C/C++ native data,
+ * and to call Java methods with native arguments.
  *
  * @author MrR736
  * @date 2025
@@ -117,6 +118,90 @@ JNIEXPORT jobject JNICALL NewObjectBuilder(JNIEnv* env, const char* className, c
 
 /** @} */
 
+/** @defgroup XJNI_Call JNI Method Invocation
+ *  @brief Call Java methods by class name, method name and signature
+ *
+ *  The method ID and a global reference to its class are resolved once and
+ *  kept in a table keyed by class name, method name, signature and kind, so
+ *  repeated calls make no lookups. The variadic and `va_list` forms read the
+ *  arguments described by @p sig (with the default argument promotions:
+ *  `int` for boolean, byte, char and short, `double` for float) into a
+ *  `jvalue` array on the stack and invoke `Call<Type>MethodA` /
+ *  `CallStatic<Type>MethodA`; no argument is boxed. The `A` forms take the
+ *  `jvalue` array directly. A missing class or method returns zero / NULL
+ *  with the Java exception pending.
+ *
+ *  @param env JNI environment pointer
+ *  @param obj Receiver (instance methods)
+ *  @param className Fully qualified Java class name declaring the method
+ *  @param name Method name
+ *  @param sig Method signature
+ *  @{
+ */
+JNIEXPORT jobject JNICALL CallObjectMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jobject JNICALL CallObjectMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jobject JNICALL CallObjectMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jboolean JNICALL CallBooleanMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jboolean JNICALL CallBooleanMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jboolean JNICALL CallBooleanMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jbyte JNICALL CallByteMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jbyte JNICALL CallByteMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jbyte JNICALL CallByteMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jchar JNICALL CallCharMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jchar JNICALL CallCharMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jchar JNICALL CallCharMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jshort JNICALL CallShortMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jshort JNICALL CallShortMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jshort JNICALL CallShortMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jint JNICALL CallIntMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jint JNICALL CallIntMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jint JNICALL CallIntMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jlong JNICALL CallLongMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jlong JNICALL CallLongMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jlong JNICALL CallLongMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jfloat JNICALL CallFloatMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jfloat JNICALL CallFloatMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jfloat JNICALL CallFloatMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jdouble JNICALL CallDoubleMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jdouble JNICALL CallDoubleMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jdouble JNICALL CallDoubleMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT void JNICALL CallVoidMethodBuilder(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT void JNICALL CallVoidMethodBuilderV(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT void JNICALL CallVoidMethodBuilderA(JNIEnv* env, jobject obj, const char* className, const char* name, const char* sig, const jvalue* args);
+
+JNIEXPORT jobject JNICALL CallStaticObjectMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jobject JNICALL CallStaticObjectMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jobject JNICALL CallStaticObjectMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jboolean JNICALL CallStaticBooleanMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jboolean JNICALL CallStaticBooleanMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jboolean JNICALL CallStaticBooleanMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jbyte JNICALL CallStaticByteMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jbyte JNICALL CallStaticByteMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jbyte JNICALL CallStaticByteMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jchar JNICALL CallStaticCharMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jchar JNICALL CallStaticCharMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jchar JNICALL CallStaticCharMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jshort JNICALL CallStaticShortMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jshort JNICALL CallStaticShortMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jshort JNICALL CallStaticShortMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jint JNICALL CallStaticIntMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jint JNICALL CallStaticIntMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jint JNICALL CallStaticIntMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jlong JNICALL CallStaticLongMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jlong JNICALL CallStaticLongMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jlong JNICALL CallStaticLongMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jfloat JNICALL CallStaticFloatMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jfloat JNICALL CallStaticFloatMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jfloat JNICALL CallStaticFloatMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT jdouble JNICALL CallStaticDoubleMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT jdouble JNICALL CallStaticDoubleMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT jdouble JNICALL CallStaticDoubleMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+JNIEXPORT void JNICALL CallStaticVoidMethodBuilder(JNIEnv* env, const char* className, const char* name, const char* sig, ...);
+JNIEXPORT void JNICALL CallStaticVoidMethodBuilderV(JNIEnv* env, const char* className, const char* name, const char* sig, va_list ap);
+JNIEXPORT void JNICALL CallStaticVoidMethodBuilderA(JNIEnv* env, const char* className, const char* name, const char* sig, const jvalue* args);
+
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,107 @@
+/**
+ * @file xjni_pool.h
+ * @brief Extern JNI Worker Pool Utility
+ *
+ * Provides a pool of native threads that are attached to the JVM once, at
+ * creation time, and reused for data-parallel JNI work. Every worker owns
+ * its own JNIEnv; objects shared with the workers must be passed as global
+ * references.
+ *
+ * @author MrR736
+ * @date 2026
+ * @copyright GPL-3
+ */
+
+#ifndef __XJNI_POOL_H__
+#define __XJNI_POOL_H__
+
+#include <stddef.h>
+#include <jni.h>
+
+/**
+ * Default number of elements below which parallel transfers stay on the
+ * calling thread. Can be overridden at build time or with
+ * xjni_SetParallelThreshold().
+ */
+#ifndef XJNI_PARALLEL_THRESHOLD
+#define XJNI_PARALLEL_THRESHOLD (1 << 18)
+#endif
+
+/** @brief Opaque pool of JVM-attached worker threads */
+typedef struct xjni_pool xjni_pool_t;
+
+/**
+ * @brief Task run by the pool over a sub-range of [0, count)
+ * @param env JNI environment of the executing thread
+ * @param arg User argument given to xjni_pool_run()
+ * @param begin First index of the range
+ * @param end One past the last index of the range
+ * @return JNI_OK on success, any other value aborts the run
+ */
+typedef jint (*xjni_pool_task)(JNIEnv *env, void *arg, jsize begin, jsize end);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup JNI_Pool Java Worker Pool Utilities
+ *  Functions to create and use a pool of JVM-attached worker threads.
+ *  @{
+ */
+
+/**
+ * @brief Create a worker pool; every worker is attached to @p vm as a daemon thread
+ * @param vm Java virtual machine
+ * @param threads Number of workers, or <= 0 for one per online CPU minus the caller
+ * @return New pool, or NULL on failure
+ */
+JNIEXPORT xjni_pool_t* JNICALL xjni_pool_new(JavaVM *vm, int threads);
+
+/**
+ * @brief Stop, detach and join every worker, then free the pool
+ * @param pool Pool to free (may be NULL)
+ */
+JNIEXPORT void JNICALL xjni_pool_free(xjni_pool_t *pool);
+
+/**
+ * @brief Number of worker threads of a pool
+ * @param pool Worker pool
+ * @return Worker count (the caller thread is not included)
+ */
+JNIEXPORT int JNICALL xjni_pool_size(const xjni_pool_t *pool);
+
+/**
+ * @brief Run @p task over [0, @p count) split across the workers and the calling thread
+ *
+ * Blocks until every chunk has been processed. Runs on the same pool are
+ * serialized. An exception raised on a worker thread is cleared there and
+ * reported as a failed run.
+ *
+ * @param pool Worker pool
+ * @param env JNI environment of the calling thread
+ * @param count Number of indices to process
+ * @param task Task to run
+ * @param arg User argument passed to @p task
+ * @return JNI_OK if every chunk succeeded, JNI_ERR otherwise
+ */
+JNIEXPORT jint JNICALL xjni_pool_run(xjni_pool_t *pool, JNIEnv *env, jsize count, xjni_pool_task task, void *arg);
+
+/**
+ * @brief Set the element count below which parallel transfers stay single-threaded
+ * @param elements New threshold (0 always uses the pool)
+ */
+JNIEXPORT void JNICALL xjni_SetParallelThreshold(size_t elements);
+
+/**
+ * @brief Current parallel transfer threshold
+ * @return Threshold in elements
+ */
+JNIEXPORT size_t JNICALL xjni_GetParallelThreshold(void);
+
+/** @} */ // end of JNI_Pool group
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __XJNI_POOL_H__ */
@@ -5,6 +5,12 @@
  * Provides printf-like functions for `jchar` strings in native code.
  * Supports standard output, file streams, file descriptors, and buffers.
  *
+ * Formats follow C printf. `%s` and `%c` take UTF-8 strings and bytes;
+ * `%ls` / `%S` and `%lc` / `%C` take `jchar` strings and characters, with
+ * width and precision counted in `jchar` units. The buffer functions write
+ * UTF-16 directly, in one pass and without heap allocations; the stream and
+ * descriptor functions write UTF-8.
+ *
  * @author MrR736
  * @date 2025
  * @copyright GPL-3
@@ -47,10 +53,11 @@ JNIEXPORT int JNICALL sjprintf(jchar* s, const jchar* format, ...);
 /**
  * @brief Write formatted output to a `jchar` buffer with maximum length using `va_list`
  * @param s Destination buffer
- * @param maxlen Maximum number of characters to write
+ * @param maxlen Maximum number of characters to write, null terminator included
  * @param format Format string (`jchar*`)
  * @param arg Variable argument list
- * @return Number of characters written (excluding null terminator)
+ * @return Number of characters written (excluding null terminator), or -1 if
+ *         the output did not fit (the buffer then holds it truncated)
  */
 JNIEXPORT int JNICALL vsnjprintf(jchar* s, size_t maxlen, const jchar* format, va_list arg);
 
@@ -116,6 +123,52 @@ JNIEXPORT int JNICALL vjprintf(const jchar* format, va_list arg);
  */
 JNIEXPORT int JNICALL jprintf(const jchar* format, ...);
 
+/**
+ * @brief Format into a new Java string using `va_list`
+ *
+ * The output is written as UTF-16 to per-thread scratch (the heap only when
+ * it outgrows it) and the string is created with one `NewString` call.
+ *
+ * @param env JNI environment pointer
+ * @param format Format string (UTF-8)
+ * @param arg Variable argument list
+ * @return New string (local reference), or NULL on failure
+ */
+JNIEXPORT jstring JNICALL xjni_FormatToJStringV(JNIEnv* env, const char* format, va_list arg);
+
+/**
+ * @brief Format into a new Java string
+ * @param env JNI environment pointer
+ * @param format Format string (UTF-8)
+ * @param ... Variable arguments
+ * @return New string (local reference), or NULL on failure
+ */
+JNIEXPORT jstring JNICALL xjni_FormatToJString(JNIEnv* env, const char* format, ...);
+
+/**
+ * @brief Format and append to a `java.lang.StringBuilder` using `va_list`
+ *
+ * Formatted like xjni_FormatToJStringV(), then appended with one
+ * `append(char[], int, int)` call.
+ *
+ * @param env JNI environment pointer
+ * @param sb StringBuilder to append to
+ * @param format Format string (UTF-8)
+ * @param arg Variable argument list
+ * @return Number of characters appended, or -1 on failure
+ */
+JNIEXPORT jint JNICALL xjni_FormatAppendV(JNIEnv* env, jobject sb, const char* format, va_list arg);
+
+/**
+ * @brief Format and append to a `java.lang.StringBuilder`
+ * @param env JNI environment pointer
+ * @param sb StringBuilder to append to
+ * @param format Format string (UTF-8)
+ * @param ... Variable arguments
+ * @return Number of characters appended, or -1 on failure
+ */
+JNIEXPORT jint JNICALL xjni_FormatAppend(JNIEnv* env, jobject sb, const char* format, ...);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -12,7 +12,97 @@
 #ifndef __XJNI_STRINGARRAY_H__
 #define __XJNI_STRINGARRAY_H__
 
+#include <stddef.h>
 #include <jni.h>
+#include <xjni_pool.h>
+
+/**
+ * Default element count from which the xjni_*Packed functions switch from
+ * per-element JNI calls to a single call into the xjni.XJNIStrings runtime
+ * class. Can be overridden at build time or with
+ * xjni_SetStringArrayPackedThreshold().
+ */
+#ifndef XJNI_STRINGS_PACKED_THRESHOLD
+#define XJNI_STRINGS_PACKED_THRESHOLD 32
+#endif
+
+/**
+ * Number of distinct values the deduplicating constructors remember per call;
+ * further new values are still created, just not shared.
+ */
+#ifndef XJNI_DEDUP_MAX_DISTINCT
+#define XJNI_DEDUP_MAX_DISTINCT 65536
+#endif
+
+/**
+ * @brief Packed UTF-8 copy of a Java String[]
+ *
+ * Everything lives in one heap block: this header, the offsets, lengths and
+ * null flags tables, and the string data. Element @c i starts at
+ * @c data + @c offsets[i], is @c lengths[i] bytes long and is followed by a
+ * NUL; null elements have length 0 and their @c nulls flag set.
+ */
+typedef struct jutf8packed_t {
+	jsize count;            /**< Number of elements */
+	size_t size;            /**< Bytes used in @c data, terminating NULs included */
+	const size_t *offsets;  /**< Byte offset of every element in @c data */
+	const jsize *lengths;   /**< UTF-8 byte length of every element, without the NUL */
+	const jboolean *nulls;  /**< JNI_TRUE where the Java element is null */
+	const char *data;       /**< Contiguous NUL-terminated UTF-8 strings */
+} jutf8packed_t;
+
+/** @brief Read-only view of the UTF-16 units of one string */
+typedef struct jspan_t {
+	const jchar *data;  /**< First unit, NULL for a null element */
+	jsize length;       /**< Number of units (not NUL-terminated) */
+} jspan_t;
+
+/**
+ * @brief UTF-16 views of every element of a Java String[]
+ *
+ * Returned by xjni_GetStringArrayPacked(). When @c array is set the views
+ * point into a pinned Java char[]; otherwise they point into native memory
+ * owned by the same block.
+ */
+typedef struct jstringspans_t {
+	jsize count;          /**< Number of elements */
+	const jspan_t *spans; /**< One view per element */
+	jcharArray array;     /**< Pinned backing array (local reference), or NULL */
+	jchar *pinned;        /**< Critical pointer into @c array */
+} jstringspans_t;
+
+/**
+ * @brief Characters of a Java String[] or String[][] together with their jstrings
+ *
+ * Returned by the Get*ArrayHandle() functions. The handle keeps the
+ * reference of every string next to its characters, so
+ * ReleaseStringArrayHandle() never reads the Java array again. Only one of
+ * @c utf / @c chars (and @c utf2d / @c chars2d) is set, depending on
+ * @c unicode.
+ */
+typedef struct jstringarray_t {
+	jsize count;            /**< Strings held: elements of a String[], all cells of a String[][] */
+	jsize rows;             /**< Rows of a String[][], 0 for a String[] */
+	const char **utf;       /**< Modified UTF-8 chars of every string, NULL entries for null elements */
+	const jchar **chars;    /**< UTF-16 chars of every string (not NUL-terminated) */
+	const char ***utf2d;    /**< Row pointers into @c utf, NULL for null rows */
+	const jchar ***chars2d; /**< Row pointers into @c chars, NULL for null rows */
+	jsize *cols;            /**< Length of every row */
+	jstring *refs;          /**< References to the strings (global if @c global), NULL for null elements */
+	jsize capacity;         /**< Internal: allocated entries */
+	jboolean unicode;       /**< JNI_TRUE for UTF-16 handles */
+	jboolean global;        /**< JNI_TRUE if @c refs are global references */
+} jstringarray_t;
+
+/**
+ * @brief Element of a packed UTF-8 array.
+ * @param packed Packed array.
+ * @param index Element index.
+ * @return NUL-terminated UTF-8 string, or NULL for a null element.
+ */
+static inline const char *jutf8packed_at(const jutf8packed_t *packed, jsize index) {
+	return packed->nulls[index] ? NULL : packed->data + packed->offsets[index];
+}
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +113,42 @@ extern "C" {
  *  @{
  */
 
+/** @name Class Cache */
+//@{
+/**
+ * @brief Cached global reference to java.lang.String.
+ *
+ * Resolved by XJNI_StringArray_OnLoad(), or lazily on first use. Do not delete it.
+ * @param env Pointer to the JNI environment.
+ * @return Global class reference, or NULL if the class could not be found.
+ */
+JNIEXPORT jclass JNICALL xjni_GetStringClass(JNIEnv *env);
+
+/**
+ * @brief Cached global reference to java.lang.String[].
+ * @param env Pointer to the JNI environment.
+ * @return Global class reference, or NULL if the class could not be found.
+ */
+JNIEXPORT jclass JNICALL xjni_GetStringArrayClass(JNIEnv *env);
+
+/**
+ * @brief Called when the String array module is loaded; resolves the class cache.
+ * @param vm JavaVM pointer
+ * @param reserved Reserved pointer (JNI spec)
+ * @param ver JNI version
+ * @return @p ver on success, JNI_ERR otherwise
+ */
+JNIEXPORT jint JNICALL XJNI_StringArray_OnLoad(JavaVM* vm, void* reserved, jint ver);
+
+/**
+ * @brief Called when the String array module is unloaded; drops the class cache.
+ * @param vm JavaVM pointer
+ * @param reserved Reserved pointer (JNI spec)
+ * @param ver JNI version
+ */
+JNIEXPORT void JNICALL XJNI_StringArray_OnUnload(JavaVM* vm, void* reserved, jint ver);
+//@}
+
 /** @name UTF-8 String Array Operations */
 //@{
 /**
@@ -79,6 +205,45 @@ JNIEXPORT void JNICALL SetStringUTFArrayRegion(JNIEnv *env, jobjectArray array,
  * @return Number of elements in the array.
  */
 JNIEXPORT jsize JNICALL GetStringUTFArrayLength(JNIEnv *env, jobjectArray str);
+
+/**
+ * @brief Copy a whole Java String[] into one packed UTF-8 block.
+ *
+ * Each element is transcoded to standard UTF-8 (not modified UTF-8) while it
+ * is pinned, then released right away, so no JVM resource is held once the
+ * call returns. Unpaired surrogates are replaced by U+FFFD.
+ *
+ * @param env Pointer to the JNI environment.
+ * @param array Java String[] object.
+ * @return Packed copy, or NULL on failure. Free with ReleaseStringUTF8ArrayPacked().
+ */
+JNIEXPORT jutf8packed_t* JNICALL GetStringUTF8ArrayPacked(JNIEnv *env, jobjectArray array);
+
+/**
+ * @brief Free a block returned by GetStringUTF8ArrayPacked.
+ * @param packed Packed array (may be NULL).
+ */
+JNIEXPORT void JNICALL ReleaseStringUTF8ArrayPacked(jutf8packed_t *packed);
+
+/**
+ * @brief Create a Java String[] from packed standard UTF-8 data.
+ *
+ * Element @c i is the @c lengths[i] bytes at @c data + @c offsets[i]; when
+ * @p lengths is NULL, @p offsets holds @p count + 1 entries and element @c i
+ * ends where element @c i + 1 starts (Arrow-style columnar layout). The
+ * bytes need not be NUL-terminated. Each element is transcoded to UTF-16
+ * natively, so supplementary characters are kept and malformed sequences
+ * become U+FFFD. A jutf8packed_t can be passed back directly.
+ *
+ * @param env Pointer to the JNI environment.
+ * @param data UTF-8 bytes of all elements.
+ * @param offsets Byte offset of every element in @p data.
+ * @param lengths Byte length of every element, or NULL (see above).
+ * @param count Number of elements.
+ * @param nulls Optional flags; elements flagged JNI_TRUE stay null.
+ * @return Java String[] object, or NULL on failure.
+ */
+JNIEXPORT jobjectArray JNICALL NewStringUTF8ArrayPacked(JNIEnv *env, const char *data, const size_t *offsets, const jsize *lengths, jsize count, const jboolean *nulls);
 //@}
 
 /** @name Unicode (jchar) String Array Operations */
@@ -93,6 +258,23 @@ JNIEXPORT jsize JNICALL GetStringUTFArrayLength(JNIEnv *env, jobjectArray str);
  */
 JNIEXPORT jobjectArray JNICALL NewStringArray(JNIEnv *env, const jchar **unicode, jsize len, jsize n);
 
+/**
+ * @brief Create a Java String[] from packed, already transcoded UTF-16 data.
+ *
+ * Same layout as NewStringUTF8ArrayPacked(), with offsets and lengths
+ * counted in jchar units. Every element goes straight to NewString without
+ * any copy or validation.
+ *
+ * @param env Pointer to the JNI environment.
+ * @param data UTF-16 units of all elements.
+ * @param offsets Unit offset of every element in @p data.
+ * @param lengths Unit length of every element, or NULL for @p count + 1 offsets.
+ * @param count Number of elements.
+ * @param nulls Optional flags; elements flagged JNI_TRUE stay null.
+ * @return Java String[] object, or NULL on failure.
+ */
+JNIEXPORT jobjectArray JNICALL NewStringArrayPacked(JNIEnv *env, const jchar *data, const size_t *offsets, const jsize *lengths, jsize count, const jboolean *nulls);
+
 /**
  * @brief Get the length of a Java String[] array.
  * @param env Pointer to the JNI environment.
@@ -139,6 +321,197 @@ JNIEXPORT void JNICALL GetStringArrayRegion(JNIEnv *env, jobjectArray str, jsize
 JNIEXPORT void JNICALL SetStringArrayRegion(JNIEnv *env, jobjectArray array, jsize start, jsize len, const jchar **buf);
 //@}
 
+/** @name Deduplicating String Array Construction
+ *  Equal UTF-8 values within one call share a single jstring, so repeated
+ *  values (status codes, country names...) cost one NewStringUTF and one
+ *  Java object each. With @p intern, every distinct value also goes through
+ *  String.intern(), sharing it with other calls and with Java literals.
+ */
+//@{
+/**
+ * @brief Create a Java String[] from UTF-8 C strings, sharing equal values.
+ * @param env Pointer to the JNI environment.
+ * @param utf Array of UTF-8 C strings (NULL entries stay null).
+ * @param count Number of elements in the array.
+ * @param intern JNI_TRUE to intern every distinct value.
+ * @return Java String[] object, or NULL on failure.
+ */
+JNIEXPORT jobjectArray JNICALL NewStringUTFArrayDedup(JNIEnv *env, const char **utf, jsize count, jboolean intern);
+
+/**
+ * @brief Create a Java String[][] from UTF-8 C strings, sharing equal values across all cells.
+ * @param env Pointer to the JNI environment.
+ * @param utf Rows of UTF-8 C strings (NULL rows and cells stay null).
+ * @param row Number of rows.
+ * @param col Number of columns.
+ * @param intern JNI_TRUE to intern every distinct value.
+ * @return Java String[][] object, or NULL on failure.
+ */
+JNIEXPORT jobjectArray JNICALL NewStringUTF2DArrayDedup(JNIEnv *env, const char ***utf, jsize row, jsize col, jboolean intern);
+//@}
+
+/** @name Retained String Array Handles
+ *  Get functions that keep every jstring they touch, so the matching release
+ *  only releases the chars and drops the reference, without reading any
+ *  array. With @p global JNI_FALSE the handle keeps the local reference of
+ *  every string, reserving local capacity one chunk at a time: a round trip
+ *  costs four JNI calls per string instead of six, and the handle must be
+ *  released before the native method returns (in any order, local
+ *  references the caller creates meanwhile are left alone). With @p global
+ *  JNI_TRUE each string gets a global reference instead, which brings the
+ *  round trip back to six calls per string but lets the handle outlive the
+ *  call.
+ */
+//@{
+/**
+ * @brief Retain the modified UTF-8 chars of every element of a String[].
+ * @param env Pointer to the JNI environment.
+ * @param array Java String[] object.
+ * @param global JNI_TRUE to keep global references instead of local ones.
+ * @param isCopy Optional output, JNI_TRUE if any element was copied.
+ * @return Handle, or NULL on failure. Release with ReleaseStringArrayHandle().
+ */
+JNIEXPORT jstringarray_t* JNICALL GetStringUTFArrayHandle(JNIEnv *env, jobjectArray array, jboolean global, jboolean *isCopy);
+
+/**
+ * @brief Retain the UTF-16 chars of every element of a String[].
+ * @param env Pointer to the JNI environment.
+ * @param array Java String[] object.
+ * @param global JNI_TRUE to keep global references instead of local ones.
+ * @param isCopy Optional output, JNI_TRUE if any element was copied.
+ * @return Handle, or NULL on failure. Release with ReleaseStringArrayHandle().
+ */
+JNIEXPORT jstringarray_t* JNICALL GetStringArrayHandle(JNIEnv *env, jobjectArray array, jboolean global, jboolean *isCopy);
+
+/**
+ * @brief Retain the modified UTF-8 chars of every cell of a String[][].
+ * @param env Pointer to the JNI environment.
+ * @param array Java String[][] object.
+ * @param global JNI_TRUE to keep global references instead of local ones.
+ * @param isCopy Optional output, JNI_TRUE if any cell was copied.
+ * @return Handle with @c utf2d set, or NULL on failure. Release with ReleaseStringArrayHandle().
+ */
+JNIEXPORT jstringarray_t* JNICALL GetStringUTF2DArrayHandle(JNIEnv *env, jobjectArray array, jboolean global, jboolean *isCopy);
+
+/**
+ * @brief Retain the UTF-16 chars of every cell of a String[][].
+ * @param env Pointer to the JNI environment.
+ * @param array Java String[][] object.
+ * @param global JNI_TRUE to keep global references instead of local ones.
+ * @param isCopy Optional output, JNI_TRUE if any cell was copied.
+ * @return Handle with @c chars2d set, or NULL on failure. Release with ReleaseStringArrayHandle().
+ */
+JNIEXPORT jstringarray_t* JNICALL GetString2DArrayHandle(JNIEnv *env, jobjectArray array, jboolean global, jboolean *isCopy);
+
+/**
+ * @brief Release every string of a handle and free it.
+ * @param env Pointer to the JNI environment.
+ * @param handle Handle to release (may be NULL).
+ */
+JNIEXPORT void JNICALL ReleaseStringArrayHandle(JNIEnv *env, jstringarray_t *handle);
+//@}
+
+/** @name Bulk String Array Operations
+ *  These use the optional xjni.XJNIStrings class from the xjni runtime jar:
+ *  the characters of all elements move through one Java array and a single
+ *  upcall builds or flattens the String[]. When the class is not on the
+ *  class path, or the array is below the packed threshold, they fall back to
+ *  per-element JNI calls.
+ */
+//@{
+/**
+ * @brief Create a Java String[] from packed UTF-16 data with one upcall.
+ *
+ * Same arguments and result as NewStringArrayPacked().
+ *
+ * @param env Pointer to the JNI environment.
+ * @param data UTF-16 units of all elements.
+ * @param offsets Unit offset of every element in @p data.
+ * @param lengths Unit length of every element, or NULL for @p count + 1 offsets.
+ * @param count Number of elements.
+ * @param nulls Optional flags; elements flagged JNI_TRUE stay null.
+ * @return Java String[] object, or NULL on failure.
+ */
+JNIEXPORT jobjectArray JNICALL xjni_NewStringArrayPacked(JNIEnv *env, const jchar *data, const size_t *offsets, const jsize *lengths, jsize count, const jboolean *nulls);
+
+/**
+ * @brief Create a Java String[] from packed Latin-1 (ISO-8859-1) data with one upcall.
+ *
+ * Same layout as NewStringUTF8ArrayPacked(), every byte being one character.
+ * Well suited to ASCII columns, which Java stores compactly.
+ *
+ * @param env Pointer to the JNI environment.
+ * @param data Latin-1 bytes of all elements.
+ * @param offsets Byte offset of every element in @p data.
+ * @param lengths Byte length of every element, or NULL for @p count + 1 offsets.
+ * @param count Number of elements.
+ * @param nulls Optional flags; elements flagged JNI_TRUE stay null.
+ * @return Java String[] object, or NULL on failure.
+ */
+JNIEXPORT jobjectArray JNICALL xjni_NewStringLatin1ArrayPacked(JNIEnv *env, const char *data, const size_t *offsets, const jsize *lengths, jsize count, const jboolean *nulls);
+
+/**
+ * @brief Get UTF-16 views of every element of a Java String[].
+ *
+ * From the packed threshold on, XJNIStrings.concat copies all elements into
+ * one char[] with a single upcall, and that array is pinned with
+ * GetPrimitiveArrayCritical. The usual critical-section rules then apply
+ * until xjni_ReleaseStringArrayPacked(): no other JNI calls and no blocking
+ * on other Java threads. Below the threshold, or without the runtime jar,
+ * the elements are copied one by one into native memory and no JNI
+ * resource is held. Check @c array to know which path was taken.
+ *
+ * @param env Pointer to the JNI environment.
+ * @param array Java String[] object.
+ * @return Views of all elements, or NULL on failure. Release with xjni_ReleaseStringArrayPacked()
+ *         before the native method returns.
+ */
+JNIEXPORT jstringspans_t* JNICALL xjni_GetStringArrayPacked(JNIEnv *env, jobjectArray array);
+
+/**
+ * @brief Unpin and free views returned by xjni_GetStringArrayPacked.
+ * @param env Pointer to the JNI environment.
+ * @param spans Views to release (may be NULL).
+ */
+JNIEXPORT void JNICALL xjni_ReleaseStringArrayPacked(JNIEnv *env, jstringspans_t *spans);
+
+/**
+ * @brief Set the element count from which the bulk functions make a single upcall.
+ * @param count New threshold (0 always uses the upcall when available).
+ */
+JNIEXPORT void JNICALL xjni_SetStringArrayPackedThreshold(jsize count);
+
+/**
+ * @brief Current bulk upcall threshold.
+ * @return Threshold in elements.
+ */
+JNIEXPORT jsize JNICALL xjni_GetStringArrayPackedThreshold(void);
+//@}
+
+/** @name String Array Sorting */
+//@{
+/**
+ * @brief Sort a Java String[] natively, in String.compareTo order.
+ *
+ * The elements are exported with xjni_GetStringArrayPacked() and ordered by
+ * an MSD radix sort on their UTF-16 code units. The sort is stable and null
+ * elements come first. With a pool, from the parallel threshold on, the
+ * calling thread splits the input into buckets that the workers finish.
+ * Pinned elements are copied to native memory and unpinned before the pool
+ * is used, so no critical region is held while the workers run.
+ *
+ * @param env Pointer to the JNI environment.
+ * @param pool Worker pool, or NULL to sort on the calling thread.
+ * @param array Java String[] object.
+ * @param perm Receives the permutation: @p perm[k] is the input index of the
+ *             k-th element in sorted order. May be NULL when @p reorder is set.
+ * @param reorder JNI_TRUE to also reorder @p array in place; every element is
+ *                read and written once, by following the permutation's cycles.
+ * @return JNI_OK on success, JNI_ERR on failure.
+ */
+JNIEXPORT jint JNICALL xjni_SortStringArray(JNIEnv *env, xjni_pool_t *pool, jobjectArray array, jint *perm, jboolean reorder);
+//@}
+
 /** @} */ // end of JNI_StringArray group
 
 #ifdef __cplusplus
@@ -24,6 +24,14 @@ extern "C" {
 
 /** @defgroup XJNI_VA_Print VA List Printing
  *  @brief Functions to print formatted output using `jargs_t` arrays
+ *
+ *  Formats use the java.util.Formatter syntax. The %s %d %o %x %e %f %c %b
+ *  %n and %% conversions, with their flags, width, precision and argument
+ *  indexes, are formatted natively: the arguments are unboxed in one pass and
+ *  the text is written straight to the destination in UTF-8. Any other
+ *  conversion, the ',' and '(' flags, and arguments of other classes (floats
+ *  for %s, non-String objects) make the whole call go through String.format,
+ *  whose result is pinned and encoded to UTF-8 chunk by chunk on the stack.
  *  @{
  */
 
@@ -89,6 +97,25 @@ JNIEXPORT void JNICALL JPrintfUTF(JNIEnv *env, const char* format, jargs_t args)
 
 /** @} */
 
+/** @defgroup XJNI_VA_Print_Stage Staged VA List Printing
+ *  @brief The printing functions above taking a native `jargs_stage_t`
+ *
+ *  The stage is materialized into one `jargs_t` for the call and the array is
+ *  released afterwards; the stage itself is left unchanged.
+ *  @{
+ */
+JNIEXPORT void JNICALL JSnPrintfStage(JNIEnv *env, char* s, size_t maxlen, jstring format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JSnPrintfUTFStage(JNIEnv *env, char* s, size_t maxlen, const char* format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JSPrintfStage(JNIEnv *env, char* s, jstring format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JSPrintfUTFStage(JNIEnv *env, char* s, const char* format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JFPrintfStage(JNIEnv *env, FILE* fp, jstring format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JFPrintfUTFStage(JNIEnv *env, FILE* fp, const char* format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JDPrintfStage(JNIEnv *env, int fd, jstring format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JDPrintfUTFStage(JNIEnv *env, int fd, const char* format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JPrintfStage(JNIEnv *env, jstring format, const jargs_stage_t *stage);
+JNIEXPORT void JNICALL JPrintfUTFStage(JNIEnv *env, const char* format, const jargs_stage_t *stage);
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif
@@ -92,6 +92,19 @@
 #define inline __inline
 #endif
 
+/* Thread-local storage class */
+#ifndef XJNI_THREAD_LOCAL
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define XJNI_THREAD_LOCAL thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define XJNI_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define XJNI_THREAD_LOCAL __declspec(thread)
+#else
+#define XJNI_THREAD_LOCAL __thread
+#endif
+#endif
+
 #ifdef __cplusplus
 #define BASE_EXTERN_CXX extern "C++"
 #define BASE_EXTERN_C extern "C"
@@ -123,11 +136,14 @@
 #define _NewWeakGlobalRef(env,obj) BASEJNIC(NewWeakGlobalRef,env,obj)
 #define _DeleteWeakGlobalRef(env,ref) BASEJNIC(DeleteWeakGlobalRef,env,ref)
 #define _IsInstanceOf(env,obj,clazz) BASEJNIC(IsInstanceOf,env,obj,clazz)
+#define _IsSameObject(env,ref1,ref2) BASEJNIC(IsSameObject,env,ref1,ref2)
 #define _NewDirectByteBuffer(env,address,capacity) BASEJNIC(NewDirectByteBuffer,env,address,capacity)
 #define _GetDirectBufferAddress(env,buf) BASEJNIC(GetDirectBufferAddress,env,buf)
 #define _GetDirectBufferCapacity(env,buf) BASEJNIC(GetDirectBufferCapacity,env,buf)
 #define _GetObjectRefType(env,obj) BASEJNIC(GetObjectRefType,env,obj)
 #define _PushLocalFrame(env,i) BASEJNIC(PushLocalFrame,env,i)
+#define _PopLocalFrame(env,result) BASEJNIC(PopLocalFrame,env,result)
+#define _EnsureLocalCapacity(env,i) BASEJNIC(EnsureLocalCapacity,env,i)
 #define _GetPrimitiveArrayCritical(env,array,isCopy) BASEJNIC(GetPrimitiveArrayCritical,env,array,isCopy)
 #define _ReleasePrimitiveArrayCritical(env,array,carray,mode) BASEJNIC(ReleasePrimitiveArrayCritical,env,array,carray,mode)
 
@@ -136,21 +152,32 @@
 
 // Char
 #define _NewCharArray(env,len) BASEJNIC(NewCharArray,env,len)
+#define _GetCharArrayRegion(env,array,start,len,buf) BASEJNIC(GetCharArrayRegion,env,array,start,len,buf)
+#define _GetCharField(env,obj,fieldID) BASEJNIC(GetCharField,env,obj,fieldID)
+#define _SetCharField(env,obj,fieldID,val) BASEJNIC(SetCharField,env,obj,fieldID,val)
+#define _GetCharArrayElements(env,src,iscopy) BASEJNIC(GetCharArrayElements,env,src,iscopy)
+#define _ReleaseCharArrayElements(env,array,_c,mode) BASEJNIC(ReleaseCharArrayElements,env,array,_c,mode)
+#define _SetCharArrayRegion(env,array,start,len,buf) BASEJNIC(SetCharArrayRegion,env,array,start,len,buf)
 #define _CallCharMethod(env,ex,...) BASEJNIC(CallCharMethod,env,ex,__VA_ARGS__)
 #define _CallNonvirtualCharMethod(env,ex,clazz,...) BASEJNIC(CallNonvirtualCharMethod,env,ex,clazz,__VA_ARGS__)
 #define _CallStaticCharMethod(env,ex,...) BASEJNIC(CallStaticCharMethod,env,ex,__VA_ARGS__)
+#define _CallCharMethodA(env,ex,methodID,args) BASEJNIC(CallCharMethodA,env,ex,methodID,args)
+#define _CallStaticCharMethodA(env,ex,methodID,args) BASEJNIC(CallStaticCharMethodA,env,ex,methodID,args)
 
 // Void
 #define _CallVoidMethod(env,ex,...) BASEJNIC(CallVoidMethod,env,ex,__VA_ARGS__)
 #define _CallStaticVoidMethod(env,ex,...) BASEJNIC(CallStaticVoidMethod,env,ex,__VA_ARGS__)
+#define _CallVoidMethodA(env,ex,methodID,args) BASEJNIC(CallVoidMethodA,env,ex,methodID,args)
+#define _CallStaticVoidMethodA(env,ex,methodID,args) BASEJNIC(CallStaticVoidMethodA,env,ex,methodID,args)
 #define _CallNonvirtualVoidMethod(env,ex,clazz,...) BASEJNIC(CallNonvirtualVoidMethod,env,ex,clazz,__VA_ARGS__)
 
 // Object
 #define _GetObjectClass(env,ex) BASEJNIC(GetObjectClass,env,ex)
 #define _NewObject(env,ex,...) BASEJNIC(NewObject,env,ex,__VA_ARGS__)
-#define _NewObjectV(env,clazz,methodID,ap) BASEJNIC(NewObject,env,clazz,methodID,ap)
+#define _NewObjectV(env,clazz,methodID,ap) BASEJNIC(NewObjectV,env,clazz,methodID,ap)
 #define _NewObjectA(env,clazz,methodID,args) BASEJNIC(NewObjectA,env,clazz,methodID,args)
 #define _CallStaticObjectMethod(env,ex,...) BASEJNIC(CallStaticObjectMethod,env,ex,__VA_ARGS__)
+#define _CallStaticObjectMethodA(env,ex,methodID,args) BASEJNIC(CallStaticObjectMethodA,env,ex,methodID,args)
 #define _GetObjectField(env,ex,methodID) BASEJNIC(GetObjectField,env,ex,methodID)
 #define _GetStaticObjectField(env,ex,methodID) BASEJNIC(GetStaticObjectField,env,ex,methodID)
 #define _CallObjectMethod(env,ex,...) BASEJNIC(CallObjectMethod,env,ex,__VA_ARGS__)
@@ -164,11 +191,16 @@
 
 // Double
 #define _CallDoubleMethod(env,ex,...) BASEJNIC(CallDoubleMethod,env,ex,__VA_ARGS__)
+#define _CallDoubleMethodA(env,ex,methodID,args) BASEJNIC(CallDoubleMethodA,env,ex,methodID,args)
+#define _CallStaticDoubleMethodA(env,ex,methodID,args) BASEJNIC(CallStaticDoubleMethodA,env,ex,methodID,args)
 #define _NewDoubleArray(env,len) BASEJNIC(NewDoubleArray,env,len)
 #define _GetDoubleField(env,clazz,fieldID) BASEJNIC(GetDoubleField,env,clazz,fieldID)
 #define _GetStaticDoubleField(env,clazz,fieldID) BASEJNIC(GetStaticDoubleField,env,clazz,fieldID)
+#define _SetDoubleField(env,obj,fieldID,val) BASEJNIC(SetDoubleField,env,obj,fieldID,val)
 #define _GetDoubleArrayRegion(env,array,start,len,buf) BASEJNIC(GetDoubleArrayRegion,env,array,start,len,buf)
 #define _SetDoubleArrayRegion(env,array,start,len,buf) BASEJNIC(SetDoubleArrayRegion,env,array,start,len,buf)
+#define _GetDoubleArrayElements(env,src,iscopy) BASEJNIC(GetDoubleArrayElements,env,src,iscopy)
+#define _ReleaseDoubleArrayElements(env,array,_d,mode) BASEJNIC(ReleaseDoubleArrayElements,env,array,_d,mode)
 
 // Short
 #define _NewShortArray(env,len) BASEJNIC(NewShortArray,env,len)
@@ -188,7 +220,9 @@
 
 // Float
 #define _NewFloatArray(env,len) BASEJNIC(NewFloatArray,env,len)
-#define _SetFloatField(env,clazz,fieldID) BASEJNIC(SetFloatField,env,clazz,fieldID)
+#define _GetFloatField(env,clazz,fieldID) BASEJNIC(GetFloatField,env,clazz,fieldID)
+#define _SetFloatField(env,obj,fieldID,val) BASEJNIC(SetFloatField,env,obj,fieldID,val)
+#define _GetFloatArrayElements(env,src,iscopy) BASEJNIC(GetFloatArrayElements,env,src,iscopy)
 #define _ReleaseFloatArrayElements(env,array,jin,mode) BASEJNIC(ReleaseFloatArrayElements,env,array,jin,mode)
 #define _GetFloatArrayRegion(env,array,start,len,buf) BASEJNIC(GetFloatArrayRegion,env,array,start,len,buf)
 #define _SetFloatArrayRegion(env,array,start,len,buf) BASEJNIC(SetFloatArrayRegion,env,array,start,len,buf)
@@ -203,7 +237,9 @@
 #define _NewBooleanArray(env,len) BASEJNIC(NewBooleanArray,env,len)
 #define _GetBooleanArrayElements(env,src,iscopy) BASEJNIC(GetBooleanArrayElements,env,src,iscopy)
 #define _GetBooleanArrayRegion(env,array,start,len,buf) BASEJNIC(GetBooleanArrayRegion,env,array,start,len,buf)
+#define _SetBooleanArrayRegion(env,array,start,len,buf) BASEJNIC(SetBooleanArrayRegion,env,array,start,len,buf)
 #define _SetBooleanField(env,obj,jid,val) BASEJNIC(SetBooleanField,env,obj,jid,val)
+#define _GetBooleanField(env,obj,jid) BASEJNIC(GetBooleanField,env,obj,jid)
 #define _SetStaticBooleanField(env,obj,jid,val) BASEJNIC(SetStaticBooleanField,env,obj,jid,val)
 #define _ReleaseBooleanArrayElements(env,array,_bool,mode) BASEJNIC(ReleaseBooleanArrayElements,env,array,_bool,mode)
 #define _CallBooleanMethod(env,ex,...) BASEJNIC(CallBooleanMethod,env,ex,__VA_ARGS__)
@@ -227,6 +263,7 @@
 #define _CallLongMethod(env,ex,...) BASEJNIC(CallLongMethod,env,ex,__VA_ARGS__)
 #define _CallLongMethodV(env,ex,methodID,args) BASEJNIC(CallLongMethodV,env,ex,methodID,args)
 #define _CallLongMethodA(env,ex,methodID,args) BASEJNIC(CallLongMethodA,env,ex,methodID,args)
+#define _CallStaticLongMethodA(env,ex,methodID,args) BASEJNIC(CallStaticLongMethodA,env,ex,methodID,args)
 #define _CallNonvirtualLongMethod_l(env,ex,...) BASEJNIC(CallNonvirtualLongMethod,env,ex,__VA_ARGS__)
 
 // String
@@ -247,7 +284,10 @@
 
 // Byte
 #define _CallByteMethod(env,ex,...) BASEJNIC(CallByteMethod,env,ex,__VA_ARGS__)
+#define _CallByteMethodA(env,ex,methodID,args) BASEJNIC(CallByteMethodA,env,ex,methodID,args)
+#define _CallStaticByteMethodA(env,ex,methodID,args) BASEJNIC(CallStaticByteMethodA,env,ex,methodID,args)
 #define _GetByteField(env,clazz,fieldID) BASEJNIC(GetByteField,env,clazz,fieldID)
+#define _SetByteField(env,obj,fieldID,val) BASEJNIC(SetByteField,env,obj,fieldID,val)
 #define _GetStaticByteField(env,clazz,fieldID) BASEJNIC(GetStaticByteField,env,clazz,fieldID)
 #define _NewByteArray(env,len) BASEJNIC(NewByteArray,env,len)
 #define _GetByteArrayRegion(env,array,start,len,buf) BASEJNIC(GetByteArrayRegion,env,array,start,len,buf)
@@ -261,6 +301,8 @@
 #define _SetIntField(env,obj,fieldID,val) BASEJNIC(SetIntField,env,obj,fieldID,val)
 #define _SetStaticIntField(env,obj,fieldID,val) BASEJNIC(SetStaticIntField,env,obj,fieldID,val)
 #define _CallIntMethod(env,ex,...) BASEJNIC(CallIntMethod,env,ex,__VA_ARGS__)
+#define _CallIntMethodA(env,ex,methodID,args) BASEJNIC(CallIntMethodA,env,ex,methodID,args)
+#define _CallStaticIntMethodA(env,ex,methodID,args) BASEJNIC(CallStaticIntMethodA,env,ex,methodID,args)
 #define _ReleaseIntArrayElements(env,array,byte,mode) BASEJNIC(ReleaseIntArrayElements,env,array,byte,mode)
 #define _SetIntArrayRegion(env,array,start,len,buf) BASEJNIC(SetIntArrayRegion,env,array,start,len,buf)
 #define _GetIntArrayElements(env,src,iscopy) BASEJNIC(GetIntArrayElements,env,src,iscopy)
@@ -274,6 +316,8 @@
 #define _GetSuperclass(env,sub) BASEJNIC(GetSuperclass,env,sub)
 #define _IsAssignableFrom(env,sub,sup) BASEJNIC(IsAssignableFrom,env,sub,sup)
 #define _GetEnv(vm,env,ver) BASEJNIC(GetEnv,vm,env,ver)
+#define _AttachCurrentThreadAsDaemon(vm,env,args) BASEJNIC(AttachCurrentThreadAsDaemon,vm,env,args)
+#define _DetachCurrentThread(vm) BASEJNIO(DetachCurrentThread,vm)
 
 #define _ExceptionClear(env) BASEJNIO(ExceptionClear,env)
 #define _ExceptionOccurred(env) BASEJNIO(ExceptionOccurred,env)
@@ -0,0 +1,57 @@
+package xjni;
+
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Bulk String[] helpers for the xjni native library.
+ *
+ * Native code moves the characters of every element through one array and
+ * makes a single call here, instead of one JNI call per element. For split,
+ * element i spans [offsets[i], offsets[i + 1]) of the data; elements flagged
+ * in nulls (which may itself be null) are left null.
+ */
+public final class XJNIStrings {
+    private XJNIStrings() {}
+
+    public static String[] split(char[] data, int[] offsets, boolean[] nulls) {
+        String[] out = new String[offsets.length - 1];
+        for (int i = 0; i < out.length; i++)
+            if (nulls == null || !nulls[i])
+                out[i] = new String(data, offsets[i], offsets[i + 1] - offsets[i]);
+        return out;
+    }
+
+    public static String[] splitLatin1(byte[] data, int[] offsets, boolean[] nulls) {
+        String[] out = new String[offsets.length - 1];
+        for (int i = 0; i < out.length; i++)
+            if (nulls == null || !nulls[i])
+                out[i] = new String(data, offsets[i], offsets[i + 1] - offsets[i], StandardCharsets.ISO_8859_1);
+        return out;
+    }
+
+    /**
+     * Concatenate the characters of every element. lengths[i] receives the
+     * length of element i, or -1 if it is null. Returns null if the result
+     * would not fit in a char[].
+     */
+    public static char[] concat(String[] array, int[] lengths) {
+        long total = 0;
+        for (int i = 0; i < array.length; i++) {
+            String s = array[i];
+            lengths[i] = s == null ? -1 : s.length();
+            if (s != null)
+                total += s.length();
+        }
+        if (total > Integer.MAX_VALUE - 8)
+            return null;
+        char[] out = new char[(int) total];
+        int pos = 0;
+        for (int i = 0; i < array.length; i++) {
+            if (lengths[i] < 0)
+                continue;
+            array[i].getChars(0, lengths[i], out, pos);
+            pos += lengths[i];
+        }
+        return out;
+    }
+}
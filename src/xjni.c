@@ -7,14 +7,8 @@
 #include "base-jni.h"
 
 #include <xjni.h>
-
-#ifdef _WIN32
-#define pthread_once(once_control, init_routine) InitOnceExecuteOnce(once_control, init_routine, NULL, NULL)
-#define pthread_mutex_init(mutex, attr) InitializeCriticalSection(mutex)
-#define pthread_mutex_lock(mutex) EnterCriticalSection(mutex)
-#define pthread_mutex_unlock(mutex) LeaveCriticalSection(mutex)
-#define pthread_mutex_destroy(mutex) DeleteCriticalSection(mutex)
-#endif
+#include "xjni_format.h"
+#include "xjni_lock.h"
 
 static char version[16];  // Enough for "255.255.255\0"
 
@@ -696,6 +690,12 @@ JNIEXPORTC jint JNICALL XJNI_OnLoad(JavaVM* vm,void* reserved,jint ver) {
 	if (XJNI_New_OnLoad(vm,reserved,ver) != ver)
 		return JNI_ERR;
 
+	if (XJNI_StringArray_OnLoad(vm,reserved,ver) != ver)
+		return JNI_ERR;
+
+	if (XJNI_Args_OnLoad(vm,reserved,ver) != ver)
+		return JNI_ERR;
+
 	struct {
 		const char* name;
 		jclass* cache;
@@ -760,6 +760,10 @@ JNIEXPORTC void JNICALL XJNI_OnUnload(JavaVM* vm,void* reserved,jint ver) {
 	if (_GetEnv(vm, (void**)&env, ver) != JNI_OK)
 		return;
 	XJNI_New_OnUnload(vm,reserved,ver);
+	XJNI_StringArray_OnUnload(vm,reserved,ver);
+	XJNI_ArrayField_OnUnload(vm,reserved,ver);
+	XJNI_Args_OnUnload(vm,reserved,ver);
+	xjni_format_unload(env);
 	class_free(env,ioExceptionCls,ioExceptionMutex);
 	class_free(env,charConversionExceptionCls,charConversionExceptionMutex);
 	class_free(env,eofExceptionCls,eofExceptionMutex);
@@ -8,6 +8,7 @@
 #include "base-jni.h"
 
 #include <xjni.h>
+#include "xjni_frame.h"
 
 #define _ReleaseArrayElements(env,func,array,elements,mode) BASEJNIC(func,env,array,elements,mode)
 #define _GetArrayElements(env,func,array,elements) BASEJNIC(func,env,array,elements)
@@ -19,7 +20,10 @@ JNIEXPORTC void JNICALL name(JNIEnv *env,jobjectArray array,jsize start,jsize le
 	if (env == NULL || array == NULL || buf == NULL) return;\
 	jsize outer_len = _GetArrayLength(env,array);\
 	if (start < 0 || len < 0 || start + len > outer_len) return;\
+	xjni_frame_t frame;\
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;\
 	for (jsize i = 0; i < len; ++i) {\
+		xjni_frame_next(&frame);\
 		T *dst = buf[i];\
 		if (dst == NULL) continue;\
 		jsize index = start + i;\
@@ -30,13 +34,17 @@ JNIEXPORTC void JNICALL name(JNIEnv *env,jobjectArray array,jsize start,jsize le
 			_DeleteLocalRef(env,inner);\
 		}\
 	}\
+	xjni_frame_leave(&frame,NULL);\
 }
 
 #define ReleaseT2DArrayElements(name,func,A,T)\
 JNIEXPORTC void JNICALL name(JNIEnv *env,jobjectArray array,T **elements,jint mode) {\
 	if (env == NULL || array == NULL || elements == NULL) return;\
 	jsize outer_len = _GetArrayLength(env,array);\
+	xjni_frame_t frame;\
+	xjni_frame_enter(&frame,env,outer_len,1);\
 	for (jsize i = 0; i < outer_len; ++i) {\
+		xjni_frame_next(&frame);\
 		if (elements[i] == NULL) continue;\
 		_GetArrayElement(env,A,inner,array,i);\
 		if (inner != NULL) {\
@@ -44,6 +52,7 @@ JNIEXPORTC void JNICALL name(JNIEnv *env,jobjectArray array,T **elements,jint mo
 			_DeleteLocalRef(env,inner);\
 		}\
 	}\
+	xjni_frame_leave(&frame,NULL);\
 	free((void*)elements);\
 }
 
@@ -54,7 +63,10 @@ JNIEXPORTC T** JNICALL name(JNIEnv *env,jobjectArray array,jboolean *isCopy) {\
 	T **elements = ((T **)(calloc(outer_len,sizeof(T*))));\
 	if (!elements) return NULL;\
 	jboolean anyCopy = JNI_FALSE;\
+	xjni_frame_t frame;\
+	if (xjni_frame_enter(&frame,env,outer_len,1) != JNI_OK) { free(elements); return NULL; }\
 	for (jsize i = 0; i < outer_len; ++i) {\
+		xjni_frame_next(&frame);\
 		_GetArrayElement(env,A,inner,array,i);\
 		if (inner == NULL) {\
 			elements[i] = NULL;\
@@ -65,6 +77,7 @@ JNIEXPORTC T** JNICALL name(JNIEnv *env,jobjectArray array,jboolean *isCopy) {\
 		_DeleteLocalRef(env,inner);\
 		if (localCopy == JNI_TRUE) anyCopy = JNI_TRUE;\
 	}\
+	xjni_frame_leave(&frame,NULL);\
 	if (isCopy) *isCopy = anyCopy;\
 	return elements;\
 }
@@ -75,24 +88,93 @@ JNIEXPORTC jobjectArray JNICALL name(JNIEnv *env,jsize row,jsize col) {\
 	jclass byteArrayClass = _FindClass(env,sig);\
 	if (byteArrayClass == NULL) return NULL;\
 	jobjectArray array = _NewObjectArray(env,row,byteArrayClass,NULL);\
-	if (array == NULL) { _DeleteLocalRef(env,byteArrayClass); return NULL; }\
+	_DeleteLocalRef(env,byteArrayClass);\
+	if (array == NULL) return NULL;\
+	xjni_frame_t frame;\
+	if (xjni_frame_enter(&frame,env,row,1) != JNI_OK) { _DeleteLocalRef(env,array); return NULL; }\
 	for (jsize i = 0; i < row; i++) {\
-		jArray rowArray = NewArray(env,col);\
-		if (rowArray == NULL) { _DeleteLocalRef(env,byteArrayClass); return NULL; }\
+		jArray rowArray = (xjni_frame_next(&frame) == JNI_OK) ? NewArray(env,col) : NULL;\
+		if (rowArray == NULL) { xjni_frame_leave(&frame,NULL); _DeleteLocalRef(env,array); return NULL; }\
 		_SetObjectArrayElement(env,array,i,rowArray);\
 		_DeleteLocalRef(env,rowArray);\
 	}\
-	_DeleteLocalRef(env,byteArrayClass);\
+	xjni_frame_leave(&frame,NULL);\
 	return array;\
 }
 
 
+typedef struct flat2d_job {
+	jobjectArray array;
+	xjni_ElementType type;
+	jsize start;
+	jsize cols;
+	size_t esize;
+	char *buf;
+	jboolean store;
+} flat2d_job;
+
+static jint flat2d_rows(JNIEnv *env,void *arg,jsize begin,jsize end) {
+	const flat2d_job *job = ubase_cast(const flat2d_job*,arg);
+	jint ret = JNI_OK;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,end - begin,1) != JNI_OK) return JNI_ERR;
+	for (jsize i = begin; i < end && ret == JNI_OK; ++i) {
+		xjni_frame_next(&frame);
+		_GetArrayElement(env,jarray,inner,job->array,job->start + i);
+		if (inner == NULL) { ret = JNI_ERR; break; }
+		if (_GetArrayLength(env,inner) != job->cols) {
+			_DeleteLocalRef(env,inner);
+			ret = JNI_ERR;
+			break;
+		}
+		char *row = job->buf + base_cast(size_t,i) * base_cast(size_t,job->cols) * job->esize;
+		if (job->store) SetPrimitiveArrayRegion(env,job->type,inner,0,job->cols,row);
+		else GetPrimitiveArrayRegion(env,job->type,inner,0,job->cols,row);
+		_DeleteLocalRef(env,inner);
+		if (_ExceptionCheck(env)) ret = JNI_ERR;
+	}
+	xjni_frame_leave(&frame,NULL);
+	return ret;
+}
+
+static jint flat2d_transfer(JNIEnv *env,xjni_pool_t *pool,jobjectArray array,xjni_ElementType type,jsize start,jsize len,jsize cols,void *buf,jboolean store) {
+	if (env == NULL || array == NULL || buf == NULL || cols < 0) return JNI_ERR;
+	jsize outer_len = _GetArrayLength(env,array);
+	if (start < 0 || len < 0 || start > outer_len - len) return JNI_ERR;
+
+	flat2d_job job = { array,type,start,cols,xjni_ElementSize(type),ubase_cast(char*,buf),store };
+	if (pool == NULL || len < 2 || base_cast(size_t,len) * base_cast(size_t,cols) < xjni_GetParallelThreshold())
+		return flat2d_rows(env,&job,0,len);
+
+	/* Workers have their own JNIEnv, so they can only see the outer array through a global ref. */
+	job.array = ubase_cast(jobjectArray,_NewGlobalRef(env,array));
+	if (job.array == NULL) return JNI_ERR;
+	jint ret = xjni_pool_run(pool,env,len,flat2d_rows,&job);
+	_DeleteGlobalRef(env,job.array);
+	return ret;
+}
+
+#define FlatT2DArrayRegion(T,type,jtype)\
+JNIEXPORTC jint JNICALL Get##T##2DArrayFlatRegion(JNIEnv *env,jobjectArray array,jsize start,jsize len,jsize cols,jtype *buf) {\
+	return flat2d_transfer(env,NULL,array,type,start,len,cols,buf,JNI_FALSE);\
+}\
+JNIEXPORTC jint JNICALL Set##T##2DArrayFlatRegion(JNIEnv *env,jobjectArray array,jsize start,jsize len,jsize cols,const jtype *buf) {\
+	return flat2d_transfer(env,NULL,array,type,start,len,cols,ubase_cast(void*,buf),JNI_TRUE);\
+}\
+JNIEXPORTC jint JNICALL Get##T##2DArrayFlatRegionParallel(JNIEnv *env,xjni_pool_t *pool,jobjectArray array,jsize start,jsize len,jsize cols,jtype *buf) {\
+	return flat2d_transfer(env,pool,array,type,start,len,cols,buf,JNI_FALSE);\
+}\
+JNIEXPORTC jint JNICALL Set##T##2DArrayFlatRegionParallel(JNIEnv *env,xjni_pool_t *pool,jobjectArray array,jsize start,jsize len,jsize cols,const jtype *buf) {\
+	return flat2d_transfer(env,pool,array,type,start,len,cols,ubase_cast(void*,buf),JNI_TRUE);\
+}
+
 // Byte2D - Access and release functions for Java byte[][]
 NewT2DArray(NewByte2DArray,"[B",jbyteArray,_NewByteArray)
 GetT2DArrayElements(GetByte2DArrayElements,GetByteArrayElements,jbyteArray,jbyte)
 ReleaseT2DArrayElements(ReleaseByte2DArrayElements,ReleaseByteArrayElements,jbyteArray,jbyte)
 GetT2DArrayRegion(SetByte2DArrayRegion,SetByteArrayRegion,jbyteArray,const jbyte)
 GetT2DArrayRegion(GetByte2DArrayRegion,GetByteArrayRegion,jbyteArray,jbyte)
+FlatT2DArrayRegion(Byte,XJNI_TYPE_BYTE,jbyte)
 
 // Int2D - Access and release functions for Java int[][]
 NewT2DArray(NewInt2DArray,"[I",jintArray,_NewIntArray)
@@ -100,6 +182,7 @@ GetT2DArrayElements(GetInt2DArrayElements,GetIntArrayElements,jintArray,jint)
 ReleaseT2DArrayElements(ReleaseInt2DArrayElements,ReleaseIntArrayElements,jintArray,jint)
 GetT2DArrayRegion(SetInt2DArrayRegion,SetIntArrayRegion,jintArray,const jint)
 GetT2DArrayRegion(GetInt2DArrayRegion,GetIntArrayRegion,jintArray,jint)
+FlatT2DArrayRegion(Int,XJNI_TYPE_INT,jint)
 
 // Long2D - Access and release functions for Java long[][]
 NewT2DArray(NewLong2DArray,"[J",jlongArray,_NewLongArray)
@@ -107,6 +190,7 @@ GetT2DArrayElements(GetLong2DArrayElements,GetLongArrayElements,jlongArray,jlong
 ReleaseT2DArrayElements(ReleaseLong2DArrayElements,ReleaseLongArrayElements,jlongArray,jlong)
 GetT2DArrayRegion(SetLong2DArrayRegion,SetLongArrayRegion,jlongArray,const jlong)
 GetT2DArrayRegion(GetLong2DArrayRegion,GetLongArrayRegion,jlongArray,jlong)
+FlatT2DArrayRegion(Long,XJNI_TYPE_LONG,jlong)
 
 // Float2D - Access and release functions for Java float[][]
 NewT2DArray(NewFloat2DArray,"[F",jfloatArray,_NewFloatArray)
@@ -114,6 +198,7 @@ GetT2DArrayElements(GetFloat2DArrayElements,GetFloatArrayElements,jfloatArray,jf
 ReleaseT2DArrayElements(ReleaseFloat2DArrayElements,ReleaseFloatArrayElements,jfloatArray,jfloat)
 GetT2DArrayRegion(SetFloat2DArrayRegion,SetFloatArrayRegion,jfloatArray,const jfloat)
 GetT2DArrayRegion(GetFloat2DArrayRegion,GetFloatArrayRegion,jfloatArray,jfloat)
+FlatT2DArrayRegion(Float,XJNI_TYPE_FLOAT,jfloat)
 
 // Double2D - Access and release functions for Java double[][].
 NewT2DArray(NewDouble2DArray,"[D",jdoubleArray,_NewDoubleArray)
@@ -121,6 +206,7 @@ GetT2DArrayElements(GetDouble2DArrayElements,GetDoubleArrayElements,jdoubleArray
 ReleaseT2DArrayElements(ReleaseDouble2DArrayElements,ReleaseDoubleArrayElements,jdoubleArray,jdouble)
 GetT2DArrayRegion(SetDouble2DArrayRegion,SetDoubleArrayRegion,jdoubleArray,const jdouble)
 GetT2DArrayRegion(GetDouble2DArrayRegion,GetDoubleArrayRegion,jdoubleArray,jdouble)
+FlatT2DArrayRegion(Double,XJNI_TYPE_DOUBLE,jdouble)
 
 // Short2D - Access and release functions for Java short[][].
 NewT2DArray(NewShort2DArray,"[S",jshortArray,_NewShortArray)
@@ -128,6 +214,7 @@ GetT2DArrayElements(GetShort2DArrayElements,GetShortArrayElements,jshortArray,js
 ReleaseT2DArrayElements(ReleaseShort2DArrayElements,ReleaseShortArrayElements,jshortArray,jshort)
 GetT2DArrayRegion(SetShort2DArrayRegion,SetShortArrayRegion,jshortArray,const jshort)
 GetT2DArrayRegion(GetShort2DArrayRegion,GetShortArrayRegion,jshortArray,jshort)
+FlatT2DArrayRegion(Short,XJNI_TYPE_SHORT,jshort)
 
 // Char2D - Access and release functions for Java char[][].
 NewT2DArray(NewChar2DArray,"[C",jcharArray,_NewCharArray)
@@ -135,6 +222,7 @@ GetT2DArrayElements(GetChar2DArrayElements,GetCharArrayElements,jcharArray,jchar
 ReleaseT2DArrayElements(ReleaseChar2DArrayElements,ReleaseCharArrayElements,jcharArray,jchar)
 GetT2DArrayRegion(SetChar2DArrayRegion,SetCharArrayRegion,jcharArray,const jchar)
 GetT2DArrayRegion(GetChar2DArrayRegion,GetCharArrayRegion,jcharArray,jchar)
+FlatT2DArrayRegion(Char,XJNI_TYPE_CHAR,jchar)
 
 // Boolean2D - Access and release functions for Java boolean[][].
 NewT2DArray(NewBoolean2DArray,"[Z",jbooleanArray,_NewBooleanArray)
@@ -142,22 +230,25 @@ GetT2DArrayElements(GetBoolean2DArrayElements,GetBooleanArrayElements,jbooleanAr
 ReleaseT2DArrayElements(ReleaseBoolean2DArrayElements,ReleaseBooleanArrayElements,jbooleanArray,jboolean)
 GetT2DArrayRegion(SetBoolean2DArrayRegion,SetBooleanArrayRegion,jbooleanArray,const jboolean)
 GetT2DArrayRegion(GetBoolean2DArrayRegion,GetBooleanArrayRegion,jbooleanArray,jboolean)
+FlatT2DArrayRegion(Boolean,XJNI_TYPE_BOOLEAN,jboolean)
 
 // StringUTF2D - Access and release functions for Java String[][].
 JNIEXPORTC jobjectArray JNICALL NewStringUTF2DArray(JNIEnv *env, const char ***utf, jsize row, jsize col) {
 	if (row < 0 || col < 0) return NULL;
-	jclass stringCls = _FindClass(env, "java/lang/String");
-	jclass stringArrayCls = _FindClass(env, "[Ljava/lang/String;");
+	jclass stringCls = xjni_GetStringClass(env);
+	jclass stringArrayCls = xjni_GetStringArrayClass(env);
 	if (!stringCls || !stringArrayCls) return NULL;
 	jobjectArray outer = _NewObjectArray(env, row, stringArrayCls, NULL);
 	if (!outer) return NULL;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame, env, row, 2) != JNI_OK) { _DeleteLocalRef(env, outer); return NULL; }
 	for (jsize i = 0; i < row; i++) {
-		jobjectArray inner = _NewObjectArray(env, col, stringCls, NULL);
-		if (!inner) return NULL;
+		jobjectArray inner = (xjni_frame_next(&frame) == JNI_OK) ? _NewObjectArray(env, col, stringCls, NULL) : NULL;
+		if (!inner) { xjni_frame_leave(&frame, NULL); _DeleteLocalRef(env, outer); return NULL; }
 		for (jsize j = 0; j < col; j++) {
 			if (utf && utf[i] && utf[i][j]) {
 				jstring str = _NewStringUTF(env, utf[i][j]);
-				if (!str) return NULL;
+				if (!str) { xjni_frame_leave(&frame, NULL); _DeleteLocalRef(env, outer); return NULL; }
 				_SetObjectArrayElement(env, inner, j, str);
 				_DeleteLocalRef(env, str);
 			}
@@ -165,8 +256,7 @@ JNIEXPORTC jobjectArray JNICALL NewStringUTF2DArray(JNIEnv *env, const char ***u
 		_SetObjectArrayElement(env, outer, i, inner);
 		_DeleteLocalRef(env, inner);
 	}
-	_DeleteLocalRef(env, stringCls);
-	_DeleteLocalRef(env, stringArrayCls);
+	xjni_frame_leave(&frame, NULL);
 	return outer;
 }
 
@@ -176,17 +266,21 @@ JNIEXPORTC const char*** JNICALL GetStringUTF2DArrayElements(JNIEnv *env,jobject
 	const char ***elements = ubase_cast(const char***,calloc(outer_len,sizeof(const char**)));
 	if (!elements) return NULL;
 	jboolean anyCopy = JNI_FALSE;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,outer_len,1) != JNI_OK) { free((void*)elements); return NULL; }
 	for (jsize i = 0; i < outer_len; ++i) {
+		xjni_frame_next(&frame);
 		_GetArrayElement(env,jobjectArray,inner,array,i);
 		if (inner == NULL) {
 			elements[i] = NULL;
 			continue;
 		}
 		jboolean localCopy = JNI_FALSE;
-		elements[i] = GetStringUTFArrayChars(env,array,&localCopy);
+		elements[i] = GetStringUTFArrayChars(env,inner,&localCopy);
 		_DeleteLocalRef(env,inner);
 		if (localCopy == JNI_TRUE) anyCopy = JNI_TRUE;
 	}
+	xjni_frame_leave(&frame,NULL);
 	if (isCopy) *isCopy = anyCopy;
 	return elements;
 }
@@ -194,7 +288,10 @@ JNIEXPORTC const char*** JNICALL GetStringUTF2DArrayElements(JNIEnv *env,jobject
 JNIEXPORTC void JNICALL ReleaseStringUTF2DArrayChars(JNIEnv *env,jobjectArray array,const char ***elements,jint mode) {
 	if (elements == NULL) return;
 	jsize outer_len = _GetArrayLength(env,array);
+	xjni_frame_t frame;
+	xjni_frame_enter(&frame,env,outer_len,1);
 	for (jsize i = 0; i < outer_len; ++i) {
+		xjni_frame_next(&frame);
 		if (elements[i] == NULL) continue;
 		_GetArrayElement(env,jobjectArray,inner,array,i);
 		if (inner != NULL) {
@@ -202,6 +299,7 @@ JNIEXPORTC void JNICALL ReleaseStringUTF2DArrayChars(JNIEnv *env,jobjectArray ar
 			_DeleteLocalRef(env,inner);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 	free((void*)elements);
 }
 
@@ -209,7 +307,10 @@ JNIEXPORTC void JNICALL SetStringUTF2DArrayRegion(JNIEnv *env,jobjectArray array
 	if (buf == NULL) return;
 	jsize outer_len = _GetArrayLength(env,array);
 	if (start < 0 || len < 0 || start + len > outer_len) return;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; ++i) {
+		xjni_frame_next(&frame);
 		const char **dst = buf[i];
 		if (dst == NULL) continue;
 		jsize index = start + i;
@@ -220,13 +321,17 @@ JNIEXPORTC void JNICALL SetStringUTF2DArrayRegion(JNIEnv *env,jobjectArray array
 			_DeleteLocalRef(env,inner);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 }
 
 JNIEXPORTC void JNICALL GetStringUTF2DArrayRegion(JNIEnv *env,jobjectArray array,jsize start,jsize len,char ***buf) {
 	if (buf == NULL) return;
 	jsize outer_len = _GetArrayLength(env,array);
 	if (start < 0 || len < 0 || start + len > outer_len) return;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; ++i) {
+		xjni_frame_next(&frame);
 		char **dst = buf[i];
 		if (dst == NULL) continue;
 		jsize index = start + i;
@@ -237,24 +342,26 @@ JNIEXPORTC void JNICALL GetStringUTF2DArrayRegion(JNIEnv *env,jobjectArray array
 			_DeleteLocalRef(env,inner);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 }
 
 // String2D - Access and release functions for Java String[][].
 JNIEXPORTC jobjectArray JNICALL NewString2DArray(JNIEnv *env, const jchar ***utf, jsize row, jsize col) {
 	if (row < 0 || col < 0) return NULL;
-	jclass stringCls = _FindClass(env, "java/lang/String");
-	jclass stringArrayCls = _FindClass(env, "[Ljava/lang/String;");
+	jclass stringCls = xjni_GetStringClass(env);
+	jclass stringArrayCls = xjni_GetStringArrayClass(env);
 	if (!stringCls || !stringArrayCls) return NULL;
 	jobjectArray outer = _NewObjectArray(env, row, stringArrayCls, NULL);
-	if (!outer) return NULL;
+	xjni_frame_t frame;
+	if (!outer || xjni_frame_enter(&frame, env, row, 2) != JNI_OK) return NULL;
 	for (jsize i = 0; i < row; i++) {
-		jobjectArray inner = _NewObjectArray(env, col, stringCls, NULL);
-		if (!inner) return NULL;
+		jobjectArray inner = (xjni_frame_next(&frame) == JNI_OK) ? _NewObjectArray(env, col, stringCls, NULL) : NULL;
+		if (!inner) { xjni_frame_leave(&frame, NULL); return NULL; }
 
 		for (jsize j = 0; j < col; j++) {
 			if (utf && utf[i] && utf[i][j]) {
 				jstring str = _NewString(env, utf[i][j],base_cast(jsize,jstrlen(utf[i][j])));
-				if (!str) return NULL;
+				if (!str) { xjni_frame_leave(&frame, NULL); return NULL; }
 				_SetObjectArrayElement(env, inner, j, str);
 				_DeleteLocalRef(env, str);
 			}
@@ -262,8 +369,7 @@ JNIEXPORTC jobjectArray JNICALL NewString2DArray(JNIEnv *env, const jchar ***utf
 		_SetObjectArrayElement(env, outer, i, inner);
 		_DeleteLocalRef(env, inner);
 	}
-	_DeleteLocalRef(env, stringCls);
-	_DeleteLocalRef(env, stringArrayCls);
+	xjni_frame_leave(&frame, NULL);
 	return outer;
 }
 
@@ -272,17 +378,21 @@ JNIEXPORTC const jchar*** JNICALL GetString2DArrayElements(JNIEnv *env,jobjectAr
 	const jchar ***elements = ubase_cast(const jchar***,calloc(outer_len,sizeof(const jchar**)));
 	if (!elements) return NULL;
 	jboolean anyCopy = JNI_FALSE;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,outer_len,1) != JNI_OK) { free((void*)elements); return NULL; }
 	for (jsize i = 0; i < outer_len; ++i) {
+		xjni_frame_next(&frame);
 		_GetArrayElement(env,jobjectArray,inner,array,i);
 		if (inner == NULL) {
 			elements[i] = NULL;
 			continue;
 		}
 		jboolean localCopy = JNI_FALSE;
-		elements[i] = GetStringArrayChars(env,array,&localCopy);
+		elements[i] = GetStringArrayChars(env,inner,&localCopy);
 		_DeleteLocalRef(env,inner);
 		if (localCopy == JNI_TRUE) anyCopy = JNI_TRUE;
 	}
+	xjni_frame_leave(&frame,NULL);
 	if (isCopy) *isCopy = anyCopy;
 	return elements;
 }
@@ -290,7 +400,10 @@ JNIEXPORTC const jchar*** JNICALL GetString2DArrayElements(JNIEnv *env,jobjectAr
 JNIEXPORTC void JNICALL ReleaseString2DArrayChars(JNIEnv *env,jobjectArray array,const jchar ***elements) {
 	if (elements == NULL) return;
 	jsize outer_len = _GetArrayLength(env,array);
+	xjni_frame_t frame;
+	xjni_frame_enter(&frame,env,outer_len,1);
 	for (jsize i = 0; i < outer_len; ++i) {
+		xjni_frame_next(&frame);
 		if (elements[i] == NULL) continue;
 		_GetArrayElement(env,jobjectArray,inner,array,i);
 		if (inner != NULL) {
@@ -298,6 +411,7 @@ JNIEXPORTC void JNICALL ReleaseString2DArrayChars(JNIEnv *env,jobjectArray array
 			_DeleteLocalRef(env,inner);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 	free((void*)elements);
 }
 
@@ -305,7 +419,10 @@ JNIEXPORTC void JNICALL SetString2DArrayRegion(JNIEnv *env,jobjectArray array,js
 	if (buf == NULL) return;
 	jsize outer_len = _GetArrayLength(env,array);
 	if (start < 0 || len < 0 || start + len > outer_len) return;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; ++i) {
+		xjni_frame_next(&frame);
 		const jchar **dst = buf[i];
 		if (dst == NULL) continue;
 		jsize index = start + i;
@@ -316,13 +433,17 @@ JNIEXPORTC void JNICALL SetString2DArrayRegion(JNIEnv *env,jobjectArray array,js
 			_DeleteLocalRef(env,inner);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 }
 
 JNIEXPORTC void JNICALL GetString2DArrayRegion(JNIEnv *env,jobjectArray array,jsize start,jsize len,jchar ***buf) {
 	if (buf == NULL) return;
 	jsize outer_len = _GetArrayLength(env,array);
 	if (start < 0 || len < 0 || start + len > outer_len) return;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; ++i) {
+		xjni_frame_next(&frame);
 		jchar **dst = buf[i];
 		if (dst == NULL) continue;
 		jsize index = start + i;
@@ -333,4 +454,205 @@ JNIEXPORTC void JNICALL GetString2DArrayRegion(JNIEnv *env,jobjectArray array,js
 			_DeleteLocalRef(env,inner);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
+}
+
+/* Element conversion with Java cast semantics: floating point to integral saturates (NaN -> 0). */
+static inline jint xjni_d2i(jdouble x) {
+	if (x != x) return 0;
+	if (x >= 2147483647.0) return INT32_MAX;
+	if (x <= -2147483648.0) return INT32_MIN;
+	return base_cast(jint,x);
+}
+
+static inline jlong xjni_d2l(jdouble x) {
+	if (x != x) return 0;
+	if (x >= 9223372036854775807.0) return INT64_MAX;
+	if (x <= -9223372036854775808.0) return INT64_MIN;
+	return base_cast(jlong,x);
+}
+
+#define TO_jboolean(x) base_cast(jboolean,(x) != 0)
+#define TO_jbyte(x) _Generic((x),jfloat: base_cast(jbyte,xjni_d2i(x)),jdouble: base_cast(jbyte,xjni_d2i(x)),default: base_cast(jbyte,x))
+#define TO_jchar(x) _Generic((x),jfloat: base_cast(jchar,xjni_d2i(x)),jdouble: base_cast(jchar,xjni_d2i(x)),default: base_cast(jchar,x))
+#define TO_jshort(x) _Generic((x),jfloat: base_cast(jshort,xjni_d2i(x)),jdouble: base_cast(jshort,xjni_d2i(x)),default: base_cast(jshort,x))
+#define TO_jint(x) _Generic((x),jfloat: xjni_d2i(x),jdouble: xjni_d2i(x),default: base_cast(jint,x))
+#define TO_jlong(x) _Generic((x),jfloat: xjni_d2l(x),jdouble: xjni_d2l(x),default: base_cast(jlong,x))
+#define TO_jfloat(x) base_cast(jfloat,x)
+#define TO_jdouble(x) base_cast(jdouble,x)
+
+#define XJNI_TYPES_SRC(X) X(Boolean,jboolean) X(Byte,jbyte) X(Char,jchar) X(Short,jshort) X(Int,jint) X(Long,jlong) X(Float,jfloat) X(Double,jdouble)
+#define XJNI_TYPES_DST(X,SN,ST) X(SN,ST,Boolean,jboolean) X(SN,ST,Byte,jbyte) X(SN,ST,Char,jchar) X(SN,ST,Short,jshort) X(SN,ST,Int,jint) X(SN,ST,Long,jlong) X(SN,ST,Float,jfloat) X(SN,ST,Double,jdouble)
+
+typedef void (*cvt_fn)(const void *src,void *dst,size_t n);
+
+/* Plain restrict loops so the compiler can vectorize every pair. */
+#define DEF_CVT(SN,ST,DN,DT)\
+static void cvt_##SN##_##DN(const void *src,void *dst,size_t n) {\
+	const ST *restrict s = ubase_cast(const ST*,src);\
+	DT *restrict d = ubase_cast(DT*,dst);\
+	for (size_t i = 0; i < n; i++) d[i] = TO_##DT(s[i]);\
+}
+#define DEF_CVT_ROW(SN,ST) XJNI_TYPES_DST(DEF_CVT,SN,ST)
+XJNI_TYPES_SRC(DEF_CVT_ROW)
+
+#define CVT_ENTRY(SN,ST,DN,DT) cvt_##SN##_##DN,
+#define CVT_TABLE_ROW(SN,ST) { XJNI_TYPES_DST(CVT_ENTRY,SN,ST) },
+static const cvt_fn cvt_table[8][8] = { XJNI_TYPES_SRC(CVT_TABLE_ROW) };
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+
+static void cvt_Int_Float_sse2(const void *src,void *dst,size_t n) {
+	const jint *s = ubase_cast(const jint*,src);
+	jfloat *d = ubase_cast(jfloat*,dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(d + i,_mm_cvtepi32_ps(_mm_loadu_si128(ubase_cast(const __m128i*,s + i))));
+	for (; i < n; i++) d[i] = base_cast(jfloat,s[i]);
+}
+
+static void cvt_Double_Float_sse2(const void *src,void *dst,size_t n) {
+	const jdouble *s = ubase_cast(const jdouble*,src);
+	jfloat *d = ubase_cast(jfloat*,dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(s + i));
+		__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(s + i + 2));
+		_mm_storeu_ps(d + i,_mm_movelh_ps(lo,hi));
+	}
+	for (; i < n; i++) d[i] = base_cast(jfloat,s[i]);
+}
+#endif
+
+static int type_index(xjni_ElementType type) {
+	switch (type) {
+		case XJNI_TYPE_BOOLEAN: return 0;
+		case XJNI_TYPE_BYTE: return 1;
+		case XJNI_TYPE_CHAR: return 2;
+		case XJNI_TYPE_SHORT: return 3;
+		case XJNI_TYPE_INT: return 4;
+		case XJNI_TYPE_LONG: return 5;
+		case XJNI_TYPE_FLOAT: return 6;
+		case XJNI_TYPE_DOUBLE: return 7;
+		default: return -1;
+	}
+}
+
+static cvt_fn cvt_lookup(xjni_ElementType from,xjni_ElementType to) {
+	int s = type_index(from),d = type_index(to);
+	if (s < 0 || d < 0) return NULL;
+#if defined(__SSE2__) || defined(_M_X64)
+	if (from == XJNI_TYPE_INT && to == XJNI_TYPE_FLOAT) return cvt_Int_Float_sse2;
+	if (from == XJNI_TYPE_DOUBLE && to == XJNI_TYPE_FLOAT) return cvt_Double_Float_sse2;
+#endif
+	return cvt_table[s][d];
+}
+
+/* Copy a rows x cols tile between a packed tile (row stride XJNI_2D_BLOCK) and a column-major matrix. */
+#define XJNI_2D_BLOCK 32
+#define TRANSPOSE_TILE(T)\
+	for (jsize c = 0; c < cols; c++) {\
+		T *m = ubase_cast(T*,mat) + base_cast(size_t,c) * ld;\
+		const T *t = ubase_cast(const T*,tile) + c;\
+		if (to_matrix) { for (jsize r = 0; r < rows; r++) m[r] = t[base_cast(size_t,r) * XJNI_2D_BLOCK]; }\
+		else { T *u = ubase_cast(T*,tile) + c; for (jsize r = 0; r < rows; r++) u[base_cast(size_t,r) * XJNI_2D_BLOCK] = m[r]; }\
+	}
+
+static void transpose_tile(void *tile,void *mat,size_t ld,jsize rows,jsize cols,size_t esize,jboolean to_matrix) {
+	switch (esize) {
+		case 1: TRANSPOSE_TILE(uint8_t) break;
+		case 2: TRANSPOSE_TILE(uint16_t) break;
+		case 4: TRANSPOSE_TILE(uint32_t) break;
+		default: TRANSPOSE_TILE(uint64_t) break;
+	}
+}
+
+static jint convert2d(JNIEnv *env,jobjectArray array,xjni_ElementType type,jsize rows,jsize cols,xjni_ElementType ntype,xjni_Order order,size_t ld,void *buf,jboolean store) {
+	if (env == NULL || array == NULL || buf == NULL || rows < 0 || cols < 0) return JNI_ERR;
+	cvt_fn cvt = store ? cvt_lookup(ntype,type) : cvt_lookup(type,ntype);
+	if (cvt == NULL || rows > _GetArrayLength(env,array)) return JNI_ERR;
+	size_t jsize_e = xjni_ElementSize(type),nsize = xjni_ElementSize(ntype);
+	if (ld == 0) ld = (order == XJNI_COL_MAJOR) ? base_cast(size_t,rows) : base_cast(size_t,cols);
+	if (ld < ((order == XJNI_COL_MAJOR) ? base_cast(size_t,rows) : base_cast(size_t,cols))) return JNI_ERR;
+	char *native = ubase_cast(char*,buf);
+
+	if (order != XJNI_COL_MAJOR) {
+		xjni_frame_t frame;
+		jint ret = JNI_OK;
+		if (xjni_frame_enter(&frame,env,rows,1) != JNI_OK) return JNI_ERR;
+		for (jsize r = 0; r < rows && ret == JNI_OK; r++) {
+			xjni_frame_next(&frame);
+			_GetArrayElement(env,jarray,inner,array,r);
+			if (inner == NULL || _GetArrayLength(env,inner) != cols) {
+				if (inner) _DeleteLocalRef(env,inner);
+				ret = JNI_ERR;
+				break;
+			}
+			char *row = native + base_cast(size_t,r) * ld * nsize;
+			if (type == ntype) {
+				if (store) SetPrimitiveArrayRegion(env,type,inner,0,cols,row);
+				else GetPrimitiveArrayRegion(env,type,inner,0,cols,row);
+			} else {
+				void *elems = _GetPrimitiveArrayCritical(env,inner,NULL);
+				if (elems == NULL) { _DeleteLocalRef(env,inner); ret = JNI_ERR; break; }
+				if (store) cvt(row,elems,base_cast(size_t,cols));
+				else cvt(elems,row,base_cast(size_t,cols));
+				_ReleasePrimitiveArrayCritical(env,inner,elems,store ? 0 : JNI_ABORT);
+			}
+			_DeleteLocalRef(env,inner);
+			if (_ExceptionCheck(env)) ret = JNI_ERR;
+		}
+		xjni_frame_leave(&frame,NULL);
+		return ret;
+	}
+
+	/* Column-major: pin a block of rows, then convert and transpose XJNI_2D_BLOCK x XJNI_2D_BLOCK tiles. */
+	jarray inner[XJNI_2D_BLOCK];
+	void *elems[XJNI_2D_BLOCK];
+	uint64_t tile[XJNI_2D_BLOCK * XJNI_2D_BLOCK];
+	if (_PushLocalFrame(env,XJNI_2D_BLOCK + 4) != JNI_OK) return JNI_ERR;
+	jint ret = JNI_OK;
+	for (jsize r0 = 0; r0 < rows && ret == JNI_OK; r0 += XJNI_2D_BLOCK) {
+		jsize nr = (rows - r0 < XJNI_2D_BLOCK) ? rows - r0 : XJNI_2D_BLOCK;
+		jsize got = 0,pinned = 0;
+		for (; got < nr; got++) {
+			inner[got] = ubase_cast(jarray,_GetObjectArrayElement(env,array,r0 + got));
+			if (inner[got] == NULL || _GetArrayLength(env,inner[got]) != cols) { got++; ret = JNI_ERR; break; }
+		}
+		for (; ret == JNI_OK && pinned < nr; pinned++) {
+			elems[pinned] = _GetPrimitiveArrayCritical(env,inner[pinned],NULL);
+			if (elems[pinned] == NULL) { ret = JNI_ERR; break; }
+		}
+		for (jsize c0 = 0; ret == JNI_OK && c0 < cols; c0 += XJNI_2D_BLOCK) {
+			jsize nc = (cols - c0 < XJNI_2D_BLOCK) ? cols - c0 : XJNI_2D_BLOCK;
+			char *mat = native + (base_cast(size_t,c0) * ld + base_cast(size_t,r0)) * nsize;
+			if (store) transpose_tile(tile,mat,ld,nr,nc,nsize,JNI_FALSE);
+			for (jsize r = 0; r < nr; r++) {
+				char *java = ubase_cast(char*,elems[r]) + base_cast(size_t,c0) * jsize_e;
+				char *t = ubase_cast(char*,tile) + base_cast(size_t,r) * XJNI_2D_BLOCK * nsize;
+				if (store) cvt(t,java,base_cast(size_t,nc));
+				else cvt(java,t,base_cast(size_t,nc));
+			}
+			if (!store) transpose_tile(tile,mat,ld,nr,nc,nsize,JNI_TRUE);
+		}
+		while (pinned > 0) {
+			pinned--;
+			_ReleasePrimitiveArrayCritical(env,inner[pinned],elems[pinned],store ? 0 : JNI_ABORT);
+		}
+		while (got > 0) {
+			got--;
+			if (inner[got]) _DeleteLocalRef(env,inner[got]);
+		}
+	}
+	_PopLocalFrame(env,NULL);
+	return ret;
+}
+
+JNIEXPORTC jint JNICALL xjni_Export2DArray(JNIEnv *env,jobjectArray array,xjni_ElementType type,jsize rows,jsize cols,xjni_ElementType dtype,xjni_Order order,size_t ld,void *dst) {
+	return convert2d(env,array,type,rows,cols,dtype,order,ld,dst,JNI_FALSE);
+}
+
+JNIEXPORTC jint JNICALL xjni_Import2DArray(JNIEnv *env,jobjectArray array,xjni_ElementType type,jsize rows,jsize cols,xjni_ElementType stype,xjni_Order order,size_t ld,const void *src) {
+	return convert2d(env,array,type,rows,cols,stype,order,ld,ubase_cast(void*,src),JNI_TRUE);
 }
@@ -1,9 +1,12 @@
+#include <stdlib.h>
 #include <string.h>
 #include <xjni_log.h>
 #include <xjni_args.h>
 
 #define LOG_TAG "xjni"
 #include "base-jni.h"
+#include "xjni_frame.h"
+#include "xjni_lock.h"
 
 typedef enum {
 	JARGS_OP_APPEND,
@@ -11,103 +14,198 @@ typedef enum {
 	JARGS_OP_REPLACE
 } jargs_op_t;
 
-static jclass gCharCls = NULL;
-static jmethodID gCharCtor = NULL;
-static jmethodID gCharValue = NULL;
-
-static jclass gBooleanCls = NULL;
-static jmethodID gBooleanCtor = NULL;
-static jmethodID gBooleanValue = NULL;
-
-static jclass gIntCls = NULL;
-static jmethodID gIntCtor = NULL;
-static jmethodID gIntValue = NULL;
-
-static jclass gLongCls = NULL;
-static jmethodID gLongCtor = NULL;
-static jmethodID gLongValue = NULL;
-
-static jclass gFloatCls = NULL;
-static jmethodID gFloatCtor = NULL;
-static jmethodID gFloatValue = NULL;
-
-static jclass gDoubleCls = NULL;
-static jmethodID gDoubleCtor = NULL;
-static jmethodID gDoubleValue = NULL;
+// Box class of one primitive type, resolved once by XJNI_Args_OnLoad (or on
+// first use) together with its value field and global references to
+// valueOf(low..high)
+typedef struct jargs_box {
+	char type;
+	const char *name;
+	const char *valueOfSig;
+	const char *unboxName;
+	const char *unboxSig;
+	jint low;
+	jint high;
+	jclass cls;
+	jmethodID valueOf;
+	jmethodID unbox;
+	jfieldID value;
+	jobject *cache;
+} jargs_box;
+
+enum {
+	JARGS_BOX_CHAR,
+	JARGS_BOX_BOOLEAN,
+	JARGS_BOX_INT,
+	JARGS_BOX_LONG,
+	JARGS_BOX_FLOAT,
+	JARGS_BOX_DOUBLE,
+	JARGS_BOX_BYTE,
+	JARGS_BOX_SHORT,
+	JARGS_BOX_COUNT
+};
+
+static jargs_box gBoxes[JARGS_BOX_COUNT] = {
+	{ 'C', "java/lang/Character", "(C)Ljava/lang/Character;", "charValue", "()C", 0, 127, NULL, NULL, NULL, NULL, NULL },
+	{ 'Z', "java/lang/Boolean", "(Z)Ljava/lang/Boolean;", "booleanValue", "()Z", 0, 1, NULL, NULL, NULL, NULL, NULL },
+	{ 'I', "java/lang/Integer", "(I)Ljava/lang/Integer;", "intValue", "()I", -128, 127, NULL, NULL, NULL, NULL, NULL },
+	{ 'J', "java/lang/Long", "(J)Ljava/lang/Long;", "longValue", "()J", -128, 127, NULL, NULL, NULL, NULL, NULL },
+	{ 'F', "java/lang/Float", "(F)Ljava/lang/Float;", "floatValue", "()F", 0, -1, NULL, NULL, NULL, NULL, NULL },
+	{ 'D', "java/lang/Double", "(D)Ljava/lang/Double;", "doubleValue", "()D", 0, -1, NULL, NULL, NULL, NULL, NULL },
+	{ 'B', "java/lang/Byte", "(B)Ljava/lang/Byte;", "byteValue", "()B", 0, -1, NULL, NULL, NULL, NULL, NULL },
+	{ 'S', "java/lang/Short", "(S)Ljava/lang/Short;", "shortValue", "()S", 0, -1, NULL, NULL, NULL, NULL, NULL },
+};
+static jboolean gBoxesResolved = JNI_FALSE;
+static pthread_mutex_t gBoxMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void jargs_boxes_release(JNIEnv *env) {
+	for (int k = 0; k < JARGS_BOX_COUNT; k++) {
+		jargs_box *box = &gBoxes[k];
+		if (box->cache) {
+			for (jint v = box->low; v <= box->high; v++)
+				if (box->cache[v - box->low]) _DeleteGlobalRef(env, box->cache[v - box->low]);
+			free(box->cache);
+			box->cache = NULL;
+		}
+		if (box->cls) _DeleteGlobalRef(env, box->cls);
+		box->cls = NULL;
+		box->valueOf = NULL;
+		box->unbox = NULL;
+		box->value = NULL;
+	}
+}
 
-// Helpers to ensure classes are loaded
-static jboolean ensureCharacterClass(JNIEnv *env) {
-	if (gCharCls && gCharCtor && gCharValue) return JNI_TRUE;
-	jclass local = _FindClass(env, "java/lang/Character");
+static jboolean jargs_box_load(JNIEnv *env, jargs_box *box) {
+	jclass local = _FindClass(env, box->name);
 	if (!local) return JNI_FALSE;
-	gCharCls = (jclass)_NewGlobalRef(env, local);
+	box->cls = (jclass)_NewGlobalRef(env, local);
 	_DeleteLocalRef(env, local);
-	if (!gCharCls) return JNI_FALSE;
-	gCharCtor = _GetMethodID(env, gCharCls, "<init>", "(C)V");
-	gCharValue = _GetMethodID(env, gCharCls, "charValue", "()C");
-	return gCharCtor && gCharValue;
+	if (!box->cls) return JNI_FALSE;
+	box->valueOf = _GetStaticMethodID(env, box->cls, "valueOf", box->valueOfSig);
+	box->unbox = box->valueOf ? _GetMethodID(env, box->cls, box->unboxName, box->unboxSig) : NULL;
+	if (!box->unbox) return JNI_FALSE;
+	// the private value field is read directly when the runtime has it
+	char sig[2] = { box->type, '\0' };
+	box->value = _GetFieldID(env, box->cls, "value", sig);
+	if (!box->value) _ExceptionClear(env);
+	if (box->high < box->low) return JNI_TRUE;
+
+	box->cache = (jobject *)calloc((size_t)(box->high - box->low + 1), sizeof(jobject));
+	if (!box->cache) return JNI_FALSE;
+	for (jint v = box->low; v <= box->high; v++) {
+		jvalue arg;
+		switch (box->type) {
+			case 'C': arg.c = (jchar)v; break;
+			case 'Z': arg.z = v ? JNI_TRUE : JNI_FALSE; break;
+			case 'J': arg.j = v; break;
+			default: arg.i = v; break;
+		}
+		jobject obj = _CallStaticObjectMethodA(env, box->cls, box->valueOf, &arg);
+		if (!obj || _ExceptionCheck(env)) return JNI_FALSE;
+		box->cache[v - box->low] = _NewGlobalRef(env, obj);
+		_DeleteLocalRef(env, obj);
+		if (!box->cache[v - box->low]) return JNI_FALSE;
+	}
+	return JNI_TRUE;
 }
 
-static jboolean ensureBooleanClass(JNIEnv *env) {
-	if (gBooleanCls && gBooleanCtor && gBooleanValue) return JNI_TRUE;
-	jclass local = _FindClass(env, "java/lang/Boolean");
-	if (!local) return JNI_FALSE;
-	gBooleanCls = (jclass)_NewGlobalRef(env, local);
-	_DeleteLocalRef(env, local);
-	if (!gBooleanCls) return JNI_FALSE;
-	gBooleanCtor  = _GetMethodID(env, gBooleanCls, "<init>", "(Z)V");
-	gBooleanValue = _GetMethodID(env, gBooleanCls, "booleanValue", "()Z");
-	return gBooleanCtor && gBooleanValue;
+static jboolean jargs_boxes_resolve(JNIEnv *env) {
+	if (gBoxesResolved) return JNI_TRUE;
+	pthread_mutex_lock(&gBoxMutex);
+	if (!gBoxesResolved) {
+		jboolean ok = JNI_TRUE;
+		for (int k = 0; ok && k < JARGS_BOX_COUNT; k++)
+			ok = jargs_box_load(env, &gBoxes[k]);
+		if (ok) {
+			gBoxesResolved = JNI_TRUE;
+		} else {
+			XJNI_LOGE("jargs_boxes_resolve", "Box classes could not be resolved");
+			if (_ExceptionCheck(env)) _ExceptionClear(env);
+			jargs_boxes_release(env);
+		}
+	}
+	pthread_mutex_unlock(&gBoxMutex);
+	return gBoxesResolved;
 }
 
-static jboolean ensureIntegerClass(JNIEnv *env) {
-	if (gIntCls && gIntCtor && gIntValue) return JNI_TRUE;
-	jclass local = _FindClass(env, "java/lang/Integer");
-	if (!local) return JNI_FALSE;
-	gIntCls = (jclass)_NewGlobalRef(env, local);
-	_DeleteLocalRef(env, local);
-	if (!gIntCls) return JNI_FALSE;
-	gIntCtor  = _GetMethodID(env, gIntCls, "<init>", "(I)V");
-	gIntValue = _GetMethodID(env, gIntCls, "intValue", "()I");
-	return gIntCtor && gIntValue;
+// Preloaded box of value (a global reference), or NULL when it is out of the table
+static jobject jargs_box_cached(const jargs_box *box, const jvalue *value) {
+	if (!box->cache) return NULL;
+	jlong v;
+	switch (box->type) {
+		case 'C': v = value->c; break;
+		case 'Z': v = value->z ? 1 : 0; break;
+		case 'J': v = value->j; break;
+		default: v = value->i; break;
+	}
+	return (v >= box->low && v <= box->high) ? box->cache[v - box->low] : NULL;
 }
 
-static jboolean ensureLongClass(JNIEnv *env) {
-	if (gLongCls && gLongCtor && gLongValue) return JNI_TRUE;
-	jclass local = _FindClass(env, "java/lang/Long");
-	if (!local) return JNI_FALSE;
-	gLongCls = (jclass)_NewGlobalRef(env, local);
-	_DeleteLocalRef(env, local);
-	if (!gLongCls) return JNI_FALSE;
-	gLongCtor  = _GetMethodID(env, gLongCls, "<init>", "(J)V");
-	gLongValue = _GetMethodID(env, gLongCls, "longValue", "()J");
-	return gLongCtor && gLongValue;
+// New local reference to the box of value
+static jobject jargs_box_new(JNIEnv *env, int kind, const jvalue *value) {
+	if (!jargs_boxes_resolve(env)) return NULL;
+	const jargs_box *box = &gBoxes[kind];
+	jobject cached = jargs_box_cached(box, value);
+	if (cached) return _NewLocalRef(env, cached);
+	jobject obj = _CallStaticObjectMethodA(env, box->cls, box->valueOf, value);
+	if (_ExceptionCheck(env)) {
+		_ExceptionClear(env);
+		return NULL;
+	}
+	return obj;
 }
 
-static jboolean ensureFloatClass(JNIEnv *env) {
-	if (gFloatCls && gFloatCtor && gFloatValue) return JNI_TRUE;
-	jclass local = _FindClass(env, "java/lang/Float");
-	if (!local) return JNI_FALSE;
-	gFloatCls = (jclass)_NewGlobalRef(env, local);
-	_DeleteLocalRef(env, local);
-	if (!gFloatCls) return JNI_FALSE;
-	gFloatCtor  = _GetMethodID(env, gFloatCls, "<init>", "(F)V");
-	gFloatValue = _GetMethodID(env, gFloatCls, "floatValue", "()F");
-	return gFloatCtor && gFloatValue;
+// Primitive value of obj, a box of the given table entry
+static void jargs_unbox(JNIEnv *env, const jargs_box *box, jobject obj, jvalue *out) {
+	switch (box->type) {
+		case 'Z': out->z = box->value ? _GetBooleanField(env, obj, box->value) : _CallBooleanMethod(env, obj, box->unbox); break;
+		case 'B': out->b = box->value ? _GetByteField(env, obj, box->value) : _CallByteMethod(env, obj, box->unbox); break;
+		case 'C': out->c = box->value ? _GetCharField(env, obj, box->value) : _CallCharMethod(env, obj, box->unbox); break;
+		case 'S': out->s = box->value ? _GetShortField(env, obj, box->value) : _CallShortMethod(env, obj, box->unbox); break;
+		case 'I': out->i = box->value ? _GetIntField(env, obj, box->value) : _CallIntMethod(env, obj, box->unbox); break;
+		case 'J': out->j = box->value ? _GetLongField(env, obj, box->value) : _CallLongMethod(env, obj, box->unbox); break;
+		case 'F': out->f = box->value ? _GetFloatField(env, obj, box->value) : _CallFloatMethod(env, obj, box->unbox); break;
+		case 'D': out->d = box->value ? _GetDoubleField(env, obj, box->value) : _CallDoubleMethod(env, obj, box->unbox); break;
+	}
 }
 
-static jboolean ensureDoubleClass(JNIEnv *env) {
-	if (gDoubleCls && gDoubleCtor && gDoubleValue) return JNI_TRUE;
-	jclass local = _FindClass(env, "java/lang/Double");
-	if (!local) return JNI_FALSE;
-	gDoubleCls = (jclass)_NewGlobalRef(env, local);
-	_DeleteLocalRef(env, local);
-	if (!gDoubleCls) return JNI_FALSE;
-	gDoubleCtor  = _GetMethodID(env, gDoubleCls, "<init>", "(D)V");
-	gDoubleValue = _GetMethodID(env, gDoubleCls, "doubleValue", "()D");
-	return gDoubleCtor && gDoubleValue;
+JNIEXPORTC jint JNICALL XJNI_Args_OnLoad(JavaVM* vm, void* reserved, jint ver) {
+	JNIEnv* env = NULL;
+	(void)reserved;
+	if (_GetEnv(vm, (void**)&env, ver) != JNI_OK)
+		return JNI_ERR;
+	return jargs_boxes_resolve(env) ? ver : JNI_ERR;
+}
+
+JNIEXPORTC void JNICALL XJNI_Args_OnUnload(JavaVM* vm, void* reserved, jint ver) {
+	JNIEnv* env = NULL;
+	(void)reserved;
+	if (_GetEnv(vm, (void**)&env, ver) != JNI_OK)
+		return;
+	pthread_mutex_lock(&gBoxMutex);
+	jargs_boxes_release(env);
+	gBoxesResolved = JNI_FALSE;
+	pthread_mutex_unlock(&gBoxMutex);
 }
 
+// Find the first NULL slot of args, or -1 if it is full
+static jsize jargs_first_free(JNIEnv *env, jargs_t args, jsize len) {
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame, env, len, 1) != JNI_OK) return -1;
+	jsize slot = -1;
+	for (jsize i = 0; i < len; i++) {
+		xjni_frame_next(&frame);
+		jobject cur = _GetObjectArrayElement(env, args, i);
+		if (!cur) {
+			slot = i;
+			break;
+		}
+		_DeleteLocalRef(env, cur);
+	}
+	xjni_frame_leave(&frame, NULL);
+	return slot;
+}
+
+// obj stays owned by the caller
 static void jargs_handle_object(JNIEnv *env, jargs_t args, jobject obj, jargs_op_t op, jsize index) {
 	if (!env || !args || !obj) return;
 
@@ -115,29 +213,28 @@ static void jargs_handle_object(JNIEnv *env, jargs_t args, jobject obj, jargs_op
 
 	if (op == JARGS_OP_APPEND) {
 		// append to first NULL slot
-		for (jsize i = 0; i < len; i++) {
-			jobject cur = _GetObjectArrayElement(env, args, i);
-			if (!cur) {
-				_SetObjectArrayElement(env, args, i, obj);
-				return;
-			}
-			_DeleteLocalRef(env, cur);
+		jsize slot = jargs_first_free(env, args, len);
+		if (slot >= 0) {
+			_SetObjectArrayElement(env, args, slot, obj);
+			return;
 		}
 		XJNI_LOGE("jargs_handle_object", "jobjectArray full, cannot append");
-		_DeleteLocalRef(env, obj);
 	} else if (op == JARGS_OP_INSERT || op == JARGS_OP_REPLACE) {
 		if (index < 0 || index >= len) {
 			XJNI_LOGE("jargs_handle_object", "Index out of bounds");
-			_DeleteLocalRef(env, obj);
 			return;
 		}
 		if (op == JARGS_OP_INSERT) {
 			// shift elements right
+			xjni_frame_t frame;
+			if (xjni_frame_enter(&frame, env, len - 1 - index, 1) != JNI_OK) return;
 			for (jsize i = len - 1; i > index; i--) {
+				xjni_frame_next(&frame);
 				jobject tmp = _GetObjectArrayElement(env, args, i - 1);
 				_SetObjectArrayElement(env, args, i, tmp);
 				if (tmp) _DeleteLocalRef(env, tmp);
 			}
+			xjni_frame_leave(&frame, NULL);
 		} else {
 			// REPLACE: delete old element
 			jobject old = _GetObjectArrayElement(env, args, index);
@@ -147,63 +244,213 @@ static void jargs_handle_object(JNIEnv *env, jargs_t args, jobject obj, jargs_op
 	}
 }
 
-static jobject jargs_box(JNIEnv *env, jclass cls, jmethodID ctor, ...) {
-	if (!cls || !ctor) return NULL;
-	va_list ap;
-	va_start(ap, ctor);
-	jobject obj = _NewObjectV(env, cls, ctor, ap);
-	va_end(ap);
-	if (_ExceptionCheck(env)) { _ExceptionClear(env); return NULL; }
-	return obj;
-}
-
-#define DEFINE_JARGS_FUNCS(type, jtype, cls_func) \
+#define DEFINE_JARGS_FUNCS(type, jtype, kind, member) \
 JNIEXPORTC void JNICALL JArgsAppend##type(JNIEnv *env, jargs_t args, jtype val) { \
-	if (!cls_func(env)) return; \
-	jobject obj = _NewObject(env, g##type##Cls, g##type##Ctor, val); \
+	jvalue value; \
+	value.member = val; \
+	jobject obj = jargs_box_new(env, kind, &value); \
 	if (!obj) return; \
 	jargs_handle_object(env, args, obj, JARGS_OP_APPEND, 0); \
+	_DeleteLocalRef(env, obj); \
 } \
 \
 JNIEXPORTC void JNICALL JArgsInsert##type(JNIEnv *env, jargs_t args, jtype val, jsize index) { \
-	if (!cls_func(env)) return; \
-	jobject obj = _NewObject(env, g##type##Cls, g##type##Ctor, val); \
+	jvalue value; \
+	value.member = val; \
+	jobject obj = jargs_box_new(env, kind, &value); \
 	if (!obj) return; \
 	jargs_handle_object(env, args, obj, JARGS_OP_INSERT, index); \
+	_DeleteLocalRef(env, obj); \
 } \
 \
 JNIEXPORTC void JNICALL JArgsReplace##type(JNIEnv *env, jargs_t args, jtype val, jsize index) { \
-	if (!cls_func(env)) return; \
-	jobject obj = _NewObject(env, g##type##Cls, g##type##Ctor, val); \
+	jvalue value; \
+	value.member = val; \
+	jobject obj = jargs_box_new(env, kind, &value); \
 	if (!obj) return; \
 	jargs_handle_object(env, args, obj, JARGS_OP_REPLACE, index); \
+	_DeleteLocalRef(env, obj); \
 }
 
-DEFINE_JARGS_FUNCS(Char, jchar, ensureCharacterClass)
-DEFINE_JARGS_FUNCS(Boolean, jboolean, ensureBooleanClass)
-DEFINE_JARGS_FUNCS(Int, jint, ensureIntegerClass)
-DEFINE_JARGS_FUNCS(Long, jlong, ensureLongClass)
-DEFINE_JARGS_FUNCS(Float, jfloat, ensureFloatClass)
-DEFINE_JARGS_FUNCS(Double, jdouble, ensureDoubleClass)
+DEFINE_JARGS_FUNCS(Char, jchar, JARGS_BOX_CHAR, c)
+DEFINE_JARGS_FUNCS(Boolean, jboolean, JARGS_BOX_BOOLEAN, z)
+DEFINE_JARGS_FUNCS(Int, jint, JARGS_BOX_INT, i)
+DEFINE_JARGS_FUNCS(Long, jlong, JARGS_BOX_LONG, j)
+DEFINE_JARGS_FUNCS(Float, jfloat, JARGS_BOX_FLOAT, f)
+DEFINE_JARGS_FUNCS(Double, jdouble, JARGS_BOX_DOUBLE, d)
 
 JNIEXPORTC jargs_t JNICALL NewJArgs(JNIEnv *env, jsize index,jclass cls,jobject init) {
 	return _NewObjectArray(env,index,cls,init);
 }
 
+// Array created by NewJArgsBuilder with its fill position: elements go
+// straight into the Java array, only the cursor is native
+struct jargs_builder {
+	jargs_t args;
+	jsize count;
+	jsize capacity;
+};
+
+JNIEXPORTC jargs_builder_t* JNICALL NewJArgsBuilder(JNIEnv *env, jsize capacity, jclass cls) {
+	if (!env || capacity < 0) return NULL;
+	jargs_builder_t *builder = (jargs_builder_t *)malloc(sizeof(jargs_builder_t));
+	if (!builder) return NULL;
+	builder->args = _NewObjectArray(env, capacity, cls, NULL);
+	if (!builder->args) {
+		free(builder);
+		return NULL;
+	}
+	builder->count = 0;
+	builder->capacity = capacity;
+	return builder;
+}
+
+JNIEXPORTC jargs_t JNICALL JArgsBuilderFinish(jargs_builder_t *builder) {
+	if (!builder) return NULL;
+	jargs_t args = builder->args;
+	free(builder);
+	return args;
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderFree(JNIEnv *env, jargs_builder_t *builder) {
+	if (!builder) return;
+	if (env) _DeleteLocalRef(env, builder->args);
+	free(builder);
+}
+
+JNIEXPORTC jargs_t JNICALL JArgsBuilderArray(const jargs_builder_t *builder) {
+	return builder ? builder->args : NULL;
+}
+
+JNIEXPORTC jsize JNICALL JArgsBuilderSize(const jargs_builder_t *builder) {
+	return builder ? builder->count : 0;
+}
+
+// obj stays owned by the caller; one SetObjectArrayElement except for an insert
+// before the end, which shifts only the filled part
+static void jargs_builder_handle(JNIEnv *env, jargs_builder_t *builder, jobject obj, jargs_op_t op, jsize index) {
+	if (!env || !builder) return;
+	if (op == JARGS_OP_APPEND) {
+		if (builder->count >= builder->capacity) {
+			XJNI_LOGE("jargs_builder_handle", "jobjectArray full, cannot append");
+			return;
+		}
+		index = builder->count;
+	} else if (index < 0 || index >= builder->capacity) {
+		XJNI_LOGE("jargs_builder_handle", "Index out of bounds");
+		return;
+	}
+
+	if (op == JARGS_OP_INSERT && index < builder->count) {
+		// shift elements right, the last one falls off a full array
+		jsize last = builder->count < builder->capacity ? builder->count : builder->capacity - 1;
+		xjni_frame_t frame;
+		if (xjni_frame_enter(&frame, env, last - index, 1) != JNI_OK) return;
+		for (jsize i = last; i > index; i--) {
+			xjni_frame_next(&frame);
+			jobject tmp = _GetObjectArrayElement(env, builder->args, i - 1);
+			_SetObjectArrayElement(env, builder->args, i, tmp);
+			if (tmp) _DeleteLocalRef(env, tmp);
+		}
+		xjni_frame_leave(&frame, NULL);
+		builder->count = last + 1;
+	} else if (index >= builder->count) {
+		builder->count = index + 1;
+	}
+	_SetObjectArrayElement(env, builder->args, index, obj);
+}
+
+#define DEFINE_JARGS_BUILDER_FUNCS(type, jtype, kind, member) \
+JNIEXPORTC void JNICALL JArgsBuilderAppend##type(JNIEnv *env, jargs_builder_t *builder, jtype val) { \
+	jvalue value; \
+	value.member = val; \
+	jobject obj = jargs_box_new(env, kind, &value); \
+	if (!obj) return; \
+	jargs_builder_handle(env, builder, obj, JARGS_OP_APPEND, 0); \
+	_DeleteLocalRef(env, obj); \
+} \
+\
+JNIEXPORTC void JNICALL JArgsBuilderInsert##type(JNIEnv *env, jargs_builder_t *builder, jtype val, jsize index) { \
+	jvalue value; \
+	value.member = val; \
+	jobject obj = jargs_box_new(env, kind, &value); \
+	if (!obj) return; \
+	jargs_builder_handle(env, builder, obj, JARGS_OP_INSERT, index); \
+	_DeleteLocalRef(env, obj); \
+} \
+\
+JNIEXPORTC void JNICALL JArgsBuilderReplace##type(JNIEnv *env, jargs_builder_t *builder, jtype val, jsize index) { \
+	jvalue value; \
+	value.member = val; \
+	jobject obj = jargs_box_new(env, kind, &value); \
+	if (!obj) return; \
+	jargs_builder_handle(env, builder, obj, JARGS_OP_REPLACE, index); \
+	_DeleteLocalRef(env, obj); \
+}
+
+DEFINE_JARGS_BUILDER_FUNCS(Char, jchar, JARGS_BOX_CHAR, c)
+DEFINE_JARGS_BUILDER_FUNCS(Boolean, jboolean, JARGS_BOX_BOOLEAN, z)
+DEFINE_JARGS_BUILDER_FUNCS(Int, jint, JARGS_BOX_INT, i)
+DEFINE_JARGS_BUILDER_FUNCS(Long, jlong, JARGS_BOX_LONG, j)
+DEFINE_JARGS_BUILDER_FUNCS(Float, jfloat, JARGS_BOX_FLOAT, f)
+DEFINE_JARGS_BUILDER_FUNCS(Double, jdouble, JARGS_BOX_DOUBLE, d)
+
+JNIEXPORTC void JNICALL JArgsBuilderAppendObject(JNIEnv *env, jargs_builder_t *builder, jobject obj) {
+	if (obj) jargs_builder_handle(env, builder, obj, JARGS_OP_APPEND, 0);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderAppendString(JNIEnv *env, jargs_builder_t *builder, jstring obj) {
+	JArgsBuilderAppendObject(env, builder, obj);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderInsertObject(JNIEnv *env, jargs_builder_t *builder, jobject obj, jsize index) {
+	if (obj) jargs_builder_handle(env, builder, obj, JARGS_OP_INSERT, index);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderInsertString(JNIEnv *env, jargs_builder_t *builder, jstring obj, jsize index) {
+	JArgsBuilderInsertObject(env, builder, obj, index);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderReplaceObject(JNIEnv *env, jargs_builder_t *builder, jobject obj, jsize index) {
+	if (obj) jargs_builder_handle(env, builder, obj, JARGS_OP_REPLACE, index);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderReplaceString(JNIEnv *env, jargs_builder_t *builder, jstring obj, jsize index) {
+	JArgsBuilderReplaceObject(env, builder, obj, index);
+}
+
+static void jargs_builder_utf(JNIEnv *env, jargs_builder_t *builder, const char *utf, jargs_op_t op, jsize index) {
+	if (!env || !utf) return;
+	jstring jstr = _NewStringUTF(env, utf);
+	if (jstr == NULL || _ExceptionCheck(env)) {
+		_ExceptionClear(env);
+		return;
+	}
+	jargs_builder_handle(env, builder, jstr, op, index);
+	_DeleteLocalRef(env, jstr);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderAppendStringUTF(JNIEnv *env, jargs_builder_t *builder, const char* utf) {
+	jargs_builder_utf(env, builder, utf, JARGS_OP_APPEND, 0);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderInsertStringUTF(JNIEnv *env, jargs_builder_t *builder, const char* utf, jsize index) {
+	jargs_builder_utf(env, builder, utf, JARGS_OP_INSERT, index);
+}
+
+JNIEXPORTC void JNICALL JArgsBuilderReplaceStringUTF(JNIEnv *env, jargs_builder_t *builder, const char* utf, jsize index) {
+	jargs_builder_utf(env, builder, utf, JARGS_OP_REPLACE, index);
+}
+
 // Helper to append object to first NULL slot
 JNIEXPORTC void JNICALL JArgsAppendObject(JNIEnv *env, jargs_t args, jobject obj) {
 	if (!env || !args || !obj) return;
-	jsize len = _GetArrayLength(env, args);
-	for (jsize i = 0; i < len; i++) {
-		jobject current = _GetObjectArrayElement(env, args, i);
-		if (!current) {
-			_SetObjectArrayElement(env, args, i, obj);
-			return;
-		}
-		_DeleteLocalRef(env, current);
+	jsize slot = jargs_first_free(env, args, _GetArrayLength(env, args));
+	if (slot >= 0) {
+		_SetObjectArrayElement(env, args, slot, obj);
+		return;
 	}
 	XJNI_LOGE("JArgsAppendObject", "jobjectArray is full, cannot append element");
-	_DeleteLocalRef(env, obj);
 }
 
 // Append functions
@@ -285,11 +532,15 @@ JNIEXPORTC void JNICALL JArgsDelete(JNIEnv *env, jargs_t args, jsize index) {
 	}
 	jobject old = _GetObjectArrayElement(env, args, index);
 	if (old) _DeleteLocalRef(env, old);
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame, env, len - 1 - index, 1) != JNI_OK) return;
 	for (jsize i = index; i < len - 1; i++) {
+		xjni_frame_next(&frame);
 		jobject next = _GetObjectArrayElement(env, args, i + 1);
 		_SetObjectArrayElement(env, args, i, next);
 		if (next) _DeleteLocalRef(env, next);
 	}
+	xjni_frame_leave(&frame, NULL);
 	_SetObjectArrayElement(env, args, len - 1, NULL);
 }
 
@@ -316,41 +567,286 @@ JNIEXPORTC char* JNICALL GetJArgsStringUTF(JNIEnv *env, jargs_t args, jsize inde
 }
 
 JNIEXPORTC jchar JNICALL GetJArgsChar(JNIEnv *env, jargs_t args, jsize index) {
-	if (!ensureCharacterClass(env)) return '\0';
+	if (!jargs_boxes_resolve(env)) return '\0';
 	jobject obj = GetJArgs(env, args, index);
-	jchar value = _CallCharMethod(env, obj, gCharValue);
+	jchar value = _CallCharMethod(env, obj, gBoxes[JARGS_BOX_CHAR].unbox);
 	_DeleteLocalRef(env, obj);
 	return value;
 }
 
 JNIEXPORTC jboolean JNICALL GetJArgsBoolean(JNIEnv *env, jargs_t args, jsize index) {
-	if (!ensureBooleanClass(env)) return JNI_FALSE;
+	if (!jargs_boxes_resolve(env)) return JNI_FALSE;
+	jobject obj = GetJArgs(env, args, index);
+	jboolean value = _CallBooleanMethod(env, obj, gBoxes[JARGS_BOX_BOOLEAN].unbox);
+	_DeleteLocalRef(env, obj);
+	return value;
+}
+
+JNIEXPORTC jint JNICALL GetJArgsInt(JNIEnv *env, jargs_t args, jsize index) {
+	if (!jargs_boxes_resolve(env)) { return 0; }
 	jobject obj = GetJArgs(env, args, index);
-	jboolean value = _CallBooleanMethod(env, obj, gBooleanValue);
+	jint value = _CallIntMethod(env, obj, gBoxes[JARGS_BOX_INT].unbox);
 	_DeleteLocalRef(env, obj);
 	return value;
 }
 
 JNIEXPORTC jlong JNICALL GetJArgsLong(JNIEnv *env, jargs_t args, jsize index) {
-	if (!ensureLongClass(env)) { return 0; }
+	if (!jargs_boxes_resolve(env)) { return 0; }
 	jobject obj = GetJArgs(env, args, index);
-	jlong value = _CallLongMethod(env, obj, gLongValue);
+	jlong value = _CallLongMethod(env, obj, gBoxes[JARGS_BOX_LONG].unbox);
 	_DeleteLocalRef(env, obj);
 	return value;
 }
 
 JNIEXPORTC jfloat JNICALL GetJArgsFloat(JNIEnv *env, jargs_t args, jsize index) {
-	if (!ensureFloatClass(env)) { return 0.0; }
+	if (!jargs_boxes_resolve(env)) { return 0.0; }
 	jobject obj = GetJArgs(env, args, index);
-	jfloat value = _CallFloatMethod(env, obj, gFloatValue);
+	jfloat value = _CallFloatMethod(env, obj, gBoxes[JARGS_BOX_FLOAT].unbox);
 	_DeleteLocalRef(env, obj);
 	return value;
 }
 
 JNIEXPORTC jdouble JNICALL GetJArgsDouble(JNIEnv *env, jargs_t args, jsize index) {
-	if (!ensureDoubleClass(env)) { return 0.0; }
+	if (!jargs_boxes_resolve(env)) { return 0.0; }
 	jobject obj = GetJArgs(env, args, index);
-	jdouble value = _CallDoubleMethod(env, obj, gDoubleValue);
+	jdouble value = _CallDoubleMethod(env, obj, gBoxes[JARGS_BOX_DOUBLE].unbox);
 	_DeleteLocalRef(env, obj);
 	return value;
 }
+
+JNIEXPORTC jsize JNICALL GetJArgsAll(JNIEnv *env, jargs_t args, jvalue *out, char *types) {
+	if (!env || !args || !out || !types) return -1;
+	if (!jargs_boxes_resolve(env)) return -1;
+	jsize len = _GetArrayLength(env, args);
+
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame, env, len, 2) != JNI_OK) return -1;
+	// elements of one list are mostly of a few types: try the last match first
+	const jargs_box *last = NULL;
+	for (jsize i = 0; i < len; i++) {
+		xjni_frame_next(&frame);
+		jobject obj = _GetObjectArrayElement(env, args, i);
+		out[i].j = 0;
+		if (!obj) {
+			types[i] = '\0';
+			continue;
+		}
+		jclass cls = _GetObjectClass(env, obj);
+		const jargs_box *box = NULL;
+		if (last && _IsSameObject(env, cls, last->cls)) {
+			box = last;
+		} else {
+			for (int k = 0; k < JARGS_BOX_COUNT && !box; k++)
+				if (&gBoxes[k] != last && _IsSameObject(env, cls, gBoxes[k].cls)) box = &gBoxes[k];
+		}
+		_DeleteLocalRef(env, cls);
+		if (box) {
+			types[i] = box->type;
+			jargs_unbox(env, box, obj, &out[i]);
+			last = box;
+		} else {
+			types[i] = 'L';
+			out[i].l = NULL;
+		}
+		_DeleteLocalRef(env, obj);
+	}
+	xjni_frame_leave(&frame, NULL);
+	return len;
+}
+
+// Staged argument: a JNI type tag ('Z' 'C' 'I' 'J' 'F' 'D', 'L' for a caller
+// owned object, 'U' for an owned UTF-8 copy) and its value
+typedef struct jargs_staged {
+	char type;
+	jvalue value;
+	char *utf;
+} jargs_staged;
+
+struct jargs_stage {
+	jargs_staged *items;
+	jsize count;
+	jsize capacity;
+};
+
+JNIEXPORTC jargs_stage_t* JNICALL JArgsStageNew(jsize capacity) {
+	jargs_stage_t *stage = (jargs_stage_t *)calloc(1, sizeof(jargs_stage_t));
+	if (!stage) return NULL;
+	if (capacity > 0) {
+		stage->items = (jargs_staged *)malloc(sizeof(jargs_staged) * (size_t)capacity);
+		if (!stage->items) {
+			free(stage);
+			return NULL;
+		}
+		stage->capacity = capacity;
+	}
+	return stage;
+}
+
+JNIEXPORTC void JNICALL JArgsStageClear(jargs_stage_t *stage) {
+	if (!stage) return;
+	for (jsize i = 0; i < stage->count; i++)
+		free(stage->items[i].utf);
+	stage->count = 0;
+}
+
+JNIEXPORTC void JNICALL JArgsStageFree(jargs_stage_t *stage) {
+	if (!stage) return;
+	JArgsStageClear(stage);
+	free(stage->items);
+	free(stage);
+}
+
+JNIEXPORTC jsize JNICALL JArgsStageSize(const jargs_stage_t *stage) {
+	return stage ? stage->count : 0;
+}
+
+// Slot to fill for op, NULL on error; no JNI calls
+static jargs_staged *jargs_stage_slot(jargs_stage_t *stage, jargs_op_t op, jsize index) {
+	if (!stage) return NULL;
+	if (op == JARGS_OP_REPLACE) {
+		if (index < 0 || index >= stage->count) {
+			XJNI_LOGE("jargs_stage_slot", "Index out of bounds");
+			return NULL;
+		}
+		free(stage->items[index].utf);
+		stage->items[index].utf = NULL;
+		return &stage->items[index];
+	}
+	if (op == JARGS_OP_APPEND) index = stage->count;
+	if (index < 0 || index > stage->count) {
+		XJNI_LOGE("jargs_stage_slot", "Index out of bounds");
+		return NULL;
+	}
+	if (stage->count == stage->capacity) {
+		jsize capacity = stage->capacity ? stage->capacity * 2 : 8;
+		jargs_staged *items = (jargs_staged *)realloc(stage->items, sizeof(jargs_staged) * (size_t)capacity);
+		if (!items) {
+			XJNI_LOGE("jargs_stage_slot", "Out of memory");
+			return NULL;
+		}
+		stage->items = items;
+		stage->capacity = capacity;
+	}
+	memmove(&stage->items[index + 1], &stage->items[index], sizeof(jargs_staged) * (size_t)(stage->count - index));
+	stage->count++;
+	stage->items[index].utf = NULL;
+	return &stage->items[index];
+}
+
+#define DEFINE_JARGS_STAGE_FUNCS(name, jtype, tag, member) \
+JNIEXPORTC void JNICALL JArgsStageAppend##name(jargs_stage_t *stage, jtype val) { \
+	jargs_staged *slot = jargs_stage_slot(stage, JARGS_OP_APPEND, 0); \
+	if (slot) { slot->type = tag; slot->value.member = val; } \
+} \
+\
+JNIEXPORTC void JNICALL JArgsStageInsert##name(jargs_stage_t *stage, jtype val, jsize index) { \
+	jargs_staged *slot = jargs_stage_slot(stage, JARGS_OP_INSERT, index); \
+	if (slot) { slot->type = tag; slot->value.member = val; } \
+} \
+\
+JNIEXPORTC void JNICALL JArgsStageReplace##name(jargs_stage_t *stage, jtype val, jsize index) { \
+	jargs_staged *slot = jargs_stage_slot(stage, JARGS_OP_REPLACE, index); \
+	if (slot) { slot->type = tag; slot->value.member = val; } \
+}
+
+DEFINE_JARGS_STAGE_FUNCS(Object, jobject, 'L', l)
+DEFINE_JARGS_STAGE_FUNCS(String, jstring, 'L', l)
+DEFINE_JARGS_STAGE_FUNCS(Char, jchar, 'C', c)
+DEFINE_JARGS_STAGE_FUNCS(Boolean, jboolean, 'Z', z)
+DEFINE_JARGS_STAGE_FUNCS(Int, jint, 'I', i)
+DEFINE_JARGS_STAGE_FUNCS(Long, jlong, 'J', j)
+DEFINE_JARGS_STAGE_FUNCS(Float, jfloat, 'F', f)
+DEFINE_JARGS_STAGE_FUNCS(Double, jdouble, 'D', d)
+
+static void jargs_stage_utf(jargs_stage_t *stage, const char *utf, jargs_op_t op, jsize index) {
+	if (!utf) return;
+	char *copy = strdup(utf);
+	if (!copy) return;
+	jargs_staged *slot = jargs_stage_slot(stage, op, index);
+	if (!slot) {
+		free(copy);
+		return;
+	}
+	slot->type = 'U';
+	slot->value.l = NULL;
+	slot->utf = copy;
+}
+
+JNIEXPORTC void JNICALL JArgsStageAppendStringUTF(jargs_stage_t *stage, const char *utf) {
+	jargs_stage_utf(stage, utf, JARGS_OP_APPEND, 0);
+}
+
+JNIEXPORTC void JNICALL JArgsStageInsertStringUTF(jargs_stage_t *stage, const char *utf, jsize index) {
+	jargs_stage_utf(stage, utf, JARGS_OP_INSERT, index);
+}
+
+JNIEXPORTC void JNICALL JArgsStageReplaceStringUTF(jargs_stage_t *stage, const char *utf, jsize index) {
+	jargs_stage_utf(stage, utf, JARGS_OP_REPLACE, index);
+}
+
+JNIEXPORTC void JNICALL JArgsStageDelete(jargs_stage_t *stage, jsize index) {
+	if (!stage) return;
+	if (index < 0 || index >= stage->count) {
+		XJNI_LOGE("JArgsStageDelete", "Index out of bounds");
+		return;
+	}
+	free(stage->items[index].utf);
+	stage->count--;
+	memmove(&stage->items[index], &stage->items[index + 1], sizeof(jargs_staged) * (size_t)(stage->count - index));
+}
+
+// Box one staged value, from the preloaded tables when possible; *owned tells
+// whether the result is a new local reference
+static jobject jargs_stage_box(JNIEnv *env, const jargs_staged *item, jboolean *owned) {
+	*owned = JNI_FALSE;
+	if (item->type == 'L') return item->value.l;
+	*owned = JNI_TRUE;
+	if (item->type == 'U') return _NewStringUTF(env, item->utf);
+	if (!jargs_boxes_resolve(env)) return NULL;
+	for (int k = 0; k < JARGS_BOX_COUNT; k++) {
+		const jargs_box *box = &gBoxes[k];
+		if (box->type != item->type) continue;
+		jobject cached = jargs_box_cached(box, &item->value);
+		if (cached) {
+			*owned = JNI_FALSE;
+			return cached;
+		}
+		return _CallStaticObjectMethodA(env, box->cls, box->valueOf, &item->value);
+	}
+	return NULL;
+}
+
+JNIEXPORTC jargs_t JNICALL JArgsStageToJArgs(JNIEnv *env, const jargs_stage_t *stage) {
+	if (!env || !stage) return NULL;
+	jclass objCls = _FindClass(env, "java/lang/Object");
+	if (!objCls) return NULL;
+	jargs_t args = _NewObjectArray(env, stage->count, objCls, NULL);
+	_DeleteLocalRef(env, objCls);
+	if (!args) return NULL;
+
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame, env, stage->count, 1) != JNI_OK) {
+		_DeleteLocalRef(env, args);
+		return NULL;
+	}
+	jboolean failed = JNI_FALSE;
+	for (jsize i = 0; i < stage->count; i++) {
+		xjni_frame_next(&frame);
+		jboolean owned;
+		jobject obj = jargs_stage_box(env, &stage->items[i], &owned);
+		if (_ExceptionCheck(env)) {
+			failed = JNI_TRUE;
+			break;
+		}
+		if (!obj) continue;
+		_SetObjectArrayElement(env, args, i, obj);
+		if (owned) _DeleteLocalRef(env, obj);
+	}
+	xjni_frame_leave(&frame, NULL);
+	if (failed) {
+		XJNI_LOGE("JArgsStageToJArgs", "Boxing a staged argument threw");
+		_DeleteLocalRef(env, args);
+		return NULL;
+	}
+	return args;
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include <jni.h>
 
 #define LOG_TAG "xjni"
@@ -10,7 +11,7 @@
 
 #include <xjni.h>
 
-#define DEFINE_ARRAY_FIELD_GETTERS_SETTERS(type,jtype) \
+#define DEFINE_ARRAY_FIELD_GETTERS_SETTERS(type,jtype,sig) \
 JNIEXPORTC j##jtype##Array JNICALL Get##type##ArrayField(JNIEnv *env,jobject obj,jfieldID fid) { \
 	return ubase_cast(j##jtype##Array,GetObjectArrayField(env,obj,fid)); \
 } \
@@ -22,6 +23,132 @@ JNIEXPORTC void JNICALL Set##type##ArrayField(JNIEnv *env,jobject obj,jfieldID f
 }\
 JNIEXPORTC void JNICALL SetStatic##type##ArrayField(JNIEnv *env,jclass cls,jfieldID fid,j##jtype##Array value) {\
 	SetStaticObjectArrayField(env,cls,fid,ubase_cast(jobjectArray,value));\
+}\
+JNIEXPORTC j##jtype##Array JNICALL Get##type##ArrayFieldByName(JNIEnv *env,jobject obj,const char *name) {\
+	return Get##type##ArrayField(env,obj,field_of(env,obj,name,sig));\
+}\
+JNIEXPORTC j##jtype##Array JNICALL GetStatic##type##ArrayFieldByName(JNIEnv *env,jclass cls,const char *name) {\
+	return GetStatic##type##ArrayField(env,cls,field_lookup(env,cls,name,sig,JNI_TRUE));\
+}\
+JNIEXPORTC void JNICALL Set##type##ArrayFieldByName(JNIEnv *env,jobject obj,const char *name,j##jtype##Array value) {\
+	Set##type##ArrayField(env,obj,field_of(env,obj,name,sig),value);\
+}\
+JNIEXPORTC void JNICALL SetStatic##type##ArrayFieldByName(JNIEnv *env,jclass cls,const char *name,j##jtype##Array value) {\
+	SetStatic##type##ArrayField(env,cls,field_lookup(env,cls,name,sig,JNI_TRUE),value);\
+}\
+JNIEXPORTC j##jtype* JNICALL Get##type##ArrayFieldElements(JNIEnv *env,jobject obj,const char *name,j##jtype##Array *array,jboolean *isCopy) {\
+	if (array == NULL) return NULL;\
+	*array = Get##type##ArrayFieldByName(env,obj,name);\
+	if (*array == NULL) return NULL;\
+	j##jtype *elems = _Get##type##ArrayElements(env,*array,isCopy);\
+	if (elems == NULL) {\
+		_DeleteLocalRef(env,*array);\
+		*array = NULL;\
+	}\
+	return elems;\
+}\
+JNIEXPORTC void JNICALL Release##type##ArrayFieldElements(JNIEnv *env,j##jtype##Array array,j##jtype *elems,jint mode) {\
+	if (array == NULL) return;\
+	if (elems != NULL) _Release##type##ArrayElements(env,array,elems,mode);\
+	_DeleteLocalRef(env,array);\
+}
+
+/*
+ * Field ID cache: open addressing over immutable entries published with a
+ * compare-and-swap, so lookups never lock. Entries hold a weak reference to
+ * their class and live until XJNI_ArrayField_OnUnload(); when the probe
+ * window is full the ID is simply not cached.
+ */
+#define FIELD_CACHE_PROBES 16
+
+typedef struct field_entry {
+	jweak cls;
+	jfieldID fid;
+	uint32_t hash;
+	jboolean isStatic;
+	char key[]; /* name, NUL, signature, NUL */
+} field_entry;
+
+static _Atomic(field_entry*) fieldCache[XJNI_FIELD_CACHE_SIZE];
+
+static uint32_t field_hash(const char *name,const char *sig,jboolean isStatic) {
+	uint32_t h = 2166136261u;
+	for (const char *p = name; *p; p++) h = (h ^ base_cast(unsigned char,*p)) * 16777619u;
+	h = (h ^ 0xFFu) * 16777619u;
+	for (const char *p = sig; *p; p++) h = (h ^ base_cast(unsigned char,*p)) * 16777619u;
+	return h ^ base_cast(uint32_t,isStatic);
+}
+
+static jboolean field_match(JNIEnv *env,const field_entry *e,jclass cls,const char *name,const char *sig,uint32_t hash,jboolean isStatic) {
+	if (e->hash != hash || e->isStatic != isStatic) return JNI_FALSE;
+	if (strcmp(e->key,name) != 0 || strcmp(e->key + strlen(e->key) + 1,sig) != 0) return JNI_FALSE;
+	return _IsSameObject(env,e->cls,cls);
+}
+
+static jfieldID field_lookup(JNIEnv *env,jclass cls,const char *name,const char *sig,jboolean isStatic) {
+	if (env == NULL || cls == NULL || name == NULL || sig == NULL) return NULL;
+	uint32_t hash = field_hash(name,sig,isStatic);
+	for (uint32_t i = 0; i < FIELD_CACHE_PROBES; i++) {
+		field_entry *e = atomic_load_explicit(&fieldCache[(hash + i) & (XJNI_FIELD_CACHE_SIZE - 1)],memory_order_acquire);
+		if (e == NULL) break;
+		if (field_match(env,e,cls,name,sig,hash,isStatic)) return e->fid;
+	}
+
+	jfieldID fid = isStatic ? _GetStaticFieldID(env,cls,name,sig) : _GetFieldID(env,cls,name,sig);
+	if (fid == NULL) return NULL;
+
+	size_t nameLen = strlen(name),sigLen = strlen(sig);
+	field_entry *entry = ubase_cast(field_entry*,malloc(sizeof(field_entry) + nameLen + sigLen + 2));
+	if (entry == NULL) return fid;
+	entry->cls = _NewWeakGlobalRef(env,cls);
+	if (entry->cls == NULL) {
+		free(entry);
+		return fid;
+	}
+	entry->fid = fid;
+	entry->hash = hash;
+	entry->isStatic = isStatic;
+	memcpy(entry->key,name,nameLen + 1);
+	memcpy(entry->key + nameLen + 1,sig,sigLen + 1);
+	for (uint32_t i = 0; i < FIELD_CACHE_PROBES; i++) {
+		field_entry *expected = NULL;
+		if (atomic_compare_exchange_strong_explicit(&fieldCache[(hash + i) & (XJNI_FIELD_CACHE_SIZE - 1)],
+				&expected,entry,memory_order_acq_rel,memory_order_acquire))
+			return fid;
+	}
+	_DeleteWeakGlobalRef(env,entry->cls);
+	free(entry);
+	return fid;
+}
+
+JNIEXPORTC jfieldID JNICALL xjni_GetFieldIDCached(JNIEnv *env,jclass cls,const char *name,const char *sig) {
+	return field_lookup(env,cls,name,sig,JNI_FALSE);
+}
+
+JNIEXPORTC jfieldID JNICALL xjni_GetStaticFieldIDCached(JNIEnv *env,jclass cls,const char *name,const char *sig) {
+	return field_lookup(env,cls,name,sig,JNI_TRUE);
+}
+
+JNIEXPORTC void JNICALL XJNI_ArrayField_OnUnload(JavaVM* vm,void* reserved,jint ver) {
+	JNIEnv* env = NULL;
+	(void)reserved;
+	if (_GetEnv(vm,(void**)&env,ver) != JNI_OK)
+		return;
+	for (size_t i = 0; i < XJNI_FIELD_CACHE_SIZE; i++) {
+		field_entry *e = atomic_exchange_explicit(&fieldCache[i],NULL,memory_order_acq_rel);
+		if (e == NULL) continue;
+		_DeleteWeakGlobalRef(env,e->cls);
+		free(e);
+	}
+}
+
+/* Field ID of an instance field of @p obj's class; NULL if @p obj is NULL or the field is missing. */
+static jfieldID field_of(JNIEnv *env,jobject obj,const char *name,const char *sig) {
+	if (env == NULL || obj == NULL) return NULL;
+	jclass cls = _GetObjectClass(env,obj);
+	jfieldID fid = field_lookup(env,cls,name,sig,JNI_FALSE);
+	_DeleteLocalRef(env,cls);
+	return fid;
 }
 
 // ObjectArray
@@ -59,11 +186,31 @@ JNIEXPORTC void JNICALL SetArrayField(JNIEnv *env,jobject obj,jfieldID fid,jarra
 }
 
 JNIEXPORTC void JNICALL SetStaticArrayField(JNIEnv *env,jclass cls,jfieldID fid,jarray value) {
-	SetObjectArrayField(env,cls,fid,ubase_cast(jobjectArray,value));
+	SetStaticObjectArrayField(env,cls,fid,ubase_cast(jobjectArray,value));
+}
+
+// ByName
+JNIEXPORTC jobjectArray JNICALL GetObjectArrayFieldByName(JNIEnv *env,jobject obj,const char *name,const char *sig) {
+	return GetObjectArrayField(env,obj,field_of(env,obj,name,sig));
+}
+
+JNIEXPORTC jobjectArray JNICALL GetStaticObjectArrayFieldByName(JNIEnv *env,jclass cls,const char *name,const char *sig) {
+	return GetStaticObjectArrayField(env,cls,field_lookup(env,cls,name,sig,JNI_TRUE));
+}
+
+JNIEXPORTC void JNICALL SetObjectArrayFieldByName(JNIEnv *env,jobject obj,const char *name,const char *sig,jobjectArray value) {
+	SetObjectArrayField(env,obj,field_of(env,obj,name,sig),value);
+}
+
+JNIEXPORTC void JNICALL SetStaticObjectArrayFieldByName(JNIEnv *env,jclass cls,const char *name,const char *sig,jobjectArray value) {
+	SetStaticObjectArrayField(env,cls,field_lookup(env,cls,name,sig,JNI_TRUE),value);
 }
 
-DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Byte,byte)
-DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Int,int)
-DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Long,long)
-DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Float,float)
-DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Double,double)
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Boolean,boolean,"[Z")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Byte,byte,"[B")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Char,char,"[C")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Short,short,"[S")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Int,int,"[I")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Long,long,"[J")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Float,float,"[F")
+DEFINE_ARRAY_FIELD_GETTERS_SETTERS(Double,double,"[D")
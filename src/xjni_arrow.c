@@ -0,0 +1,457 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jni.h>
+
+#define LOG_TAG "xjni"
+#include "base-jni.h"
+
+#include <xjni.h>
+#include "xjni_frame.h"
+
+/* Producer data of every exported node: owned buffers and at most one child. */
+typedef struct arrow_array_private {
+	const void *buffers[3];
+	struct ArrowArray *children[1];
+	struct ArrowArray child;
+} arrow_array_private;
+
+typedef struct arrow_schema_private {
+	char format[32];
+	struct ArrowSchema *children[1];
+	struct ArrowSchema child;
+} arrow_schema_private;
+
+static const char *arrow_format(xjni_ElementType type) {
+	switch (type) {
+		case XJNI_TYPE_BOOLEAN: return "b";
+		case XJNI_TYPE_BYTE: return "c";
+		case XJNI_TYPE_CHAR: return "S";
+		case XJNI_TYPE_SHORT: return "s";
+		case XJNI_TYPE_INT: return "i";
+		case XJNI_TYPE_LONG: return "l";
+		case XJNI_TYPE_FLOAT: return "f";
+		case XJNI_TYPE_DOUBLE: return "g";
+		default: return NULL;
+	}
+}
+
+/* Element type of a primitive Arrow format, 0 if it has no Java counterpart. */
+static xjni_ElementType arrow_type(const char *format) {
+	if (format == NULL || format[0] == '\0' || format[1] != '\0') return base_cast(xjni_ElementType,0);
+	switch (format[0]) {
+		case 'b': return XJNI_TYPE_BOOLEAN;
+		case 'c': return XJNI_TYPE_BYTE;
+		case 'S': return XJNI_TYPE_CHAR;
+		case 's': return XJNI_TYPE_SHORT;
+		case 'i': return XJNI_TYPE_INT;
+		case 'l': return XJNI_TYPE_LONG;
+		case 'f': return XJNI_TYPE_FLOAT;
+		case 'g': return XJNI_TYPE_DOUBLE;
+		default: return base_cast(xjni_ElementType,0);
+	}
+}
+
+static inline int arrow_bit(const void *bitmap,int64_t i) {
+	return (ubase_cast(const uint8_t*,bitmap)[i >> 3] >> (i & 7)) & 1;
+}
+
+static void arrow_release_array(struct ArrowArray *array) {
+	if (array == NULL || array->release == NULL) return;
+	arrow_array_private *priv = ubase_cast(arrow_array_private*,array->private_data);
+	if (array->n_children > 0 && priv->children[0]->release != NULL)
+		priv->children[0]->release(priv->children[0]);
+	for (int i = 0; i < 3; i++)
+		free(ubase_cast(void*,priv->buffers[i]));
+	free(priv);
+	array->release = NULL;
+}
+
+static void arrow_release_schema(struct ArrowSchema *schema) {
+	if (schema == NULL || schema->release == NULL) return;
+	arrow_schema_private *priv = ubase_cast(arrow_schema_private*,schema->private_data);
+	if (schema->n_children > 0 && priv->children[0]->release != NULL)
+		priv->children[0]->release(priv->children[0]);
+	free(priv);
+	schema->release = NULL;
+}
+
+/* Set up @p out as a released-by-us node; its buffers are filled by the caller. */
+static arrow_array_private *arrow_array_init(struct ArrowArray *out,int64_t length,int64_t n_buffers) {
+	arrow_array_private *priv = ubase_cast(arrow_array_private*,calloc(1,sizeof(arrow_array_private)));
+	if (priv == NULL) return NULL;
+	memset(out,0,sizeof(*out));
+	out->length = length;
+	out->n_buffers = n_buffers;
+	out->buffers = priv->buffers;
+	out->release = arrow_release_array;
+	out->private_data = priv;
+	return priv;
+}
+
+static arrow_schema_private *arrow_schema_init(struct ArrowSchema *schema,const char *format,const char *name,int64_t flags) {
+	arrow_schema_private *priv = ubase_cast(arrow_schema_private*,calloc(1,sizeof(arrow_schema_private)));
+	if (priv == NULL) return NULL;
+	snprintf(priv->format,sizeof(priv->format),"%s",format);
+	memset(schema,0,sizeof(*schema));
+	schema->format = priv->format;
+	schema->name = name;
+	schema->flags = flags;
+	schema->release = arrow_release_schema;
+	schema->private_data = priv;
+	return priv;
+}
+
+/* Bit-pack @p count flags (set when @p values[i] != @p unset); NULL on allocation failure. */
+static uint8_t *arrow_pack_bits(const jboolean *values,int64_t count,jboolean unset,int64_t *unset_count) {
+	uint8_t *bits = ubase_cast(uint8_t*,calloc(base_cast(size_t,(count + 7) / 8) + 1,1));
+	if (bits == NULL) return NULL;
+	int64_t n = 0;
+	for (int64_t i = 0; i < count; i++) {
+		if (values[i] != unset) bits[i >> 3] |= base_cast(uint8_t,1u << (i & 7));
+		else n++;
+	}
+	if (unset_count) *unset_count = n;
+	return bits;
+}
+
+/* Copy @p len elements of @p array; booleans come back bit-packed. */
+static void *arrow_copy_values(JNIEnv *env,xjni_ElementType type,jarray array,jsize len) {
+	size_t esize = xjni_ElementSize(type);
+	void *values = malloc(base_cast(size_t,len) * esize + 1);
+	if (values == NULL) return NULL;
+	GetPrimitiveArrayRegion(env,type,array,0,len,values);
+	if (_ExceptionCheck(env)) {
+		free(values);
+		return NULL;
+	}
+	if (type != XJNI_TYPE_BOOLEAN) return values;
+	uint8_t *bits = arrow_pack_bits(ubase_cast(const jboolean*,values),len,JNI_FALSE,NULL);
+	free(values);
+	return bits;
+}
+
+static void arrow_export_failed(struct ArrowArray *out,struct ArrowSchema *schema) {
+	arrow_release_array(out);
+	arrow_release_schema(schema);
+	BASE_LOGE("Arrow export failed\n");
+}
+
+JNIEXPORTC jint JNICALL xjni_ExportArrowArray(JNIEnv *env,jarray array,xjni_ElementType type,struct ArrowArray *out,struct ArrowSchema *schema) {
+	const char *format = arrow_format(type);
+	if (env == NULL || array == NULL || out == NULL || schema == NULL || format == NULL) return JNI_ERR;
+	out->release = NULL;
+	schema->release = NULL;
+
+	jsize len = _GetArrayLength(env,array);
+	arrow_array_private *priv = arrow_array_init(out,len,2);
+	if (priv == NULL || arrow_schema_init(schema,format,"",0) == NULL ||
+		(priv->buffers[1] = arrow_copy_values(env,type,array,len)) == NULL) {
+		arrow_export_failed(out,schema);
+		return JNI_ERR;
+	}
+	return JNI_OK;
+}
+
+JNIEXPORTC jint JNICALL xjni_Export2DArrowArray(JNIEnv *env,jobjectArray array,xjni_ElementType type,struct ArrowArray *out,struct ArrowSchema *schema) {
+	const char *format = arrow_format(type);
+	if (env == NULL || array == NULL || out == NULL || schema == NULL || format == NULL) return JNI_ERR;
+	out->release = NULL;
+	schema->release = NULL;
+
+	size_t esize = xjni_ElementSize(type);
+	jsize rows = _GetArrayLength(env,array);
+	int64_t *offsets = ubase_cast(int64_t*,malloc((base_cast(size_t,rows) + 1) * sizeof(int64_t)));
+	jboolean *nulls = ubase_cast(jboolean*,calloc(base_cast(size_t,rows) + 1,1));
+	char *values = NULL;
+	size_t capacity = 0;
+	jboolean uniform = JNI_TRUE;
+	jint ret = (offsets && nulls) ? JNI_OK : JNI_ERR;
+
+	xjni_frame_t frame;
+	if (ret == JNI_OK && xjni_frame_enter(&frame,env,rows,1) != JNI_OK) ret = JNI_ERR;
+	if (ret == JNI_OK) {
+		offsets[0] = 0;
+		for (jsize i = 0; i < rows && ret == JNI_OK; i++) {
+			xjni_frame_next(&frame);
+			jarray row = ubase_cast(jarray,_GetObjectArrayElement(env,array,i));
+			jsize len = row ? _GetArrayLength(env,row) : 0;
+			offsets[i + 1] = offsets[i] + len;
+			if (row == NULL) {
+				nulls[i] = JNI_TRUE;
+				uniform = JNI_FALSE;
+				continue;
+			}
+			if (len != offsets[1]) uniform = JNI_FALSE;
+			size_t need = base_cast(size_t,offsets[i + 1]) * esize;
+			if (need > capacity) {
+				size_t grown = capacity ? capacity * 2 : 4096;
+				while (grown < need) grown *= 2;
+				char *next = ubase_cast(char*,realloc(values,grown));
+				if (next == NULL) ret = JNI_ERR;
+				else { values = next; capacity = grown; }
+			}
+			if (ret == JNI_OK && len > 0) {
+				GetPrimitiveArrayRegion(env,type,row,0,len,values + base_cast(size_t,offsets[i]) * esize);
+				if (_ExceptionCheck(env)) ret = JNI_ERR;
+			}
+			_DeleteLocalRef(env,row);
+		}
+		xjni_frame_leave(&frame,NULL);
+	}
+	if (ret != JNI_OK) {
+		free(offsets); free(nulls); free(values);
+		BASE_LOGE("Arrow export failed\n");
+		return JNI_ERR;
+	}
+
+	int64_t total = offsets[rows];
+	if (type == XJNI_TYPE_BOOLEAN) {
+		uint8_t *bits = arrow_pack_bits(ubase_cast(const jboolean*,values ? values : ""),values ? total : 0,JNI_FALSE,NULL);
+		free(values);
+		values = ubase_cast(char*,bits);
+	} else if (values == NULL) {
+		values = ubase_cast(char*,malloc(1));
+	}
+
+	/* FixedSizeList for rectangular arrays, List otherwise */
+	char list[32];
+	int64_t null_count = 0;
+	uint8_t *validity = NULL;
+	void *list_offsets = NULL;
+	uniform = (uniform && rows > 0) ? JNI_TRUE : JNI_FALSE;
+	if (uniform) {
+		snprintf(list,sizeof(list),"+w:%lld",base_cast(long long,offsets[1]));
+	} else {
+		validity = arrow_pack_bits(nulls,rows,JNI_TRUE,&null_count);
+		if (null_count == 0) { free(validity); validity = NULL; }
+		if (total <= INT32_MAX) {
+			int32_t *narrow = ubase_cast(int32_t*,malloc((base_cast(size_t,rows) + 1) * sizeof(int32_t)));
+			if (narrow != NULL)
+				for (jsize i = 0; i <= rows; i++) narrow[i] = base_cast(int32_t,offsets[i]);
+			list_offsets = narrow;
+			snprintf(list,sizeof(list),"+l");
+		} else {
+			list_offsets = offsets;
+			offsets = NULL;
+			snprintf(list,sizeof(list),"+L");
+		}
+	}
+	free(offsets);
+	free(nulls);
+
+	arrow_array_private *priv = arrow_array_init(out,rows,uniform ? 1 : 2);
+	arrow_schema_private *spriv = priv ? arrow_schema_init(schema,list,"",ARROW_FLAG_NULLABLE) : NULL;
+	if (priv == NULL || spriv == NULL || values == NULL || (!uniform && list_offsets == NULL)) {
+		free(values); free(validity); free(list_offsets);
+		arrow_export_failed(out,schema);
+		return JNI_ERR;
+	}
+	priv->buffers[0] = validity;
+	priv->buffers[1] = list_offsets;
+	out->null_count = null_count;
+	priv->children[0] = &priv->child;
+	out->children = priv->children;
+	out->n_children = 1;
+	spriv->children[0] = &spriv->child;
+	schema->children = spriv->children;
+	schema->n_children = 1;
+
+	arrow_array_private *cpriv = arrow_array_init(&priv->child,total,2);
+	if (cpriv == NULL || arrow_schema_init(&spriv->child,format,"item",0) == NULL) {
+		free(values);
+		arrow_export_failed(out,schema);
+		return JNI_ERR;
+	}
+	cpriv->buffers[1] = values;
+	return JNI_OK;
+}
+
+JNIEXPORTC jint JNICALL xjni_ExportArrowStringArray(JNIEnv *env,jobjectArray array,struct ArrowArray *out,struct ArrowSchema *schema) {
+	if (env == NULL || array == NULL || out == NULL || schema == NULL) return JNI_ERR;
+	out->release = NULL;
+	schema->release = NULL;
+
+	jutf8packed_t *packed = GetStringUTF8ArrayPacked(env,array);
+	if (packed == NULL) return JNI_ERR;
+	jsize count = packed->count;
+	int64_t total = 0;
+	for (jsize i = 0; i < count; i++)
+		total += packed->lengths[i];
+	jboolean wide = (total > INT32_MAX) ? JNI_TRUE : JNI_FALSE;
+
+	int64_t null_count = 0;
+	uint8_t *validity = arrow_pack_bits(packed->nulls,count,JNI_TRUE,&null_count);
+	void *offsets = malloc((base_cast(size_t,count) + 1) * (wide ? sizeof(int64_t) : sizeof(int32_t)));
+	char *data = ubase_cast(char*,malloc(base_cast(size_t,total) + 1));
+	arrow_array_private *priv = (validity && offsets && data) ? arrow_array_init(out,count,3) : NULL;
+	if (priv == NULL || arrow_schema_init(schema,wide ? "U" : "u","",ARROW_FLAG_NULLABLE) == NULL) {
+		ReleaseStringUTF8ArrayPacked(packed);
+		free(validity); free(offsets); free(data);
+		arrow_export_failed(out,schema);
+		return JNI_ERR;
+	}
+
+	/* Drop the NUL after every element while copying into the contiguous data buffer. */
+	int64_t pos = 0;
+	for (jsize i = 0; i < count; i++) {
+		if (wide) ubase_cast(int64_t*,offsets)[i] = pos;
+		else ubase_cast(int32_t*,offsets)[i] = base_cast(int32_t,pos);
+		memcpy(data + pos,packed->data + packed->offsets[i],base_cast(size_t,packed->lengths[i]));
+		pos += packed->lengths[i];
+	}
+	if (wide) ubase_cast(int64_t*,offsets)[count] = pos;
+	else ubase_cast(int32_t*,offsets)[count] = base_cast(int32_t,pos);
+	ReleaseStringUTF8ArrayPacked(packed);
+
+	if (null_count == 0) { free(validity); validity = NULL; }
+	priv->buffers[0] = validity;
+	priv->buffers[1] = offsets;
+	priv->buffers[2] = data;
+	out->null_count = null_count;
+	return JNI_OK;
+}
+
+static inline jboolean arrow_valid(const struct ArrowArray *array,int64_t i) {
+	const void *validity = array->n_buffers > 0 ? array->buffers[0] : NULL;
+	return (validity == NULL || array->null_count == 0 || arrow_bit(validity,i)) ? JNI_TRUE : JNI_FALSE;
+}
+
+/*
+ * Java array of @p len values of @p values starting at logical index @p begin.
+ * Values without nulls go straight from the Arrow buffer to the Java array.
+ */
+static jarray arrow_import_values(JNIEnv *env,xjni_ElementType type,const struct ArrowArray *values,int64_t begin,jsize len) {
+	if (values->n_buffers < 2 || (len > 0 && values->buffers[1] == NULL)) return NULL;
+	size_t esize = xjni_ElementSize(type);
+	int64_t first = values->offset + begin;
+	jarray result = NewPrimitiveArray(env,type,len);
+	if (result == NULL || len == 0) return result;
+
+	const char *src = ubase_cast(const char*,values->buffers[1]);
+	jboolean direct = (type != XJNI_TYPE_BOOLEAN) ? JNI_TRUE : JNI_FALSE;
+	for (jsize i = 0; direct && i < len; i++)
+		if (!arrow_valid(values,first + i)) direct = JNI_FALSE;
+	if (direct) {
+		SetPrimitiveArrayRegion(env,type,result,0,len,src + base_cast(size_t,first) * esize);
+		return result;
+	}
+
+	char *tmp = ubase_cast(char*,malloc(base_cast(size_t,len) * esize));
+	if (tmp == NULL) {
+		_DeleteLocalRef(env,result);
+		return NULL;
+	}
+	for (jsize i = 0; i < len; i++) {
+		char *dst = tmp + base_cast(size_t,i) * esize;
+		if (!arrow_valid(values,first + i))
+			memset(dst,0,esize);
+		else if (type == XJNI_TYPE_BOOLEAN)
+			*ubase_cast(jboolean*,dst) = arrow_bit(src,first + i) ? JNI_TRUE : JNI_FALSE;
+		else
+			memcpy(dst,src + base_cast(size_t,first + i) * esize,esize);
+	}
+	SetPrimitiveArrayRegion(env,type,result,0,len,tmp);
+	free(tmp);
+	return result;
+}
+
+static jobjectArray arrow_import_strings(JNIEnv *env,const struct ArrowArray *array,jboolean wide) {
+	if (array->n_buffers < 3 || array->buffers[1] == NULL) return NULL;
+	jsize count = base_cast(jsize,array->length);
+	size_t *offsets = ubase_cast(size_t*,malloc((base_cast(size_t,count) + 1) * (sizeof(size_t) + sizeof(jsize) + 1)));
+	if (offsets == NULL) return NULL;
+	jsize *lengths = ubase_cast(jsize*,offsets + count + 1);
+	jboolean *nulls = ubase_cast(jboolean*,lengths + count + 1);
+
+	const char *data = ubase_cast(const char*,array->buffers[2]);
+	for (jsize i = 0; i < count; i++) {
+		int64_t k = array->offset + i;
+		int64_t start = wide ? ubase_cast(const int64_t*,array->buffers[1])[k] : ubase_cast(const int32_t*,array->buffers[1])[k];
+		int64_t end = wide ? ubase_cast(const int64_t*,array->buffers[1])[k + 1] : ubase_cast(const int32_t*,array->buffers[1])[k + 1];
+		nulls[i] = arrow_valid(array,k) ? JNI_FALSE : JNI_TRUE;
+		offsets[i] = base_cast(size_t,start);
+		lengths[i] = nulls[i] ? 0 : base_cast(jsize,end - start);
+	}
+	jobjectArray result = NewStringUTF8ArrayPacked(env,data ? data : "",offsets,lengths,count,nulls);
+	free(offsets);
+	return result;
+}
+
+static jobjectArray arrow_import_list(JNIEnv *env,const struct ArrowArray *array,const struct ArrowSchema *schema) {
+	if (schema->n_children != 1 || array->n_children != 1) return NULL;
+	xjni_ElementType type = arrow_type(schema->children[0]->format);
+	if (type == 0) return NULL;
+	const struct ArrowArray *child = array->children[0];
+
+	int64_t width = 0;
+	const void *offsets = NULL;
+	char kind = schema->format[1];
+	if (kind == 'w') {
+		// "+w:<width>", nothing but decimal digits after the colon
+		if (schema->format[2] != ':' || schema->format[3] < '0' || schema->format[3] > '9') return NULL;
+		char *end = NULL;
+		width = strtoll(schema->format + 3,&end,10);
+		if (*end != '\0' || width > INT32_MAX) return NULL;
+	} else if ((kind == 'l' || kind == 'L') && schema->format[2] == '\0') {
+		if (array->n_buffers < 2 || (offsets = array->buffers[1]) == NULL) return NULL;
+	} else {
+		return NULL;
+	}
+
+	char sig[3] = { '[',base_cast(char,type),'\0' };
+	jclass rowCls = _FindClass(env,sig);
+	if (rowCls == NULL) return NULL;
+	jsize rows = base_cast(jsize,array->length);
+	jobjectArray result = _NewObjectArray(env,rows,rowCls,NULL);
+	_DeleteLocalRef(env,rowCls);
+	if (result == NULL) return NULL;
+
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,rows,1) != JNI_OK) {
+		_DeleteLocalRef(env,result);
+		return NULL;
+	}
+	jboolean failed = JNI_FALSE;
+	for (jsize i = 0; i < rows && !failed; i++) {
+		xjni_frame_next(&frame);
+		int64_t k = array->offset + i;
+		if (!arrow_valid(array,k)) continue;
+		int64_t start,end;
+		if (kind == 'w') { start = k * width; end = start + width; }
+		else if (kind == 'l') { start = ubase_cast(const int32_t*,offsets)[k]; end = ubase_cast(const int32_t*,offsets)[k + 1]; }
+		else { start = ubase_cast(const int64_t*,offsets)[k]; end = ubase_cast(const int64_t*,offsets)[k + 1]; }
+		if (end < start || end - start > INT32_MAX) { failed = JNI_TRUE; break; }
+		jarray row = arrow_import_values(env,type,child,start,base_cast(jsize,end - start));
+		if (row == NULL) { failed = JNI_TRUE; break; }
+		_SetObjectArrayElement(env,result,i,row);
+		_DeleteLocalRef(env,row);
+	}
+	xjni_frame_leave(&frame,NULL);
+	if (failed) {
+		_DeleteLocalRef(env,result);
+		return NULL;
+	}
+	return result;
+}
+
+JNIEXPORTC jobject JNICALL xjni_ImportArrowArray(JNIEnv *env,const struct ArrowArray *array,const struct ArrowSchema *schema) {
+	if (env == NULL || array == NULL || schema == NULL || schema->format == NULL ||
+		array->release == NULL || array->length < 0 || array->length > INT32_MAX)
+		return NULL;
+	const char *format = schema->format;
+	jobject result = NULL;
+
+	xjni_ElementType type = arrow_type(format);
+	if (type != 0)
+		result = arrow_import_values(env,type,array,0,base_cast(jsize,array->length));
+	else if (strcmp(format,"u") == 0 || strcmp(format,"U") == 0)
+		result = arrow_import_strings(env,array,format[0] == 'U' ? JNI_TRUE : JNI_FALSE);
+	else if (format[0] == '+')
+		result = arrow_import_list(env,array,schema);
+
+	if (result == NULL && !_ExceptionCheck(env))
+		BASE_LOGE("Arrow import of format \"%s\" failed\n",format);
+	return result;
+}
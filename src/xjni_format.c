@@ -0,0 +1,1498 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <jni.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+#define LOG_TAG "xjni"
+#include "base-jni.h"
+
+#include <xjni.h>
+#include "xjni_format.h"
+#include "xjni_lock.h"
+
+/*
+ * Native java.util.Formatter subset: %b %s %c %d %o %x %e %f %n %% with
+ * argument indexes ("n$", "<"), the '-' '#' '+' ' ' '0' flags, width and
+ * precision, and the upper-case B S C X E variants. Anything else (%g, %h,
+ * %a, dates, ',' and '(' flags, arguments of other classes) falls back to
+ * String.format. A format is parsed and checked against the decoded
+ * arguments before anything is written, so a fallback never leaves partial
+ * output. Floating-point values use the shortest round-trip digits rounded
+ * half-up, which is how Formatter rounds, and the default locale must format
+ * like Locale.ROOT: this is probed once, and the native path is disabled
+ * when it does not.
+ *
+ * Formats, in either syntax, are compiled once into a program of literal
+ * runs and conversion ops, and kept in a small table of refcounted programs.
+ * C printf ops carry their conversion as a normalized spec ("%-8.3lld",
+ * "%Lf"): running one reads the argument with the right type and formats it
+ * with snprintf. %ls / %S and %lc / %C take jchar strings and characters,
+ * with width and precision counted in units. C programs also run straight
+ * into a jchar buffer (xjni_fmt_vprint16): literal runs are copied from the
+ * UTF-16 source, %s is decoded from UTF-8 and numbers are widened from a
+ * stack buffer. C formats using what the ops do not model (%n, positional
+ * arguments) run as a whole through vsnprintf instead.
+ */
+
+/* Conversions per format handled natively; longer formats fall back */
+#ifndef XJNI_FORMAT_OPS
+#define XJNI_FORMAT_OPS 64
+#endif
+/* Arguments decoded on the stack; more are decoded into the heap */
+#define FMT_STACK_ARGS 32
+/* Format and string argument characters transcoded per stack chunk */
+#define FMT_CHARS 256
+/* Chunks gathered per writev when streaming a String.format result */
+#define FMT_IOV 4
+/* Compiled programs kept, probed FMT_PROBE slots at a time */
+#ifndef XJNI_FORMAT_CACHE
+#define XJNI_FORMAT_CACHE 64
+#endif
+#define FMT_PROBE 4
+/* Longest normalized C conversion spec */
+#define FMT_SPEC 24
+
+#define FMT_MINUS 0x001
+#define FMT_HASH  0x002
+#define FMT_PLUS  0x004
+#define FMT_SPACE 0x008
+#define FMT_ZERO  0x010
+#define FMT_COMMA 0x020
+#define FMT_PAREN 0x040
+#define FMT_PREV  0x080
+#define FMT_UPPER 0x100
+#define FMT_STARW 0x200 // C: width from the arguments
+#define FMT_STARP 0x400 // C: precision from the arguments
+
+#ifdef _WIN32
+#define FMT_NEWLINE "\r\n"
+#else
+#define FMT_NEWLINE "\n"
+#endif
+
+// Literal text followed by one conversion; the last op only has text
+typedef struct fmt_op {
+	size_t lit;       // offset of the literal text in the format
+	size_t litlen;
+	jint arg;         // argument index, -1 for %n, %% and the last op
+	jint width;       // -1 when absent
+	jint precision;   // -1 when absent
+	int flags;
+	char conv;        // lower-case conversion, '\0' for the last op
+	char length;      // C: length modifier, 'H' for hh and 'M' for ll
+	char spec[FMT_SPEC]; // C: spec passed to snprintf
+	size_t lit16;     // C: literal text in a UTF-16 format, in units
+	size_t litlen16;
+} fmt_op;
+
+struct xjni_fmt_prog {
+	int refs;           // table reference plus one per caller
+	int syntax;
+	jboolean utf16;
+	jboolean native;    // ops cover the whole format
+	const void *ptr;    // address the format was compiled from, NULL if keyed by content
+	unsigned hash;      // content hash, 0 when keyed by address
+	size_t len;         // format length in units
+	const void *source; // copy of the format, to verify a match
+	const char *text;   // UTF-8 text, NUL-terminated
+	size_t textlen;
+	jint maxArg;
+	int count;
+	fmt_op ops[];
+};
+
+// Decoded arguments: GetJArgsAll() values plus the String elements
+typedef struct fmt_args {
+	jsize count;
+	jvalue *values;
+	char *types;
+	jobject *objects;
+} fmt_args;
+
+static jclass gStringCls = NULL;
+static jmethodID gFormatMid = NULL;
+static _Atomic int gNative = -1; // -1 not probed, 0 locale differs, 1 native; set last, with release ordering
+static pthread_mutex_t gInitMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static xjni_fmt_prog_t *gProgs[XJNI_FORMAT_CACHE];
+static unsigned gEvict = 0;
+static pthread_mutex_t gProgMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ---- sinks ---- */
+
+void xjni_sink_buffer(xjni_sink_t *sink,char *buf,size_t cap) {
+	sink->buf = buf;
+	sink->cap = cap;
+	sink->fp = NULL;
+	sink->fd = -1;
+	sink->len = 0;
+	sink->used = 0;
+}
+
+void xjni_sink_file(xjni_sink_t *sink,FILE *fp) {
+	xjni_sink_buffer(sink,NULL,0);
+	sink->fp = fp;
+}
+
+void xjni_sink_fd(xjni_sink_t *sink,int fd) {
+	xjni_sink_buffer(sink,NULL,0);
+	sink->fd = fd;
+}
+
+static void sink_write(xjni_sink_t *sink,const char *data,size_t len) {
+	if (sink->fp) {
+		fwrite(data,1,len,sink->fp);
+		return;
+	}
+	while (len > 0 && sink->fd >= 0) {
+#ifdef _WIN32
+		int n = _write(sink->fd,data,(unsigned int)(len > 0x40000000 ? 0x40000000 : len));
+		if (n <= 0) return;
+#else
+		ssize_t n = write(sink->fd,data,len);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return;
+#endif
+		data += n;
+		len -= (size_t)n;
+	}
+}
+
+static void sink_flush(xjni_sink_t *sink) {
+	if (sink->used) sink_write(sink,sink->chunk,sink->used);
+	sink->used = 0;
+}
+
+void xjni_sink_put(xjni_sink_t *sink,const char *data,size_t len) {
+	if (sink->buf) {
+		size_t room = sink->cap ? sink->cap - 1 : 0;
+		if (sink->len < room)
+			memcpy(sink->buf + sink->len,data,len < room - sink->len ? len : room - sink->len);
+		sink->len += len;
+		return;
+	}
+	sink->len += len;
+	if (sink->used + len > XJNI_SINK_CHUNK) {
+		sink_flush(sink);
+		if (len >= XJNI_SINK_CHUNK) {
+			sink_write(sink,data,len);
+			return;
+		}
+	}
+	memcpy(sink->chunk + sink->used,data,len);
+	sink->used += len;
+}
+
+void xjni_sink_finish(xjni_sink_t *sink) {
+	if (sink->buf) {
+		if (sink->cap)
+			sink->buf[sink->len < sink->cap - 1 ? sink->len : sink->cap - 1] = '\0';
+		return;
+	}
+	sink_flush(sink);
+}
+
+static void sink_pad(xjni_sink_t *sink,char c,size_t n) {
+	char run[64];
+	memset(run,c,n < sizeof(run) ? n : sizeof(run));
+	while (n > 0) {
+		size_t k = n < sizeof(run) ? n : sizeof(run);
+		xjni_sink_put(sink,run,k);
+		n -= k;
+	}
+}
+
+/* ---- UTF-16 to UTF-8 ---- */
+
+// Encode one code point (lone surrogates as three bytes); returns the byte count
+static size_t fmt_encode_cp(jint cp,char *out) {
+	if (cp < 0x80) {
+		out[0] = (char)cp;
+		return 1;
+	}
+	if (cp < 0x800) {
+		out[0] = (char)(0xC0 | (cp >> 6));
+		out[1] = (char)(0x80 | (cp & 0x3F));
+		return 2;
+	}
+	if (cp < 0x10000) {
+		out[0] = (char)(0xE0 | (cp >> 12));
+		out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (cp & 0x3F));
+		return 3;
+	}
+	out[0] = (char)(0xF0 | (cp >> 18));
+	out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+	out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+	out[3] = (char)(0x80 | (cp & 0x3F));
+	return 4;
+}
+
+// Encode n units into out (room for 3 * n + 3 bytes); a trailing high
+// surrogate is kept in *high for the next call, 0 flushes it
+static size_t fmt_encode(const jchar *src,jsize n,char *out,jchar *high) {
+	size_t pos = 0;
+	for (jsize i = 0; i < n; i++) {
+		jchar c = src[i];
+		if (*high) {
+			if (c >= 0xDC00 && c <= 0xDFFF) {
+				pos += fmt_encode_cp(0x10000 + (((jint)*high - 0xD800) << 10) + (c - 0xDC00),out + pos);
+				*high = 0;
+				continue;
+			}
+			pos += fmt_encode_cp(*high,out + pos);
+			*high = 0;
+		}
+		if (c >= 0xD800 && c <= 0xDBFF) *high = c;
+		else pos += fmt_encode_cp(c,out + pos);
+	}
+	return pos;
+}
+
+// Write n units to the sink as UTF-8, encoded chunk by chunk on the stack;
+// makes no JNI calls, so the units may be pinned by GetStringCritical
+static void sink_utf16(xjni_sink_t *sink,const jchar *src,size_t n) {
+	char utf[FMT_IOV][FMT_CHARS * 3 + 3];
+	jchar high = 0;
+#ifndef _WIN32
+	if (sink->fd >= 0) {
+		// the pending chunk and up to FMT_IOV encoded chunks per writev
+		struct iovec iov[FMT_IOV + 1];
+		size_t i = 0;
+		while (i < n || high) {
+			int cnt = 0;
+			if (sink->used) {
+				iov[cnt].iov_base = sink->chunk;
+				iov[cnt++].iov_len = sink->used;
+				sink->used = 0;
+			}
+			for (int b = 0; b < FMT_IOV && (i < n || high); b++) {
+				size_t k = n - i < FMT_CHARS ? n - i : FMT_CHARS;
+				size_t bytes = fmt_encode(src + i,(jsize)k,utf[b],&high);
+				i += k;
+				if (i == n && high) {
+					bytes += fmt_encode_cp(high,utf[b] + bytes);
+					high = 0;
+				}
+				iov[cnt].iov_base = utf[b];
+				iov[cnt++].iov_len = bytes;
+				sink->len += bytes;
+			}
+			struct iovec *v = iov;
+			while (cnt > 0) {
+				ssize_t w = writev(sink->fd,v,cnt);
+				if (w < 0 && errno == EINTR) continue;
+				if (w <= 0) return;
+				while (cnt > 0 && (size_t)w >= v->iov_len) {
+					w -= (ssize_t)v->iov_len;
+					v++;
+					cnt--;
+				}
+				if (cnt > 0) {
+					v->iov_base = (char *)v->iov_base + w;
+					v->iov_len -= (size_t)w;
+				}
+			}
+		}
+		return;
+	}
+#endif
+	for (size_t i = 0; i < n; i += FMT_CHARS) {
+		size_t k = n - i < FMT_CHARS ? n - i : FMT_CHARS;
+		xjni_sink_put(sink,utf[0],fmt_encode(src + i,(jsize)k,utf[0],&high));
+	}
+	if (high) xjni_sink_put(sink,utf[0],fmt_encode_cp(high,utf[0]));
+}
+
+/* ---- parsing ---- */
+
+static jboolean fmt_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+// Decimal number at *i; widths past a million are left to Java
+static jboolean fmt_number(const char *f,size_t len,size_t *i,jint *out) {
+	jint v = 0;
+	for (; *i < len && fmt_digit(f[*i]); (*i)++) {
+		v = v * 10 + (f[*i] - '0');
+		if (v > 1000000) return JNI_FALSE;
+	}
+	*out = v;
+	return JNI_TRUE;
+}
+
+static int fmt_flag(char c) {
+	switch (c) {
+		case '-': return FMT_MINUS;
+		case '#': return FMT_HASH;
+		case '+': return FMT_PLUS;
+		case ' ': return FMT_SPACE;
+		case '0': return FMT_ZERO;
+		case ',': return FMT_COMMA;
+		case '(': return FMT_PAREN;
+		case '<': return FMT_PREV;
+		default: return 0;
+	}
+}
+
+// Flag and precision rules of Formatter for the supported conversions
+static jboolean fmt_check_flags(const fmt_op *op) {
+	int flags = op->flags & ~(FMT_PREV | FMT_UPPER);
+	int allowed = 0;
+	jboolean precision = JNI_FALSE;
+	switch (op->conv) {
+		case 'b': case 's': allowed = FMT_MINUS; precision = JNI_TRUE; break;
+		case 'c': case '%': allowed = FMT_MINUS; break;
+		case 'd': allowed = FMT_MINUS | FMT_PLUS | FMT_SPACE | FMT_ZERO; break;
+		case 'o': case 'x': allowed = FMT_MINUS | FMT_HASH | FMT_ZERO; break;
+		case 'e': case 'f': allowed = FMT_MINUS | FMT_HASH | FMT_PLUS | FMT_SPACE | FMT_ZERO; precision = JNI_TRUE; break;
+		case 'n': return !flags && op->width < 0 && op->precision < 0;
+		default: return JNI_FALSE;
+	}
+	if (flags & ~allowed) return JNI_FALSE;
+	if (!precision && op->precision >= 0) return JNI_FALSE;
+	if ((flags & FMT_PLUS) && (flags & FMT_SPACE)) return JNI_FALSE;
+	if ((flags & FMT_MINUS) && (flags & FMT_ZERO)) return JNI_FALSE;
+	if ((flags & (FMT_MINUS | FMT_ZERO)) && op->width < 0) return JNI_FALSE;
+	return JNI_TRUE;
+}
+
+// Split the format into ops; *maxArg receives the highest argument index used
+static jboolean fmt_parse(const char *f,size_t len,fmt_op *ops,int *count,jint *maxArg) {
+	size_t i = 0, lit = 0;
+	int n = 0;
+	jint ordinary = 0, last = -1;
+	*maxArg = -1;
+	while (i < len) {
+		if (f[i] != '%') {
+			i++;
+			continue;
+		}
+		if (n == XJNI_FORMAT_OPS - 1) return JNI_FALSE;
+		fmt_op *op = &ops[n++];
+		op->lit = lit;
+		op->litlen = i - lit;
+		op->arg = -1;
+		op->width = -1;
+		op->precision = -1;
+		op->flags = 0;
+		i++;
+
+		// explicit index: digits followed by '$'
+		jint index = 0;
+		size_t j = i;
+		while (j < len && fmt_digit(f[j])) j++;
+		if (j > i && j < len && f[j] == '$') {
+			if (!fmt_number(f,len,&i,&index) || index < 1) return JNI_FALSE;
+			i++;
+		}
+		for (; i < len; i++) {
+			int bit = fmt_flag(f[i]);
+			if (!bit) break;
+			if (op->flags & bit) return JNI_FALSE;
+			op->flags |= bit;
+		}
+		if (i < len && fmt_digit(f[i]) && !fmt_number(f,len,&i,&op->width)) return JNI_FALSE;
+		if (i < len && f[i] == '.') {
+			i++;
+			if (i >= len || !fmt_digit(f[i]) || !fmt_number(f,len,&i,&op->precision)) return JNI_FALSE;
+		}
+		if (i >= len) return JNI_FALSE;
+
+		char c = f[i++];
+		if (c >= 'A' && c <= 'Z') {
+			if (!strchr("BSCXE",c)) return JNI_FALSE;
+			op->flags |= FMT_UPPER;
+			c = (char)(c - 'A' + 'a');
+		}
+		op->conv = c;
+		if (!fmt_check_flags(op)) return JNI_FALSE;
+		if (c != 'n' && c != '%') {
+			if (op->flags & FMT_PREV) {
+				if (last < 0) return JNI_FALSE;
+				op->arg = last;
+			} else if (index > 0) {
+				op->arg = index - 1;
+			} else {
+				op->arg = ordinary++;
+			}
+			last = op->arg;
+			if (op->arg > *maxArg) *maxArg = op->arg;
+		}
+		lit = i;
+	}
+	ops[n].lit = lit;
+	ops[n].litlen = len - lit;
+	ops[n].arg = -1;
+	ops[n].conv = '\0';
+	*count = n + 1;
+	return JNI_TRUE;
+}
+
+// Append c to the spec of op, keeping room for "ll", the conversion and '\0'
+static jboolean c_spec(fmt_op *op,size_t *n,char c) {
+	if (*n >= FMT_SPEC - 4) return JNI_FALSE;
+	op->spec[(*n)++] = c;
+	return JNI_TRUE;
+}
+
+// C conversion after the '%' at *i; JNI_FALSE for what only vsnprintf handles
+static jboolean c_parse_op(const char *f,size_t len,size_t *i,fmt_op *op) {
+	size_t n = 0;
+	op->spec[n++] = '%';
+	// flags, width and precision are kept as written, and decoded for the strings formatted natively
+	while (*i < len && f[*i] && strchr("-+ #0'",f[*i])) {
+		if (f[*i] == '-') op->flags |= FMT_MINUS;
+		if (!c_spec(op,&n,f[(*i)++])) return JNI_FALSE;
+	}
+	if (*i < len && f[*i] == '*') {
+		op->flags |= FMT_STARW;
+		if (!c_spec(op,&n,f[(*i)++])) return JNI_FALSE;
+	} else if (*i < len && fmt_digit(f[*i])) {
+		size_t start = *i;
+		if (!fmt_number(f,len,i,&op->width)) return JNI_FALSE;
+		for (size_t k = start; k < *i; k++)
+			if (!c_spec(op,&n,f[k])) return JNI_FALSE;
+	}
+	if (*i < len && f[*i] == '$') return JNI_FALSE; // positional argument
+	if (*i < len && f[*i] == '.') {
+		if (!c_spec(op,&n,f[(*i)++])) return JNI_FALSE;
+		op->precision = 0;
+		if (*i < len && f[*i] == '*') {
+			op->flags |= FMT_STARP;
+			if (!c_spec(op,&n,f[(*i)++])) return JNI_FALSE;
+		} else if (*i < len && fmt_digit(f[*i])) {
+			size_t start = *i;
+			if (!fmt_number(f,len,i,&op->precision)) return JNI_FALSE;
+			for (size_t k = start; k < *i; k++)
+				if (!c_spec(op,&n,f[k])) return JNI_FALSE;
+		}
+		if (*i < len && f[*i] == '$') return JNI_FALSE;
+	}
+
+	char length = 0;
+	if (*i < len && f[*i] && strchr("hlqjztL",f[*i])) {
+		length = f[(*i)++];
+		if (length == 'q') length = 'M';
+		else if (*i < len && f[*i] == length && (length == 'h' || length == 'l')) {
+			length = length == 'h' ? 'H' : 'M';
+			(*i)++;
+		}
+	}
+	if (*i >= len) return JNI_FALSE;
+	char c = f[(*i)++];
+	op->length = length;
+	switch (c) {
+		case 'd': case 'i':
+		case 'u': case 'o': case 'x': case 'X':
+			if (length == 'L') return JNI_FALSE;
+			// integers are widened when read, so the spec always says ll
+			op->conv = (c == 'd' || c == 'i') ? 'd' : 'u';
+			op->spec[n++] = 'l';
+			op->spec[n++] = 'l';
+			break;
+		case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+			if (length && length != 'l' && length != 'L') return JNI_FALSE;
+			op->conv = 'f';
+			if (length == 'L') op->spec[n++] = 'L';
+			break;
+		case 'c': case 's':
+			// %lc and %ls take a jchar and a jchar string, like %C and %S
+			if (length && length != 'l') return JNI_FALSE;
+			op->conv = length ? (char)(c - 'a' + 'A') : c;
+			break;
+		case 'C': case 'S':
+			if (length) return JNI_FALSE;
+			op->conv = c;
+			break;
+		case 'p':
+			if (length) return JNI_FALSE;
+			op->conv = c;
+			break;
+		case '%':
+			op->conv = '%';
+			break;
+		default:
+			return JNI_FALSE;
+	}
+	op->spec[n++] = c;
+	op->spec[n] = '\0';
+	return JNI_TRUE;
+}
+
+static jboolean c_parse(const char *f,size_t len,fmt_op *ops,int *count) {
+	size_t i = 0, lit = 0;
+	int n = 0;
+	while (i < len) {
+		if (f[i] != '%') {
+			i++;
+			continue;
+		}
+		if (n == XJNI_FORMAT_OPS - 1) return JNI_FALSE;
+		fmt_op *op = &ops[n++];
+		op->lit = lit;
+		op->litlen = i - lit;
+		op->arg = -1;
+		op->width = -1;
+		op->precision = -1;
+		op->flags = 0;
+		i++;
+		if (!c_parse_op(f,len,&i,op)) return JNI_FALSE;
+		lit = i;
+	}
+	ops[n].lit = lit;
+	ops[n].litlen = len - lit;
+	ops[n].arg = -1;
+	ops[n].conv = '\0';
+	*count = n + 1;
+	return JNI_TRUE;
+}
+
+/* ---- program cache ---- */
+
+static unsigned fmt_hash(const void *data,size_t bytes) {
+	const unsigned char *p = (const unsigned char *)data;
+	unsigned h = 2166136261u;
+	for (size_t i = 0; i < bytes; i++)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+// Compile without the cache: UTF-8 text, ops, and a copy of the source
+static xjni_fmt_prog_t *fmt_build(int syntax,const void *format,size_t len,jboolean utf16) {
+	char stack[FMT_CHARS * 3 + 3];
+	char *tmp = NULL;
+	const char *text = (const char *)format;
+	size_t textlen = len;
+	if (utf16) {
+		tmp = len > FMT_CHARS ? (char *)malloc(len * 3 + 3) : stack;
+		if (!tmp) return NULL;
+		jchar high = 0;
+		textlen = fmt_encode((const jchar *)format,(jsize)len,tmp,&high);
+		if (high) textlen += fmt_encode_cp(high,tmp + textlen);
+		text = tmp;
+	}
+
+	fmt_op ops[XJNI_FORMAT_OPS];
+	int count = 0;
+	jint maxArg = -1;
+	jboolean native = syntax == XJNI_FMT_JAVA
+		? fmt_parse(text,textlen,ops,&count,&maxArg)
+		: c_parse(text,textlen,ops,&count);
+	if (!native) count = 0;
+	if (utf16) {
+		// literal runs in source units: four-byte sequences came from surrogate pairs
+		size_t pos = 0, units = 0;
+		for (int k = 0; k < count; k++) {
+			for (; pos < ops[k].lit; pos++)
+				if (((unsigned char)text[pos] & 0xC0) != 0x80) units += ((unsigned char)text[pos] >= 0xF0) ? 2 : 1;
+			ops[k].lit16 = units;
+			for (; pos < ops[k].lit + ops[k].litlen; pos++)
+				if (((unsigned char)text[pos] & 0xC0) != 0x80) units += ((unsigned char)text[pos] >= 0xF0) ? 2 : 1;
+			ops[k].litlen16 = units - ops[k].lit16;
+		}
+	}
+
+	size_t srcBytes = utf16 ? len * sizeof(jchar) : 0;
+	xjni_fmt_prog_t *prog = (xjni_fmt_prog_t *)malloc(sizeof(xjni_fmt_prog_t) + sizeof(fmt_op) * (size_t)count + srcBytes + textlen + 1);
+	if (prog) {
+		char *tail = (char *)(prog->ops + count);
+		memcpy(prog->ops,ops,sizeof(fmt_op) * (size_t)count);
+		memcpy(tail,format,srcBytes);
+		memcpy(tail + srcBytes,text,textlen);
+		tail[srcBytes + textlen] = '\0';
+		prog->refs = 1;
+		prog->syntax = syntax;
+		prog->utf16 = utf16;
+		prog->native = native;
+		prog->ptr = NULL;
+		prog->hash = 0;
+		prog->len = len;
+		prog->source = tail;
+		prog->text = tail + srcBytes;
+		prog->textlen = textlen;
+		prog->maxArg = maxArg;
+		prog->count = count;
+	}
+	if (tmp != stack) free(tmp);
+	return prog;
+}
+
+// Cached program for the key, with a reference taken; gProgMutex held
+static xjni_fmt_prog_t *fmt_lookup(size_t slot,int syntax,const void *ptr,unsigned hash,const void *format,size_t len,jboolean utf16) {
+	size_t bytes = len * (utf16 ? sizeof(jchar) : 1);
+	for (size_t k = 0; k < FMT_PROBE; k++) {
+		xjni_fmt_prog_t *p = gProgs[(slot + k) % XJNI_FORMAT_CACHE];
+		if (p && p->syntax == syntax && p->utf16 == utf16 && p->len == len && p->ptr == ptr &&
+			p->hash == hash && !memcmp(p->source,format,bytes)) {
+			p->refs++;
+			return p;
+		}
+	}
+	return NULL;
+}
+
+xjni_fmt_prog_t *xjni_fmt_compile(int syntax,const void *format,size_t len,jboolean utf16,jboolean stable) {
+	if (!format) return NULL;
+	// literals are found by address; transient buffers by a hash of their content
+	const void *ptr = stable ? format : NULL;
+	unsigned hash = stable ? 0 : fmt_hash(format,len * (utf16 ? sizeof(jchar) : 1));
+	unsigned key = stable ? (unsigned)((uintptr_t)format >> 3) * 2654435761u : hash;
+	size_t slot = (key ^ (unsigned)syntax) % XJNI_FORMAT_CACHE;
+
+	pthread_mutex_lock(&gProgMutex);
+	xjni_fmt_prog_t *prog = fmt_lookup(slot,syntax,ptr,hash,format,len,utf16);
+	pthread_mutex_unlock(&gProgMutex);
+	if (prog) return prog;
+
+	xjni_fmt_prog_t *built = fmt_build(syntax,format,len,utf16);
+	if (!built) return NULL;
+	built->ptr = ptr;
+	built->hash = hash;
+	pthread_mutex_lock(&gProgMutex);
+	prog = fmt_lookup(slot,syntax,ptr,hash,format,len,utf16);
+	if (!prog) {
+		size_t victim = XJNI_FORMAT_CACHE;
+		for (size_t k = 0; k < FMT_PROBE && victim == XJNI_FORMAT_CACHE; k++)
+			if (!gProgs[(slot + k) % XJNI_FORMAT_CACHE]) victim = (slot + k) % XJNI_FORMAT_CACHE;
+		if (victim == XJNI_FORMAT_CACHE) victim = (slot + gEvict++ % FMT_PROBE) % XJNI_FORMAT_CACHE;
+		xjni_fmt_prog_t *old = gProgs[victim];
+		if (old && --old->refs == 0) free(old);
+		built->refs = 2; // table and caller
+		gProgs[victim] = prog = built;
+		built = NULL;
+	}
+	pthread_mutex_unlock(&gProgMutex);
+	free(built);
+	return prog;
+}
+
+void xjni_fmt_release(xjni_fmt_prog_t *prog) {
+	if (!prog) return;
+	pthread_mutex_lock(&gProgMutex);
+	jboolean last = --prog->refs == 0;
+	pthread_mutex_unlock(&gProgMutex);
+	if (last) free(prog);
+}
+
+// Whether the argument of op can be printed natively
+static jboolean fmt_check_arg(JNIEnv *env,const fmt_op *op,fmt_args *a,jargs_t args) {
+	jsize i = op->arg;
+	char type = a->types[i];
+	if (type == '\0') return JNI_TRUE; // "null", or "false" for %b
+	switch (op->conv) {
+		case 'b':
+			return JNI_TRUE;
+		case 's':
+			if (type == 'F' || type == 'D') return JNI_FALSE;
+			if (type == 'C') return !(op->flags & FMT_UPPER) || a->values[i].c < 0x80;
+			if (type != 'L') return JNI_TRUE;
+			if (op->flags & FMT_UPPER) return JNI_FALSE;
+			if (!a->objects[i]) {
+				a->objects[i] = GetJArgs(env,args,i);
+				if (!a->objects[i] || !_IsInstanceOf(env,a->objects[i],gStringCls)) return JNI_FALSE;
+			}
+			return JNI_TRUE;
+		case 'c': {
+			jint cp;
+			switch (type) {
+				case 'C': cp = a->values[i].c; break;
+				case 'B': cp = a->values[i].b; break;
+				case 'S': cp = a->values[i].s; break;
+				case 'I': cp = a->values[i].i; break;
+				default: return JNI_FALSE;
+			}
+			if (cp < 0 || cp > 0x10FFFF) return JNI_FALSE;
+			return !(op->flags & FMT_UPPER) || cp < 0x80;
+		}
+		case 'd': case 'o': case 'x':
+			return type == 'B' || type == 'S' || type == 'I' || type == 'J';
+		case 'e': case 'f':
+			return type == 'F' || type == 'D';
+		default:
+			return JNI_FALSE;
+	}
+}
+
+/* ---- conversions ---- */
+
+// Justify text of chars UTF-16 units (len bytes) to the width of op
+static void fmt_justify(xjni_sink_t *sink,const fmt_op *op,const char *text,size_t len,size_t chars) {
+	size_t pad = op->width > 0 && (size_t)op->width > chars ? (size_t)op->width - chars : 0;
+	if (!(op->flags & FMT_MINUS)) sink_pad(sink,' ',pad);
+	xjni_sink_put(sink,text,len);
+	if (op->flags & FMT_MINUS) sink_pad(sink,' ',pad);
+}
+
+// ASCII text with the precision and case of op applied
+static void fmt_ascii(xjni_sink_t *sink,const fmt_op *op,const char *text) {
+	char upper[32];
+	size_t len = strlen(text);
+	if (op->precision >= 0 && (size_t)op->precision < len) len = (size_t)op->precision;
+	if ((op->flags & FMT_UPPER) && len < sizeof(upper)) {
+		for (size_t k = 0; k < len; k++)
+			upper[k] = (text[k] >= 'a' && text[k] <= 'z') ? (char)(text[k] - 'a' + 'A') : text[k];
+		text = upper;
+	}
+	fmt_justify(sink,op,text,len,len);
+}
+
+static void fmt_code_point(xjni_sink_t *sink,const fmt_op *op,jint cp) {
+	char out[4];
+	if ((op->flags & FMT_UPPER) && cp >= 'a' && cp <= 'z') cp -= 'a' - 'A';
+	size_t chars = cp >= 0x10000 ? 2 : 1;
+	if (op->precision == 0) chars = 0; // only reachable for %s
+	fmt_justify(sink,op,out,chars ? fmt_encode_cp(cp,out) : 0,chars);
+}
+
+static void fmt_string(JNIEnv *env,xjni_sink_t *sink,const fmt_op *op,jstring s) {
+	jsize len = _GetStringLength(env,s);
+	if (op->precision >= 0 && op->precision < len) len = op->precision;
+	size_t pad = op->width > len ? (size_t)(op->width - len) : 0;
+	if (!(op->flags & FMT_MINUS)) sink_pad(sink,' ',pad);
+	jchar units[FMT_CHARS];
+	char out[FMT_CHARS * 3 + 3];
+	jchar high = 0;
+	for (jsize at = 0; at < len; ) {
+		jsize k = len - at < FMT_CHARS ? len - at : FMT_CHARS;
+		_GetStringRegion(env,s,at,k,units);
+		xjni_sink_put(sink,out,fmt_encode(units,k,out,&high));
+		at += k;
+	}
+	if (high) xjni_sink_put(sink,out,fmt_encode_cp(high,out));
+	if (op->flags & FMT_MINUS) sink_pad(sink,' ',pad);
+}
+
+// Sign or prefix, zero padding from the '0' flag, then the digits
+static void fmt_numeric(xjni_sink_t *sink,const fmt_op *op,const char *prefix,const char *digits,size_t ndigits) {
+	size_t plen = strlen(prefix);
+	size_t total = plen + ndigits;
+	size_t pad = op->width > 0 && (size_t)op->width > total ? (size_t)op->width - total : 0;
+	if (!(op->flags & (FMT_MINUS | FMT_ZERO))) sink_pad(sink,' ',pad);
+	xjni_sink_put(sink,prefix,plen);
+	if (op->flags & FMT_ZERO) sink_pad(sink,'0',pad);
+	xjni_sink_put(sink,digits,ndigits);
+	if (op->flags & FMT_MINUS) sink_pad(sink,' ',pad);
+}
+
+static void fmt_integer(xjni_sink_t *sink,const fmt_op *op,jlong v,char type) {
+	char digits[24];
+	char *end = digits + sizeof(digits), *p = end;
+	const char *prefix = "";
+	unsigned long long u;
+	if (op->conv == 'd') {
+		u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+		do *--p = (char)('0' + u % 10); while (u /= 10);
+		prefix = v < 0 ? "-" : (op->flags & FMT_PLUS) ? "+" : (op->flags & FMT_SPACE) ? " " : "";
+	} else {
+		// negative values print as the two's complement of their own width
+		u = (unsigned long long)v;
+		if (type == 'B') u &= 0xFFULL;
+		else if (type == 'S') u &= 0xFFFFULL;
+		else if (type == 'I') u &= 0xFFFFFFFFULL;
+		const char *hex = (op->flags & FMT_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+		unsigned shift = op->conv == 'x' ? 4 : 3;
+		do *--p = hex[u & ((1u << shift) - 1)]; while (u >>= shift);
+		if (op->flags & FMT_HASH)
+			prefix = op->conv == 'o' ? "0" : (op->flags & FMT_UPPER) ? "0X" : "0x";
+	}
+	fmt_numeric(sink,op,prefix,p,(size_t)(end - p));
+}
+
+// Shortest digits that read back as v (v > 0, finite): v = d[0].d[1]... * 10^exp
+static int fmt_shortest(double v,char *d,int *exp10) {
+	char tmp[40];
+	int lo = 1, hi = 17;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		snprintf(tmp,sizeof(tmp),"%.*e",mid - 1,v);
+		if (strtod(tmp,NULL) == v) hi = mid;
+		else lo = mid + 1;
+	}
+	snprintf(tmp,sizeof(tmp),"%.*e",lo - 1,v);
+	int n = 0;
+	const char *p = tmp;
+	for (; *p && *p != 'e'; p++)
+		if (fmt_digit(*p)) d[n++] = *p;
+	*exp10 = *p ? atoi(p + 1) : 0;
+	while (n > 1 && d[n - 1] == '0') n--;
+	return n;
+}
+
+// Keep the first keep digits, rounding half-up like Formatter
+static int fmt_round(char *d,int n,int *exp10,int keep) {
+	if (keep >= n) return n;
+	if (keep < 0 || (keep == 0 && d[0] < '5')) {
+		d[0] = '0';
+		*exp10 = 0;
+		return 1;
+	}
+	jboolean up = d[keep] >= '5';
+	n = keep;
+	if (up) {
+		int k = n - 1;
+		while (k >= 0 && d[k] == '9') d[k--] = '0';
+		if (k >= 0) {
+			d[k]++;
+		} else {
+			// carried past the first digit (or nothing was kept): one digit higher
+			d[0] = '1';
+			n = 1;
+			(*exp10)++;
+		}
+	}
+	while (n > 1 && d[n - 1] == '0') n--;
+	return n;
+}
+
+static void fmt_float(xjni_sink_t *sink,const fmt_op *op,jdouble v) {
+	if (isnan(v)) {
+		fmt_op text = *op;
+		text.precision = -1;
+		fmt_ascii(sink,&text,"NaN");
+		return;
+	}
+	const char *sign = signbit(v) ? "-" : (op->flags & FMT_PLUS) ? "+" : (op->flags & FMT_SPACE) ? " " : "";
+	v = signbit(v) ? -v : v;
+	if (isinf(v)) {
+		char text[16];
+		snprintf(text,sizeof(text),"%s%s",sign,(op->flags & FMT_UPPER) ? "INFINITY" : "Infinity");
+		fmt_justify(sink,op,text,strlen(text),strlen(text));
+		return;
+	}
+
+	int p = op->precision < 0 ? 6 : op->precision;
+	char d[24];
+	int e = 0;
+	int n = 1;
+	d[0] = '0';
+	if (v != 0) n = fmt_shortest(v,d,&e);
+	n = fmt_round(d,n,&e,op->conv == 'f' ? e + 1 + p : p + 1);
+
+	// body: digits, point and exponent, built in pieces to stream long %f output
+	char tail[8];
+	size_t intLen, tailLen = 0;
+	jboolean point = p > 0 || (op->flags & FMT_HASH);
+	if (op->conv == 'f') {
+		intLen = e >= 0 ? (size_t)e + 1 : 1;
+	} else {
+		intLen = 1;
+		int ae = e < 0 ? -e : e;
+		tailLen = (size_t)snprintf(tail,sizeof(tail),"%c%c%02d",(op->flags & FMT_UPPER) ? 'E' : 'e',e < 0 ? '-' : '+',ae);
+	}
+	size_t total = strlen(sign) + intLen + (point ? 1 : 0) + (size_t)p + tailLen;
+	size_t pad = op->width > 0 && (size_t)op->width > total ? (size_t)op->width - total : 0;
+	if (!(op->flags & (FMT_MINUS | FMT_ZERO))) sink_pad(sink,' ',pad);
+	xjni_sink_put(sink,sign,strlen(sign));
+	if (op->flags & FMT_ZERO) sink_pad(sink,'0',pad);
+
+	// integer part: digits 0..intLen-1 for %f (zeros past n), d[0] for %e
+	if (op->conv == 'f' && e < 0) {
+		xjni_sink_put(sink,"0",1);
+	} else {
+		size_t have = (size_t)n < intLen ? (size_t)n : intLen;
+		xjni_sink_put(sink,d,have);
+		sink_pad(sink,'0',intLen - have);
+	}
+	if (point) xjni_sink_put(sink,".",1);
+	// fraction digits: 10^-j is digit e + j for %f, digit j for %e
+	int first = op->conv == 'f' ? e + 1 : 1;
+	int lead = first < 0 ? (-first < p ? -first : p) : 0;
+	sink_pad(sink,'0',(size_t)lead);
+	int from = first + lead, count = p - lead;
+	if (from < n && count > 0) {
+		int k = n - from < count ? n - from : count;
+		xjni_sink_put(sink,d + from,(size_t)k);
+		count -= k;
+	}
+	sink_pad(sink,'0',count > 0 ? (size_t)count : 0);
+	xjni_sink_put(sink,tail,tailLen);
+	if (op->flags & FMT_MINUS) sink_pad(sink,' ',pad);
+}
+
+static void fmt_emit(JNIEnv *env,xjni_sink_t *sink,const fmt_op *op,const fmt_args *a) {
+	if (op->conv == 'n') {
+		xjni_sink_put(sink,FMT_NEWLINE,sizeof(FMT_NEWLINE) - 1);
+		return;
+	}
+	if (op->conv == '%') {
+		fmt_ascii(sink,op,"%");
+		return;
+	}
+	char type = a->types[op->arg];
+	const jvalue *v = &a->values[op->arg];
+	char text[32];
+	if (op->conv == 'b') {
+		fmt_ascii(sink,op,type == '\0' ? "false" : (type == 'Z' && !v->z) ? "false" : "true");
+		return;
+	}
+	switch (type) {
+		case '\0':
+			fmt_ascii(sink,op,"null");
+			return;
+		case 'Z':
+			fmt_ascii(sink,op,v->z ? "true" : "false");
+			return;
+		case 'C':
+			fmt_code_point(sink,op,v->c);
+			return;
+		case 'F':
+			fmt_float(sink,op,v->f);
+			return;
+		case 'D':
+			fmt_float(sink,op,v->d);
+			return;
+		case 'L':
+			fmt_string(env,sink,op,(jstring)a->objects[op->arg]);
+			return;
+		default:
+			break;
+	}
+	jlong value = type == 'B' ? v->b : type == 'S' ? v->s : type == 'I' ? v->i : v->j;
+	if (op->conv == 'c') {
+		fmt_code_point(sink,op,(jint)value);
+	} else if (op->conv == 's') {
+		snprintf(text,sizeof(text),"%lld",(long long)value);
+		fmt_ascii(sink,op,text);
+	} else {
+		fmt_integer(sink,op,value,type);
+	}
+}
+
+/* ---- C programs ---- */
+
+typedef union c_value {
+	long long i;
+	unsigned long long u;
+	double d;
+	long double ld;
+	const char *s;
+	const jchar *w;
+	void *p;
+	int c;
+} c_value;
+
+#define C_FORMAT(value) (stars == 0 ? snprintf(buf,size,op->spec,value) \
+	: stars == 1 ? snprintf(buf,size,op->spec,star[0],value) \
+	: snprintf(buf,size,op->spec,star[0],star[1],value))
+
+static int c_snprintf(char *buf,size_t size,const fmt_op *op,const int *star,int stars,const c_value *v) {
+	switch (op->conv) {
+		case 'd': return C_FORMAT(v->i);
+		case 'u': return C_FORMAT(v->u);
+		case 'f': return op->length == 'L' ? C_FORMAT(v->ld) : C_FORMAT(v->d);
+		case 's': return C_FORMAT(v->s);
+		case 'p': return C_FORMAT(v->p);
+		default: return C_FORMAT(v->c);
+	}
+}
+
+// Read the argument of op with its C type, widened to the type its spec says
+static void c_read(const fmt_op *op,va_list *ap,c_value *v) {
+	switch (op->conv) {
+		case 'd':
+			switch (op->length) {
+				case 'H': v->i = (signed char)va_arg(*ap,int); break;
+				case 'h': v->i = (short)va_arg(*ap,int); break;
+				case 'l': v->i = va_arg(*ap,long); break;
+				case 'M': v->i = va_arg(*ap,long long); break;
+				case 'j': v->i = va_arg(*ap,intmax_t); break;
+				case 'z': v->i = (ptrdiff_t)va_arg(*ap,size_t); break;
+				case 't': v->i = va_arg(*ap,ptrdiff_t); break;
+				default: v->i = va_arg(*ap,int); break;
+			}
+			break;
+		case 'u':
+			switch (op->length) {
+				case 'H': v->u = (unsigned char)va_arg(*ap,unsigned int); break;
+				case 'h': v->u = (unsigned short)va_arg(*ap,unsigned int); break;
+				case 'l': v->u = va_arg(*ap,unsigned long); break;
+				case 'M': v->u = va_arg(*ap,unsigned long long); break;
+				case 'j': v->u = va_arg(*ap,uintmax_t); break;
+				case 'z': v->u = va_arg(*ap,size_t); break;
+				case 't': v->u = (size_t)va_arg(*ap,ptrdiff_t); break;
+				default: v->u = va_arg(*ap,unsigned int); break;
+			}
+			break;
+		case 'f':
+			if (op->length == 'L') v->ld = va_arg(*ap,long double);
+			else v->d = va_arg(*ap,double);
+			break;
+		case 's': v->s = va_arg(*ap,const char *); break;
+		case 'S': v->w = va_arg(*ap,const jchar *); break;
+		case 'p': v->p = va_arg(*ap,void *); break;
+		default: v->c = va_arg(*ap,int); break;
+	}
+}
+
+static const jchar gNull16[] = { '(','n','u','l','l',')',0 };
+
+// Width of op, from the arguments for '*' (negative meaning left-justified)
+static int c_width(const fmt_op *op,const int *star,int stars) {
+	(void)stars;
+	return (op->flags & FMT_STARW) ? star[0] : op->width < 0 ? 0 : op->width;
+}
+
+static jboolean c_left(const fmt_op *op,const int *star,int stars) {
+	return (op->flags & FMT_MINUS) || c_width(op,star,stars) < 0;
+}
+
+static int c_precision(const fmt_op *op,const int *star,int stars) {
+	return (op->flags & FMT_STARP) ? star[stars - 1] : op->precision;
+}
+
+// Padding needed around n characters
+static size_t c_pad(const fmt_op *op,const int *star,int stars,size_t n) {
+	int w = c_width(op,star,stars);
+	size_t width = w < 0 ? (size_t)-(long)w : (size_t)w;
+	return width > n ? width - n : 0;
+}
+
+// Units of a jchar string argument (a single one for %C), cut at the precision
+static size_t c_units(const fmt_op *op,const int *star,int stars,const jchar *w) {
+	if (op->conv == 'C') return 1;
+	int p = c_precision(op,star,stars);
+	size_t n = 0;
+	while ((p < 0 || n < (size_t)p) && w[n]) n++;
+	return n;
+}
+
+static int c_emit(xjni_sink_t *sink,const fmt_op *op,va_list *ap) {
+	if (op->conv == '%') {
+		xjni_sink_put(sink,"%",1);
+		return 0;
+	}
+	int star[2], stars = 0;
+	if (op->flags & FMT_STARW) star[stars++] = va_arg(*ap,int);
+	if (op->flags & FMT_STARP) star[stars++] = va_arg(*ap,int);
+	c_value v;
+	c_read(op,ap,&v);
+	if (op->conv == 'S' || op->conv == 'C') {
+		jchar c = (jchar)v.c;
+		const jchar *w = op->conv == 'C' ? &c : v.w ? v.w : gNull16;
+		size_t n = c_units(op,star,stars,w);
+		size_t pad = c_pad(op,star,stars,n);
+		if (!c_left(op,star,stars)) sink_pad(sink,' ',pad);
+		char utf[FMT_CHARS * 3 + 3];
+		jchar high = 0;
+		for (size_t i = 0; i < n; i += FMT_CHARS) {
+			jsize k = (jsize)(n - i < FMT_CHARS ? n - i : FMT_CHARS);
+			xjni_sink_put(sink,utf,fmt_encode(w + i,k,utf,&high));
+		}
+		if (high) xjni_sink_put(sink,utf,fmt_encode_cp(high,utf));
+		if (c_left(op,star,stars)) sink_pad(sink,' ',pad);
+		return 0;
+	}
+
+	char stack[512];
+	int n = c_snprintf(stack,sizeof(stack),op,star,stars,&v);
+	if (n < 0) return -1;
+	if ((size_t)n < sizeof(stack)) {
+		xjni_sink_put(sink,stack,(size_t)n);
+		return 0;
+	}
+	char *buf = (char *)malloc((size_t)n + 1);
+	if (!buf) return -1;
+	c_snprintf(buf,(size_t)n + 1,op,star,stars,&v);
+	xjni_sink_put(sink,buf,(size_t)n);
+	free(buf);
+	return 0;
+}
+
+int xjni_fmt_vprint(xjni_sink_t *sink,const xjni_fmt_prog_t *prog,va_list ap) {
+	size_t start = sink->len;
+	va_list aq;
+	va_copy(aq,ap);
+	if (!prog->native) {
+		char stack[512];
+		int n = vsnprintf(stack,sizeof(stack),prog->text,aq);
+		va_end(aq);
+		if (n < 0) return -1;
+		if ((size_t)n < sizeof(stack)) {
+			xjni_sink_put(sink,stack,(size_t)n);
+			return n;
+		}
+		char *buf = (char *)malloc((size_t)n + 1);
+		if (!buf) return -1;
+		va_copy(aq,ap);
+		vsnprintf(buf,(size_t)n + 1,prog->text,aq);
+		va_end(aq);
+		xjni_sink_put(sink,buf,(size_t)n);
+		free(buf);
+		return n;
+	}
+	int ret = 0;
+	for (int i = 0; i < prog->count && ret == 0; i++) {
+		const fmt_op *op = &prog->ops[i];
+		xjni_sink_put(sink,prog->text + op->lit,op->litlen);
+		if (op->conv) ret = c_emit(sink,op,&aq);
+	}
+	va_end(aq);
+	return ret < 0 ? -1 : (int)(sink->len - start);
+}
+
+/* ---- C programs to UTF-16 ---- */
+
+// Destination of xjni_fmt_vprint16(), truncated like snprintf
+typedef struct fmt_out16 {
+	jchar *buf;
+	size_t cap;
+	size_t len;
+} fmt_out16;
+
+static void out16_put(fmt_out16 *o,const jchar *data,size_t n) {
+	size_t room = o->cap ? o->cap - 1 : 0;
+	if (o->len < room)
+		memcpy(o->buf + o->len,data,(n < room - o->len ? n : room - o->len) * sizeof(jchar));
+	o->len += n;
+}
+
+static void out16_pad(fmt_out16 *o,size_t n) {
+	jchar run[64];
+	for (size_t i = 0; i < n && i < 64; i++) run[i] = ' ';
+	while (n > 0) {
+		size_t k = n < 64 ? n : 64;
+		out16_put(o,run,k);
+		n -= k;
+	}
+}
+
+// Bytes of snprintf output, widened one to one (numbers are ASCII, %c a byte)
+static void out16_bytes(fmt_out16 *o,const char *data,size_t n) {
+	size_t room = o->cap ? o->cap - 1 : 0;
+	for (size_t i = 0; i < n && o->len + i < room; i++)
+		o->buf[o->len + i] = (jchar)(unsigned char)data[i];
+	o->len += n;
+}
+
+// Length of the UTF-8 sequence led by c, 1 for a byte that cannot lead one
+static size_t utf8_seq(unsigned char c) {
+	return c >= 0xF8 ? 1 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+}
+
+// Decode one code point of the n bytes at s, U+FFFD for a malformed one;
+// returns the bytes consumed
+static size_t utf8_next(const unsigned char *s,size_t n,jint *cp) {
+	size_t len = utf8_seq(s[0]);
+	if (len == 1 || len > n) {
+		*cp = s[0] < 0x80 ? s[0] : 0xFFFD;
+		return 1;
+	}
+	jint v = s[0] & (0x7F >> len);
+	for (size_t i = 1; i < len; i++) {
+		if ((s[i] & 0xC0) != 0x80) {
+			*cp = 0xFFFD;
+			return i;
+		}
+		v = (v << 6) | (s[i] & 0x3F);
+	}
+	*cp = v > 0x10FFFF ? 0xFFFD : v;
+	return len;
+}
+
+// UTF-16 units of n bytes of UTF-8
+static size_t utf8_units(const char *s,size_t n) {
+	size_t units = 0;
+	for (size_t i = 0; i < n;) {
+		jint cp;
+		i += utf8_next((const unsigned char *)s + i,n - i,&cp);
+		units += cp >= 0x10000 ? 2 : 1;
+	}
+	return units;
+}
+
+static void out16_utf8(fmt_out16 *o,const char *s,size_t n) {
+	jchar chunk[FMT_CHARS];
+	size_t k = 0;
+	for (size_t i = 0; i < n;) {
+		jint cp;
+		i += utf8_next((const unsigned char *)s + i,n - i,&cp);
+		if (cp >= 0x10000) {
+			chunk[k++] = (jchar)(0xD800 + ((cp - 0x10000) >> 10));
+			chunk[k++] = (jchar)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+		} else {
+			chunk[k++] = (jchar)cp;
+		}
+		if (k >= FMT_CHARS - 1) {
+			out16_put(o,chunk,k);
+			k = 0;
+		}
+	}
+	out16_put(o,chunk,k);
+}
+
+static int c_emit16(fmt_out16 *o,const fmt_op *op,va_list *ap) {
+	if (op->conv == '%') {
+		jchar c = '%';
+		out16_put(o,&c,1);
+		return 0;
+	}
+	int star[2], stars = 0;
+	if (op->flags & FMT_STARW) star[stars++] = va_arg(*ap,int);
+	if (op->flags & FMT_STARP) star[stars++] = va_arg(*ap,int);
+	c_value v;
+	c_read(op,ap,&v);
+
+	if (op->conv == 's' || op->conv == 'S' || op->conv == 'C') {
+		jchar c = (jchar)v.c;
+		const jchar *w = op->conv == 'C' ? &c : v.w ? v.w : gNull16;
+		const char *str = v.s ? v.s : "(null)";
+		size_t bytes = 0, n;
+		if (op->conv == 's') {
+			// at most precision bytes, without splitting a sequence
+			int p = c_precision(op,star,stars);
+			const char *end = p < 0 ? NULL : (const char *)memchr(str,'\0',(size_t)p);
+			bytes = p < 0 ? strlen(str) : end ? (size_t)(end - str) : (size_t)p;
+			if (p >= 0 && !end) {
+				size_t i = 0;
+				while (i < bytes && i + utf8_seq((unsigned char)str[i]) <= bytes) i += utf8_seq((unsigned char)str[i]);
+				bytes = i;
+			}
+			n = utf8_units(str,bytes);
+		} else {
+			n = c_units(op,star,stars,w);
+		}
+		size_t pad = c_pad(op,star,stars,n);
+		if (!c_left(op,star,stars)) out16_pad(o,pad);
+		if (op->conv == 's') out16_utf8(o,str,bytes);
+		else out16_put(o,w,n);
+		if (c_left(op,star,stars)) out16_pad(o,pad);
+		return 0;
+	}
+
+	// numbers: only a field wider than the stack buffer goes through the heap
+	char stack[512];
+	int n = c_snprintf(stack,sizeof(stack),op,star,stars,&v);
+	if (n < 0) return -1;
+	if ((size_t)n < sizeof(stack)) {
+		out16_bytes(o,stack,(size_t)n);
+		return 0;
+	}
+	char *buf = (char *)malloc((size_t)n + 1);
+	if (!buf) return -1;
+	c_snprintf(buf,(size_t)n + 1,op,star,stars,&v);
+	out16_bytes(o,buf,(size_t)n);
+	free(buf);
+	return 0;
+}
+
+int xjni_fmt_vprint16(jchar *dst,size_t cap,const xjni_fmt_prog_t *prog,va_list ap) {
+	fmt_out16 o = { dst,cap,0 };
+	int ret = 0;
+	va_list aq;
+	va_copy(aq,ap);
+	if (!prog->native) {
+		char stack[1024];
+		int n = vsnprintf(stack,sizeof(stack),prog->text,aq);
+		va_end(aq);
+		if (n < 0) return -1;
+		if ((size_t)n < sizeof(stack)) {
+			out16_utf8(&o,stack,(size_t)n);
+		} else {
+			char *buf = (char *)malloc((size_t)n + 1);
+			if (!buf) return -1;
+			va_copy(aq,ap);
+			vsnprintf(buf,(size_t)n + 1,prog->text,aq);
+			va_end(aq);
+			out16_utf8(&o,buf,(size_t)n);
+			free(buf);
+		}
+	} else {
+		for (int i = 0; i < prog->count && ret == 0; i++) {
+			const fmt_op *op = &prog->ops[i];
+			if (prog->utf16) out16_put(&o,(const jchar *)prog->source + op->lit16,op->litlen16);
+			else out16_utf8(&o,prog->text + op->lit,op->litlen);
+			if (op->conv) ret = c_emit16(&o,op,&aq);
+		}
+		va_end(aq);
+	}
+	if (cap) dst[o.len < cap - 1 ? o.len : cap - 1] = 0;
+	return ret < 0 || o.len > INT_MAX ? -1 : (int)o.len;
+}
+
+/* ---- entry points ---- */
+
+// Body of fmt_init, run by one thread at a time
+static jboolean fmt_init_locked(JNIEnv *env) {
+	if (atomic_load_explicit(&gNative,memory_order_relaxed) >= 0) return JNI_TRUE;
+	if (!gStringCls || !gFormatMid) {
+		jclass local = _FindClass(env,"java/lang/String");
+		if (!local) return JNI_FALSE;
+		jclass global = _NewGlobalRef(env,local);
+		_DeleteLocalRef(env,local);
+		if (!global) return JNI_FALSE;
+		jmethodID mid = _GetStaticMethodID(env,global,"format","(Ljava/lang/String;[Ljava/lang/Object;)Ljava/lang/String;");
+		if (!mid) {
+			_DeleteGlobalRef(env,global);
+			return JNI_FALSE;
+		}
+		gStringCls = global;
+		gFormatMid = mid;
+	}
+
+	// sign, digits and decimal separator of the default locale
+	int native = 0;
+	jclass objCls = _FindClass(env,"java/lang/Object");
+	jargs_t probe = objCls ? NewJArgs(env,2,objCls,NULL) : NULL;
+	jstring format = probe ? _NewStringUTF(env,"%.1f %d") : NULL;
+	if (format) {
+		JArgsReplaceDouble(env,probe,-1.5,0);
+		JArgsReplaceInt(env,probe,-1234,1);
+		jstring result = (jstring)_CallStaticObjectMethod(env,gStringCls,gFormatMid,format,probe);
+		if (result && !_ExceptionCheck(env)) {
+			char text[16] = {0};
+			if (_GetStringUTFLength(env,result) < (jsize)sizeof(text)) {
+				_GetStringUTFRegion(env,result,0,_GetStringLength(env,result),text);
+				native = strcmp(text,"-1.5 -1234") == 0;
+			}
+		}
+		if (result) _DeleteLocalRef(env,result);
+		_DeleteLocalRef(env,format);
+	}
+	_ExceptionClear(env);
+	if (probe) _DeleteLocalRef(env,probe);
+	if (objCls) _DeleteLocalRef(env,objCls);
+	atomic_store_explicit(&gNative,native,memory_order_release);
+	return JNI_TRUE;
+}
+
+// String.format, and whether the default locale formats like Locale.ROOT
+static jboolean fmt_init(JNIEnv *env) {
+	if (atomic_load_explicit(&gNative,memory_order_acquire) >= 0) return JNI_TRUE;
+	pthread_mutex_lock(&gInitMutex);
+	jboolean ok = fmt_init_locked(env);
+	pthread_mutex_unlock(&gInitMutex);
+	return ok;
+}
+
+// Run a Java program; JNI_ERR, with nothing written, when an argument needs String.format
+static jint fmt_run(JNIEnv *env,xjni_sink_t *sink,const xjni_fmt_prog_t *prog,jargs_t args) {
+	jvalue stackValues[FMT_STACK_ARGS];
+	char stackTypes[FMT_STACK_ARGS];
+	jobject stackObjects[FMT_STACK_ARGS];
+	void *heap = NULL;
+	fmt_args a = { 0, stackValues, stackTypes, stackObjects };
+	jint ret = JNI_ERR;
+	if (prog->maxArg >= 0) {
+		if (!args) return JNI_ERR;
+		a.count = _GetArrayLength(env,args);
+		if (prog->maxArg >= a.count) return JNI_ERR;
+		if (a.count > FMT_STACK_ARGS) {
+			size_t n = (size_t)a.count;
+			heap = malloc(n * (sizeof(jvalue) + sizeof(jobject) + 1));
+			if (!heap) return JNI_ERR;
+			a.values = (jvalue *)heap;
+			a.objects = (jobject *)(a.values + n);
+			a.types = (char *)(a.objects + n);
+		}
+		memset(a.objects,0,sizeof(jobject) * (size_t)a.count);
+		if (a.count > 16 && _EnsureLocalCapacity(env,a.count) != JNI_OK) goto cleanup;
+		if (GetJArgsAll(env,args,a.values,a.types) != a.count) goto cleanup;
+	}
+	for (int i = 0; i < prog->count; i++)
+		if (prog->ops[i].arg >= 0 && !fmt_check_arg(env,&prog->ops[i],&a,args)) goto cleanup;
+
+	for (int i = 0; i < prog->count; i++) {
+		const fmt_op *op = &prog->ops[i];
+		xjni_sink_put(sink,prog->text + op->lit,op->litlen);
+		if (op->conv) fmt_emit(env,sink,op,&a);
+	}
+	ret = JNI_OK;
+cleanup:
+	_ExceptionClear(env);
+	for (jsize i = 0; i < a.count; i++)
+		if (a.objects[i]) _DeleteLocalRef(env,a.objects[i]);
+	free(heap);
+	return ret;
+}
+
+jint xjni_format(JNIEnv *env,xjni_sink_t *sink,jstring format,const char *utf,jargs_t args) {
+	if (!fmt_init(env)) {
+		XJNI_LOGE("XJniVaList","String.format init failed");
+		return JNI_ERR;
+	}
+	if (!format && !utf) {
+		XJNI_LOGE("XJniVaList","null format");
+		return JNI_ERR;
+	}
+
+	xjni_fmt_prog_t *prog = NULL;
+	if (utf) {
+		prog = xjni_fmt_compile(XJNI_FMT_JAVA,utf,strlen(utf),JNI_FALSE,JNI_TRUE);
+	} else {
+		jsize len = _GetStringLength(env,format);
+		jchar stack[FMT_CHARS];
+		jchar *units = len > FMT_CHARS ? (jchar *)malloc(sizeof(jchar) * (size_t)len) : stack;
+		if (units) {
+			_GetStringRegion(env,format,0,len,units);
+			prog = xjni_fmt_compile(XJNI_FMT_JAVA,units,(size_t)len,JNI_TRUE,JNI_FALSE);
+			if (units != stack) free(units);
+		}
+	}
+	jint native = (prog && prog->native && atomic_load_explicit(&gNative,memory_order_relaxed) == 1) ? fmt_run(env,sink,prog,args) : JNI_ERR;
+	xjni_fmt_release(prog);
+	if (native == JNI_OK) {
+		xjni_sink_finish(sink);
+		return JNI_OK;
+	}
+
+	// String.format fallback
+	jstring jformat = format ? format : _NewStringUTF(env,utf);
+	jstring result = NULL;
+	const jchar *chars = NULL;
+	jint ret = JNI_ERR;
+	if (!jformat) {
+		_ExceptionClear(env);
+		return JNI_ERR;
+	}
+	if (args) result = (jstring)_CallStaticObjectMethod(env,gStringCls,gFormatMid,jformat,args);
+	else result = (jstring)_CallStaticObjectMethod(env,gStringCls,gFormatMid,jformat,NULL);
+	if (_ExceptionCheck(env) || !result) {
+		XJNI_LOGE("XJniVaList","String.format threw");
+		_ExceptionClear(env);
+		goto cleanup;
+	}
+	// pinned, and streamed as UTF-8 (not modified UTF-8) without a heap copy
+	jsize len = _GetStringLength(env,result);
+	chars = _GetStringCritical(env,result,NULL);
+	if (!chars) {
+		XJNI_LOGE("XJniVaList","GetStringCritical failed");
+		goto cleanup;
+	}
+	sink_utf16(sink,chars,(size_t)len);
+	_ReleaseStringCritical(env,result,chars);
+	xjni_sink_finish(sink);
+	ret = JNI_OK;
+cleanup:
+	if (result) _DeleteLocalRef(env,result);
+	if (jformat != format) _DeleteLocalRef(env,jformat);
+	return ret;
+}
+
+void xjni_format_unload(JNIEnv *env) {
+	pthread_mutex_lock(&gProgMutex);
+	for (size_t i = 0; i < XJNI_FORMAT_CACHE; i++) {
+		if (gProgs[i] && --gProgs[i]->refs == 0) free(gProgs[i]);
+		gProgs[i] = NULL;
+	}
+	pthread_mutex_unlock(&gProgMutex);
+	pthread_mutex_lock(&gInitMutex);
+	if (gStringCls) _DeleteGlobalRef(env,gStringCls);
+	gStringCls = NULL;
+	gFormatMid = NULL;
+	atomic_store_explicit(&gNative,-1,memory_order_relaxed);
+	pthread_mutex_unlock(&gInitMutex);
+}
@@ -0,0 +1,80 @@
+/**
+ * xjni native Java-style formatting (internal)
+ *
+ * Output goes through an xjni_sink_t: a caller buffer (truncated like
+ * snprintf), a FILE stream or a file descriptor, the latter two fed from a
+ * stack chunk. xjni_format() formats a java.util.Formatter format over a
+ * jargs_t natively when every specifier is one it implements, and falls back
+ * to one String.format upcall otherwise; either way the text is written to
+ * the sink in UTF-8.
+ *
+ * Formats of both syntaxes are compiled into programs kept in a bounded
+ * cache (xjni_fmt_compile), so repeated formats are neither converted nor
+ * parsed again.
+ */
+
+#ifndef XJNI_FORMAT_H
+#define XJNI_FORMAT_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <jni.h>
+#include <xjni_args.h>
+
+#ifndef XJNI_SINK_CHUNK
+#define XJNI_SINK_CHUNK 1024
+#endif
+
+typedef struct xjni_sink_t {
+	char *buf;     /* buffer target, NULL for a stream or descriptor */
+	size_t cap;    /* size of buf, terminator included */
+	FILE *fp;      /* stream target */
+	int fd;        /* descriptor target, -1 when unused */
+	size_t len;    /* bytes produced, including those a full buffer dropped */
+	size_t used;   /* bytes waiting in chunk */
+	char chunk[XJNI_SINK_CHUNK];
+} xjni_sink_t;
+
+void xjni_sink_buffer(xjni_sink_t *sink,char *buf,size_t cap);
+void xjni_sink_file(xjni_sink_t *sink,FILE *fp);
+void xjni_sink_fd(xjni_sink_t *sink,int fd);
+void xjni_sink_put(xjni_sink_t *sink,const char *data,size_t len);
+/* Terminate the buffer or write out the pending chunk. */
+void xjni_sink_finish(xjni_sink_t *sink);
+
+/* Format syntax of a program */
+#define XJNI_FMT_JAVA 0 /* java.util.Formatter */
+#define XJNI_FMT_C 1    /* C printf */
+
+typedef struct xjni_fmt_prog xjni_fmt_prog_t;
+
+/*
+ * Compiled program for a format of len units, UTF-8 or UTF-16, shared with
+ * earlier calls for the same format. Formats with a stable address (string
+ * literals) are looked up by address, others (stable JNI_FALSE) by content;
+ * either way the content is compared before a program is reused. Returns
+ * NULL when out of memory; release with xjni_fmt_release().
+ */
+xjni_fmt_prog_t *xjni_fmt_compile(int syntax,const void *format,size_t len,jboolean utf16,jboolean stable);
+void xjni_fmt_release(xjni_fmt_prog_t *prog);
+
+/* Run a C printf program over ap into the sink; bytes produced or -1. */
+int xjni_fmt_vprint(xjni_sink_t *sink,const xjni_fmt_prog_t *prog,va_list ap);
+
+/*
+ * Run a C printf program over ap straight into at most cap - 1 units of dst,
+ * terminated. Returns the units the whole output takes (more than cap - 1
+ * when it was cut), or -1.
+ */
+int xjni_fmt_vprint16(jchar *dst,size_t cap,const xjni_fmt_prog_t *prog,va_list ap);
+
+/*
+ * Format @p format (or the UTF-8 @p utf when format is NULL) into the sink
+ * and finish it. Returns JNI_ERR, nothing written, if String.format threw.
+ */
+jint xjni_format(JNIEnv *env,xjni_sink_t *sink,jstring format,const char *utf,jargs_t args);
+
+/* Drop the cached programs and String class (library unload). */
+void xjni_format_unload(JNIEnv *env);
+
+#endif /* XJNI_FORMAT_H */
@@ -0,0 +1,65 @@
+/**
+ * xjni local reference budgeting (internal)
+ *
+ * Bulk loops create a few local references per element. Instead of relying
+ * on the JVM growing its local reference table, a loop enters an
+ * xjni_frame_t, calls xjni_frame_next() once per element and leaves it when
+ * done. Short loops only reserve capacity with EnsureLocalCapacity; long
+ * loops run inside a local frame that is popped and pushed again every
+ * XJNI_FRAME_CHUNK elements, so at most one chunk of references is ever
+ * live. References created inside the loop must not be used across
+ * iterations.
+ */
+
+#ifndef XJNI_FRAME_H
+#define XJNI_FRAME_H
+
+#include <jni.h>
+#include "base-jni.h"
+
+#ifndef XJNI_FRAME_CHUNK
+#define XJNI_FRAME_CHUNK 256
+#endif
+
+typedef struct xjni_frame_t {
+	JNIEnv *env;
+	jint capacity; /* references reserved per chunk */
+	jsize count;   /* elements handled in the current chunk */
+	jboolean pushed;
+} xjni_frame_t;
+
+/* Reserve room for @p count elements of @p refs references each. */
+static inline jint xjni_frame_enter(xjni_frame_t *frame,JNIEnv *env,jsize count,jint refs) {
+	frame->env = env;
+	frame->count = 0;
+	frame->pushed = JNI_FALSE;
+	if (count <= XJNI_FRAME_CHUNK) {
+		frame->capacity = base_cast(jint,count) * refs + 4;
+		return _EnsureLocalCapacity(env,frame->capacity) == JNI_OK ? JNI_OK : JNI_ERR;
+	}
+	frame->capacity = XJNI_FRAME_CHUNK * refs + 4;
+	if (_PushLocalFrame(env,frame->capacity) != JNI_OK) return JNI_ERR;
+	frame->pushed = JNI_TRUE;
+	return JNI_OK;
+}
+
+/* Call at the top of every iteration; recycles the frame at chunk boundaries. */
+static inline jint xjni_frame_next(xjni_frame_t *frame) {
+	if (!frame->pushed || frame->count++ < XJNI_FRAME_CHUNK) return JNI_OK;
+	frame->count = 1;
+	_PopLocalFrame(frame->env,NULL);
+	if (_PushLocalFrame(frame->env,frame->capacity) != JNI_OK) {
+		frame->pushed = JNI_FALSE;
+		return JNI_ERR;
+	}
+	return JNI_OK;
+}
+
+/* Leave the loop; @p result (may be NULL) survives as a local reference in the caller's frame. */
+static inline jobject xjni_frame_leave(xjni_frame_t *frame,jobject result) {
+	if (!frame->pushed) return result;
+	frame->pushed = JNI_FALSE;
+	return _PopLocalFrame(frame->env,result);
+}
+
+#endif /* XJNI_FRAME_H */
@@ -0,0 +1,30 @@
+/**
+ * xjni threading shims (internal)
+ *
+ * The library locks with the pthread API. xjni.h maps pthread_mutex_t onto
+ * CRITICAL_SECTION on Windows; this header maps the calls made on it, and
+ * the thread and condition variable calls of the worker pool, onto their
+ * Win32 equivalents. Every source file that locks includes it instead of
+ * <pthread.h>.
+ */
+
+#ifndef XJNI_LOCK_H
+#define XJNI_LOCK_H
+
+#include <xjni.h>
+
+#ifdef _WIN32
+typedef HANDLE pthread_t;
+typedef CONDITION_VARIABLE pthread_cond_t;
+#define pthread_once(once_control, init_routine) InitOnceExecuteOnce(once_control, init_routine, NULL, NULL)
+#define pthread_mutex_init(mutex, attr) InitializeCriticalSection(mutex)
+#define pthread_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define pthread_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#define pthread_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+#define pthread_cond_init(cond, attr) InitializeConditionVariable(cond)
+#define pthread_cond_wait(cond, mutex) SleepConditionVariableCS(cond, mutex, INFINITE)
+#define pthread_cond_broadcast(cond) WakeAllConditionVariable(cond)
+#define pthread_cond_destroy(cond) ((void)0)
+#endif
+
+#endif /* XJNI_LOCK_H */
@@ -0,0 +1,502 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jni.h>
+
+#define LOG_TAG "xjni"
+#include "base-jni.h"
+
+#include <xjni.h>
+#include "xjni_frame.h"
+
+#define MARSHAL_STRING 'T'
+#define MARSHAL_ARRAY '['
+
+typedef struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+	_Alignas(max_align_t) char data[];
+} arena_block;
+
+struct xjni_arena {
+	size_t blockSize;
+	arena_block *head;
+};
+
+typedef struct marshal_field {
+	jfieldID fid;
+	size_t offset;
+	char kind;             /* primitive signature character, MARSHAL_STRING or MARSHAL_ARRAY */
+	xjni_ElementType elem; /* element type of MARSHAL_ARRAY fields */
+} marshal_field;
+
+struct xjni_marshal {
+	jclass cls;
+	jmethodID ctor;       /* builder constructor, NULL to use AllocObject and the field IDs */
+	jclass factoryCls;    /* optional single-upcall factory */
+	jmethodID factory;
+	size_t structSize;
+	jsize count;
+	marshal_field fields[];
+};
+
+static arena_block *arena_block_new(size_t size) {
+	arena_block *block = ubase_cast(arena_block*,malloc(sizeof(arena_block) + size));
+	if (block == NULL) return NULL;
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+JNIEXPORTC xjni_arena_t* JNICALL xjni_ArenaNew(size_t blockSize) {
+	xjni_arena_t *arena = ubase_cast(xjni_arena_t*,calloc(1,sizeof(xjni_arena_t)));
+	if (arena == NULL) return NULL;
+	arena->blockSize = blockSize ? blockSize : XJNI_ARENA_BLOCK;
+	return arena;
+}
+
+JNIEXPORTC void* JNICALL xjni_ArenaAlloc(xjni_arena_t *arena,size_t size) {
+	if (arena == NULL) return NULL;
+	size = (size + 7) & ~base_cast(size_t,7);
+	arena_block *head = arena->head;
+	if (head == NULL || head->size - head->used < size) {
+		/* Oversized requests get their own block behind the current one. */
+		arena_block *block = arena_block_new(size > arena->blockSize ? size : arena->blockSize);
+		if (block == NULL) return NULL;
+		if (head != NULL && size > arena->blockSize) {
+			block->next = head->next;
+			head->next = block;
+		} else {
+			block->next = head;
+			arena->head = block;
+		}
+		head = block;
+	}
+	void *p = head->data + head->used;
+	head->used += size;
+	return p;
+}
+
+JNIEXPORTC void JNICALL xjni_ArenaReset(xjni_arena_t *arena) {
+	if (arena == NULL || arena->head == NULL) return;
+	arena_block *keep = NULL;
+	for (arena_block *b = arena->head,*next; b != NULL; b = next) {
+		next = b->next;
+		if (keep == NULL && b->size == arena->blockSize) keep = b;
+		else free(b);
+	}
+	arena->head = keep;
+	if (keep != NULL) {
+		keep->next = NULL;
+		keep->used = 0;
+	}
+}
+
+JNIEXPORTC void JNICALL xjni_ArenaFree(xjni_arena_t *arena) {
+	if (arena == NULL) return;
+	for (arena_block *b = arena->head,*next; b != NULL; b = next) {
+		next = b->next;
+		free(b);
+	}
+	free(arena);
+}
+
+static jboolean marshal_kind(const char *sig,char *kind,xjni_ElementType *elem) {
+	if (sig == NULL) return JNI_FALSE;
+	if (strchr("ZBCSIJFD",sig[0]) != NULL && sig[0] != '\0' && sig[1] == '\0') {
+		*kind = sig[0];
+		return JNI_TRUE;
+	}
+	if (strcmp(sig,"Ljava/lang/String;") == 0) {
+		*kind = MARSHAL_STRING;
+		return JNI_TRUE;
+	}
+	if (sig[0] == '[' && sig[1] != '\0' && sig[2] == '\0' && strchr("ZBCSIJFD",sig[1]) != NULL) {
+		*kind = MARSHAL_ARRAY;
+		*elem = base_cast(xjni_ElementType,sig[1]);
+		return JNI_TRUE;
+	}
+	return JNI_FALSE;
+}
+
+/* Compile @p fields; field IDs are only resolved when @p resolve is set. */
+static xjni_marshal_t *marshal_new(JNIEnv *env,jclass cls,const xjni_field_t *fields,jsize count,size_t structSize,jboolean resolve) {
+	if (env == NULL || cls == NULL || (fields == NULL && count > 0) || count < 0) return NULL;
+	xjni_marshal_t *m = ubase_cast(xjni_marshal_t*,calloc(1,sizeof(xjni_marshal_t) + base_cast(size_t,count) * sizeof(marshal_field)));
+	if (m == NULL) return NULL;
+	m->structSize = structSize;
+	m->count = count;
+	for (jsize i = 0; i < count; i++) {
+		marshal_field *f = &m->fields[i];
+		f->offset = fields[i].offset;
+		if (!marshal_kind(fields[i].sig,&f->kind,&f->elem)) {
+			BASE_LOGE("xjni_MarshalCompile: unsupported signature \"%s\" for field %s\n",
+				fields[i].sig ? fields[i].sig : "(null)",fields[i].name ? fields[i].name : "(null)");
+			free(m);
+			return NULL;
+		}
+		if (!resolve) continue;
+		f->fid = xjni_GetFieldIDCached(env,cls,fields[i].name,fields[i].sig);
+		if (f->fid == NULL) {
+			free(m);
+			return NULL;
+		}
+	}
+	m->cls = ubase_cast(jclass,_NewGlobalRef(env,cls));
+	if (m->cls == NULL) {
+		free(m);
+		return NULL;
+	}
+	return m;
+}
+
+JNIEXPORTC xjni_marshal_t* JNICALL xjni_MarshalCompile(JNIEnv *env,jclass cls,const xjni_field_t *fields,jsize count,size_t structSize) {
+	return marshal_new(env,cls,fields,count,structSize,JNI_TRUE);
+}
+
+JNIEXPORTC void JNICALL xjni_MarshalFree(JNIEnv *env,xjni_marshal_t *marshal) {
+	if (marshal == NULL) return;
+	if (env != NULL && marshal->cls != NULL) _DeleteGlobalRef(env,marshal->cls);
+	if (env != NULL && marshal->factoryCls != NULL) _DeleteGlobalRef(env,marshal->factoryCls);
+	free(marshal);
+}
+
+/* String field into the arena; GetStringUTFRegion writes straight there without a temporary copy. */
+static jint marshal_string(JNIEnv *env,jstring str,const char **out,xjni_arena_t *arena) {
+	*out = NULL;
+	if (str == NULL) return JNI_OK;
+	jsize units = _GetStringLength(env,str);
+	jsize bytes = _GetStringUTFLength(env,str);
+	char *buf = ubase_cast(char*,xjni_ArenaAlloc(arena,base_cast(size_t,bytes) + 1));
+	if (buf == NULL) return JNI_ERR;
+	_GetStringUTFRegion(env,str,0,units,buf);
+	buf[bytes] = '\0';
+	*out = buf;
+	return JNI_OK;
+}
+
+static jint marshal_array(JNIEnv *env,jarray array,xjni_ElementType elem,xjni_view_t *out,xjni_arena_t *arena) {
+	out->data = NULL;
+	out->length = 0;
+	if (array == NULL) return JNI_OK;
+	jsize len = _GetArrayLength(env,array);
+	void *buf = xjni_ArenaAlloc(arena,base_cast(size_t,len) * xjni_ElementSize(elem) + 1);
+	if (buf == NULL) return JNI_ERR;
+	GetPrimitiveArrayRegion(env,elem,array,0,len,buf);
+	out->data = buf;
+	out->length = len;
+	return JNI_OK;
+}
+
+/* Copy one object; creates and deletes at most one local reference per field. */
+static jint marshal_one(JNIEnv *env,const xjni_marshal_t *m,jobject obj,char *out,xjni_arena_t *arena) {
+	for (jsize i = 0; i < m->count; i++) {
+		const marshal_field *f = &m->fields[i];
+		void *dst = out + f->offset;
+		switch (f->kind) {
+			case 'Z': *ubase_cast(jboolean*,dst) = _GetBooleanField(env,obj,f->fid); break;
+			case 'B': *ubase_cast(jbyte*,dst) = _GetByteField(env,obj,f->fid); break;
+			case 'C': *ubase_cast(jchar*,dst) = _GetCharField(env,obj,f->fid); break;
+			case 'S': *ubase_cast(jshort*,dst) = _GetShortField(env,obj,f->fid); break;
+			case 'I': *ubase_cast(jint*,dst) = _GetIntField(env,obj,f->fid); break;
+			case 'J': *ubase_cast(jlong*,dst) = _GetLongField(env,obj,f->fid); break;
+			case 'F': *ubase_cast(jfloat*,dst) = _GetFloatField(env,obj,f->fid); break;
+			case 'D': *ubase_cast(jdouble*,dst) = _GetDoubleField(env,obj,f->fid); break;
+			case MARSHAL_STRING: {
+				jstring str = ubase_cast(jstring,_GetObjectField(env,obj,f->fid));
+				jint ret = marshal_string(env,str,ubase_cast(const char**,dst),arena);
+				if (str) _DeleteLocalRef(env,str);
+				if (ret != JNI_OK) return JNI_ERR;
+				break;
+			}
+			case MARSHAL_ARRAY: {
+				jarray array = GetArrayField(env,obj,f->fid);
+				jint ret = marshal_array(env,array,f->elem,ubase_cast(xjni_view_t*,dst),arena);
+				if (array) _DeleteLocalRef(env,array);
+				if (ret != JNI_OK) return JNI_ERR;
+				break;
+			}
+			default: return JNI_ERR;
+		}
+	}
+	return _ExceptionCheck(env) ? JNI_ERR : JNI_OK;
+}
+
+JNIEXPORTC jint JNICALL xjni_MarshalObject(JNIEnv *env,const xjni_marshal_t *marshal,jobject obj,void *out,xjni_arena_t *arena) {
+	if (env == NULL || marshal == NULL || obj == NULL || out == NULL) return JNI_ERR;
+	return marshal_one(env,marshal,obj,ubase_cast(char*,out),arena);
+}
+
+JNIEXPORTC jint JNICALL xjni_MarshalObjectArray(JNIEnv *env,const xjni_marshal_t *marshal,jobjectArray objects,void *out,xjni_arena_t *arena) {
+	if (env == NULL || marshal == NULL || objects == NULL || out == NULL) return JNI_ERR;
+	jsize count = _GetArrayLength(env,objects);
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,count,2) != JNI_OK) return JNI_ERR;
+
+	jint ret = JNI_OK;
+	char *dst = ubase_cast(char*,out);
+	for (jsize i = 0; i < count && ret == JNI_OK; i++,dst += marshal->structSize) {
+		xjni_frame_next(&frame);
+		jobject obj = _GetObjectArrayElement(env,objects,i);
+		if (obj == NULL) {
+			memset(dst,0,marshal->structSize);
+			continue;
+		}
+		ret = marshal_one(env,marshal,obj,dst,arena);
+		_DeleteLocalRef(env,obj);
+	}
+	xjni_frame_leave(&frame,NULL);
+	return ret;
+}
+
+/* "(" + every field signature, each prefixed with @p prefix, + ")" + @p ret; caller frees. */
+static char *marshal_signature(const xjni_marshal_t *m,const xjni_field_t *fields,const char *prefix,const char *ret) {
+	size_t len = strlen(ret) + 3;
+	for (jsize i = 0; i < m->count; i++)
+		len += strlen(prefix) + strlen(fields[i].sig);
+	char *sig = ubase_cast(char*,malloc(len));
+	if (sig == NULL) return NULL;
+	char *p = sig;
+	*p++ = '(';
+	for (jsize i = 0; i < m->count; i++)
+		p += sprintf(p,"%s%s",prefix,fields[i].sig);
+	sprintf(p,")%s",ret);
+	return sig;
+}
+
+JNIEXPORTC xjni_marshal_t* JNICALL xjni_MarshalCompileBuilder(JNIEnv *env,jclass cls,const xjni_field_t *fields,jsize count,size_t structSize,jboolean constructor) {
+	xjni_marshal_t *m = marshal_new(env,cls,fields,count,structSize,constructor ? JNI_FALSE : JNI_TRUE);
+	if (m == NULL || !constructor) return m;
+	char *sig = marshal_signature(m,fields,"","V");
+	m->ctor = sig ? _GetMethodID(env,cls,"<init>",sig) : NULL;
+	free(sig);
+	if (m->ctor == NULL) {
+		xjni_MarshalFree(env,m);
+		return NULL;
+	}
+	return m;
+}
+
+JNIEXPORTC jint JNICALL xjni_MarshalSetFactory(JNIEnv *env,xjni_marshal_t *marshal,const xjni_field_t *fields,jclass factoryCls,const char *name,const char *returnSig) {
+	if (env == NULL || marshal == NULL || fields == NULL || factoryCls == NULL || name == NULL) return JNI_ERR;
+	char *sig = marshal_signature(marshal,fields,"[",returnSig ? returnSig : "[Ljava/lang/Object;");
+	jmethodID mid = sig ? _GetStaticMethodID(env,factoryCls,name,sig) : NULL;
+	free(sig);
+	if (mid == NULL) return JNI_ERR;
+	jclass global = ubase_cast(jclass,_NewGlobalRef(env,factoryCls));
+	if (global == NULL) return JNI_ERR;
+	if (marshal->factoryCls != NULL) _DeleteGlobalRef(env,marshal->factoryCls);
+	marshal->factoryCls = global;
+	marshal->factory = mid;
+	return JNI_OK;
+}
+
+/* New local reference for a String or array member, NULL for a null member. */
+static jobject build_reference(JNIEnv *env,const marshal_field *f,const char *src) {
+	if (f->kind == MARSHAL_STRING) {
+		const char *utf = *ubase_cast(const char* const*,src);
+		return utf ? ubase_cast(jobject,_NewStringUTF(env,utf)) : NULL;
+	}
+	const xjni_view_t *view = ubase_cast(const xjni_view_t*,src);
+	if (view->data == NULL) return NULL;
+	jarray array = NewPrimitiveArray(env,f->elem,view->length);
+	if (array != NULL && view->length > 0)
+		SetPrimitiveArrayRegion(env,f->elem,array,0,view->length,view->data);
+	return array;
+}
+
+/* Delete the String and array arguments among the first @p count constructor arguments. */
+static void build_release(JNIEnv *env,const xjni_marshal_t *m,const jvalue *args,jsize count) {
+	for (jsize i = 0; i < count; i++)
+		if ((m->fields[i].kind == MARSHAL_STRING || m->fields[i].kind == MARSHAL_ARRAY) && args[i].l != NULL)
+			_DeleteLocalRef(env,args[i].l);
+}
+
+static jobject build_one(JNIEnv *env,const xjni_marshal_t *m,const char *src) {
+	if (m->ctor != NULL) {
+		jvalue stack[16] = {0};
+		jvalue *args = m->count <= 16 ? stack : ubase_cast(jvalue*,malloc(base_cast(size_t,m->count) * sizeof(jvalue)));
+		if (args == NULL) return NULL;
+		for (jsize i = 0; i < m->count; i++) {
+			const marshal_field *f = &m->fields[i];
+			const char *p = src + f->offset;
+			switch (f->kind) {
+				case 'Z': args[i].z = *ubase_cast(const jboolean*,p); break;
+				case 'B': args[i].b = *ubase_cast(const jbyte*,p); break;
+				case 'C': args[i].c = *ubase_cast(const jchar*,p); break;
+				case 'S': args[i].s = *ubase_cast(const jshort*,p); break;
+				case 'I': args[i].i = *ubase_cast(const jint*,p); break;
+				case 'J': args[i].j = *ubase_cast(const jlong*,p); break;
+				case 'F': args[i].f = *ubase_cast(const jfloat*,p); break;
+				case 'D': args[i].d = *ubase_cast(const jdouble*,p); break;
+				default:
+					args[i].l = build_reference(env,f,p);
+					if (args[i].l == NULL && _ExceptionCheck(env)) {
+						/* no constructor call with an exception pending: drop the members built so far */
+						build_release(env,m,args,i);
+						if (args != stack) free(args);
+						return NULL;
+					}
+					break;
+			}
+		}
+		jobject obj = _NewObjectA(env,m->cls,m->ctor,args);
+		build_release(env,m,args,m->count);
+		if (args != stack) free(args);
+		return obj;
+	}
+
+	jobject obj = _AllocObject(env,m->cls);
+	if (obj == NULL) return NULL;
+	for (jsize i = 0; i < m->count; i++) {
+		const marshal_field *f = &m->fields[i];
+		const char *p = src + f->offset;
+		switch (f->kind) {
+			case 'Z': _SetBooleanField(env,obj,f->fid,*ubase_cast(const jboolean*,p)); break;
+			case 'B': _SetByteField(env,obj,f->fid,*ubase_cast(const jbyte*,p)); break;
+			case 'C': _SetCharField(env,obj,f->fid,*ubase_cast(const jchar*,p)); break;
+			case 'S': _SetShortField(env,obj,f->fid,*ubase_cast(const jshort*,p)); break;
+			case 'I': _SetIntField(env,obj,f->fid,*ubase_cast(const jint*,p)); break;
+			case 'J': _SetLongField(env,obj,f->fid,*ubase_cast(const jlong*,p)); break;
+			case 'F': _SetFloatField(env,obj,f->fid,*ubase_cast(const jfloat*,p)); break;
+			case 'D': _SetDoubleField(env,obj,f->fid,*ubase_cast(const jdouble*,p)); break;
+			default: {
+				jobject ref = build_reference(env,f,p);
+				if (ref == NULL && _ExceptionCheck(env)) {
+					_DeleteLocalRef(env,obj);
+					return NULL;
+				}
+				if (ref != NULL) {
+					_SetObjectField(env,obj,f->fid,ref);
+					_DeleteLocalRef(env,ref);
+				}
+				break;
+			}
+		}
+	}
+	return obj;
+}
+
+JNIEXPORTC jobject JNICALL xjni_BuildObject(JNIEnv *env,const xjni_marshal_t *marshal,const void *in) {
+	if (env == NULL || marshal == NULL || in == NULL) return NULL;
+	jobject obj = build_one(env,marshal,ubase_cast(const char*,in));
+	if (obj != NULL && _ExceptionCheck(env)) {
+		_DeleteLocalRef(env,obj);
+		return NULL;
+	}
+	return obj;
+}
+
+/* One Java array holding member @p f of every struct: T[] for primitives, String[], or T[][]. */
+static jobject build_column(JNIEnv *env,const xjni_marshal_t *m,const marshal_field *f,const char *in,jsize count) {
+	if (f->kind == MARSHAL_STRING || f->kind == MARSHAL_ARRAY) {
+		jclass cls = NULL;
+		if (f->kind == MARSHAL_STRING) {
+			cls = xjni_GetStringClass(env);
+		} else {
+			char sig[3] = { '[',base_cast(char,f->elem),'\0' };
+			cls = _FindClass(env,sig);
+		}
+		if (cls == NULL) return NULL;
+		jobjectArray column = _NewObjectArray(env,count,cls,NULL);
+		if (f->kind == MARSHAL_ARRAY) _DeleteLocalRef(env,cls);
+		if (column == NULL) return NULL;
+		xjni_frame_t frame;
+		if (xjni_frame_enter(&frame,env,count,1) != JNI_OK) {
+			_DeleteLocalRef(env,column);
+			return NULL;
+		}
+		jboolean failed = JNI_FALSE;
+		for (jsize i = 0; i < count; i++) {
+			xjni_frame_next(&frame);
+			jobject ref = build_reference(env,f,in + base_cast(size_t,i) * m->structSize + f->offset);
+			if (ref == NULL) {
+				/* a NULL member stays null; a NULL from a failed allocation ends the column */
+				if (_ExceptionCheck(env)) {
+					failed = JNI_TRUE;
+					break;
+				}
+				continue;
+			}
+			_SetObjectArrayElement(env,column,i,ref);
+			_DeleteLocalRef(env,ref);
+		}
+		xjni_frame_leave(&frame,NULL);
+		if (failed) {
+			_DeleteLocalRef(env,column);
+			return NULL;
+		}
+		return column;
+	}
+
+	xjni_ElementType type = base_cast(xjni_ElementType,f->kind);
+	size_t esize = xjni_ElementSize(type);
+	char *tmp = ubase_cast(char*,malloc(base_cast(size_t,count) * esize + 1));
+	if (tmp == NULL) return NULL;
+	for (jsize i = 0; i < count; i++)
+		memcpy(tmp + base_cast(size_t,i) * esize,in + base_cast(size_t,i) * m->structSize + f->offset,esize);
+	jarray column = NewPrimitiveArray(env,type,count);
+	if (column != NULL && count > 0)
+		SetPrimitiveArrayRegion(env,type,column,0,count,tmp);
+	free(tmp);
+	return column;
+}
+
+static jobjectArray build_factory(JNIEnv *env,const xjni_marshal_t *m,const char *in,jsize count) {
+	jvalue stack[16] = {0};
+	jvalue *args = m->count <= 16 ? stack : ubase_cast(jvalue*,calloc(base_cast(size_t,m->count),sizeof(jvalue)));
+	if (args == NULL) return NULL;
+	jobjectArray result = NULL;
+	jsize built = 0;
+	for (; built < m->count; built++) {
+		args[built].l = build_column(env,m,&m->fields[built],in,count);
+		if (args[built].l == NULL) break;
+	}
+	if (built == m->count) {
+		result = ubase_cast(jobjectArray,_CallStaticObjectMethodA(env,m->factoryCls,m->factory,args));
+		if (_ExceptionCheck(env) && result != NULL) {
+			_DeleteLocalRef(env,result);
+			result = NULL;
+		}
+	}
+	for (jsize i = 0; i < built; i++)
+		_DeleteLocalRef(env,args[i].l);
+	if (args != stack) free(args);
+	return result;
+}
+
+JNIEXPORTC jobjectArray JNICALL xjni_BuildObjectArray(JNIEnv *env,const xjni_marshal_t *marshal,const void *in,jsize count) {
+	if (env == NULL || marshal == NULL || (in == NULL && count > 0) || count < 0) return NULL;
+	const char *src = ubase_cast(const char*,in);
+	if (marshal->factory != NULL)
+		return build_factory(env,marshal,src,count);
+
+	jobjectArray result = _NewObjectArray(env,count,marshal->cls,NULL);
+	if (result == NULL) return NULL;
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,count,marshal->count + 2) != JNI_OK) {
+		_DeleteLocalRef(env,result);
+		return NULL;
+	}
+	jboolean failed = JNI_FALSE;
+	for (jsize i = 0; i < count; i++,src += marshal->structSize) {
+		xjni_frame_next(&frame);
+		jobject obj = build_one(env,marshal,src);
+		if (obj == NULL || _ExceptionCheck(env)) {
+			failed = JNI_TRUE;
+			break;
+		}
+		_SetObjectArrayElement(env,result,i,obj);
+		_DeleteLocalRef(env,obj);
+	}
+	xjni_frame_leave(&frame,NULL);
+	if (failed) {
+		_DeleteLocalRef(env,result);
+		return NULL;
+	}
+	return result;
+}
@@ -0,0 +1,283 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jni.h>
+
+#define LOG_TAG "xjni"
+#include "base-jni.h"
+
+#include <xjni.h>
+
+typedef struct nd_walk {
+	JNIEnv *env;
+	xjni_ElementType type;
+	jint rank;
+	const jsize *shape;
+	const size_t *strides;
+	size_t esize;
+	char *buf;      /* NULL: validate shape only */
+	jboolean store; /* JNI_TRUE: native buffer -> Java */
+} nd_walk;
+
+typedef struct nd_new {
+	JNIEnv *env;
+	xjni_ElementType type;
+	jint rank;
+	const jsize *shape;
+	const size_t *strides;
+	size_t esize;
+	const char *data;
+	jclass *classes;
+} nd_new;
+
+JNIEXPORTC size_t JNICALL xjni_ElementSize(xjni_ElementType type) {
+	switch (type) {
+		case XJNI_TYPE_BOOLEAN: return sizeof(jboolean);
+		case XJNI_TYPE_BYTE: return sizeof(jbyte);
+		case XJNI_TYPE_CHAR: return sizeof(jchar);
+		case XJNI_TYPE_SHORT: return sizeof(jshort);
+		case XJNI_TYPE_INT: return sizeof(jint);
+		case XJNI_TYPE_LONG: return sizeof(jlong);
+		case XJNI_TYPE_FLOAT: return sizeof(jfloat);
+		case XJNI_TYPE_DOUBLE: return sizeof(jdouble);
+		default: return 0;
+	}
+}
+
+JNIEXPORTC jarray JNICALL NewPrimitiveArray(JNIEnv *env,xjni_ElementType type,jsize len) {
+	if (env == NULL || len < 0) return NULL;
+	switch (type) {
+		case XJNI_TYPE_BOOLEAN: return _NewBooleanArray(env,len);
+		case XJNI_TYPE_BYTE: return _NewByteArray(env,len);
+		case XJNI_TYPE_CHAR: return _NewCharArray(env,len);
+		case XJNI_TYPE_SHORT: return _NewShortArray(env,len);
+		case XJNI_TYPE_INT: return _NewIntArray(env,len);
+		case XJNI_TYPE_LONG: return _NewLongArray(env,len);
+		case XJNI_TYPE_FLOAT: return _NewFloatArray(env,len);
+		case XJNI_TYPE_DOUBLE: return _NewDoubleArray(env,len);
+		default: return NULL;
+	}
+}
+
+JNIEXPORTC void JNICALL GetPrimitiveArrayRegion(JNIEnv *env,xjni_ElementType type,jarray array,jsize start,jsize len,void *buf) {
+	if (env == NULL || array == NULL || buf == NULL) return;
+	switch (type) {
+		case XJNI_TYPE_BOOLEAN: BASEJNIC(GetBooleanArrayRegion,env,array,start,len,ubase_cast(jboolean*,buf)); break;
+		case XJNI_TYPE_BYTE: BASEJNIC(GetByteArrayRegion,env,array,start,len,ubase_cast(jbyte*,buf)); break;
+		case XJNI_TYPE_CHAR: BASEJNIC(GetCharArrayRegion,env,array,start,len,ubase_cast(jchar*,buf)); break;
+		case XJNI_TYPE_SHORT: BASEJNIC(GetShortArrayRegion,env,array,start,len,ubase_cast(jshort*,buf)); break;
+		case XJNI_TYPE_INT: BASEJNIC(GetIntArrayRegion,env,array,start,len,ubase_cast(jint*,buf)); break;
+		case XJNI_TYPE_LONG: BASEJNIC(GetLongArrayRegion,env,array,start,len,ubase_cast(jlong*,buf)); break;
+		case XJNI_TYPE_FLOAT: BASEJNIC(GetFloatArrayRegion,env,array,start,len,ubase_cast(jfloat*,buf)); break;
+		case XJNI_TYPE_DOUBLE: BASEJNIC(GetDoubleArrayRegion,env,array,start,len,ubase_cast(jdouble*,buf)); break;
+		default: break;
+	}
+}
+
+JNIEXPORTC void JNICALL SetPrimitiveArrayRegion(JNIEnv *env,xjni_ElementType type,jarray array,jsize start,jsize len,const void *buf) {
+	if (env == NULL || array == NULL || buf == NULL) return;
+	switch (type) {
+		case XJNI_TYPE_BOOLEAN: BASEJNIC(SetBooleanArrayRegion,env,array,start,len,ubase_cast(const jboolean*,buf)); break;
+		case XJNI_TYPE_BYTE: BASEJNIC(SetByteArrayRegion,env,array,start,len,ubase_cast(const jbyte*,buf)); break;
+		case XJNI_TYPE_CHAR: BASEJNIC(SetCharArrayRegion,env,array,start,len,ubase_cast(const jchar*,buf)); break;
+		case XJNI_TYPE_SHORT: BASEJNIC(SetShortArrayRegion,env,array,start,len,ubase_cast(const jshort*,buf)); break;
+		case XJNI_TYPE_INT: BASEJNIC(SetIntArrayRegion,env,array,start,len,ubase_cast(const jint*,buf)); break;
+		case XJNI_TYPE_LONG: BASEJNIC(SetLongArrayRegion,env,array,start,len,ubase_cast(const jlong*,buf)); break;
+		case XJNI_TYPE_FLOAT: BASEJNIC(SetFloatArrayRegion,env,array,start,len,ubase_cast(const jfloat*,buf)); break;
+		case XJNI_TYPE_DOUBLE: BASEJNIC(SetDoubleArrayRegion,env,array,start,len,ubase_cast(const jdouble*,buf)); break;
+		default: break;
+	}
+}
+
+JNIEXPORTC size_t JNICALL GetNDArrayCount(jint rank,const jsize *shape) {
+	if (rank < 1 || shape == NULL) return 0;
+	size_t count = 1;
+	for (jint d = 0; d < rank; d++) {
+		if (shape[d] < 0) return 0;
+		if (shape[d] != 0 && count > SIZE_MAX / base_cast(size_t,shape[d])) return 0;
+		count *= base_cast(size_t,shape[d]);
+	}
+	return count;
+}
+
+JNIEXPORTC void JNICALL GetNDArrayStrides(jint rank,const jsize *shape,size_t *strides) {
+	if (rank < 1 || shape == NULL || strides == NULL) return;
+	strides[rank - 1] = 1;
+	for (jint d = rank - 1; d > 0; d--)
+		strides[d - 1] = strides[d] * base_cast(size_t,shape[d]);
+}
+
+/* Copy one innermost array; a non-unit inner stride goes through a pinned pointer. */
+static jint nd_copy_leaf(nd_walk *w,jarray leaf,size_t offset) {
+	JNIEnv *env = w->env;
+	jsize len = w->shape[w->rank - 1];
+	size_t step = w->strides[w->rank - 1];
+	char *dst = w->buf + offset * w->esize;
+
+	if (len == 0) return JNI_OK;
+	if (step == 1) {
+		if (w->store) SetPrimitiveArrayRegion(env,w->type,leaf,0,len,dst);
+		else GetPrimitiveArrayRegion(env,w->type,leaf,0,len,dst);
+		return _ExceptionCheck(env) ? JNI_ERR : JNI_OK;
+	}
+
+	char *elems = ubase_cast(char*,_GetPrimitiveArrayCritical(env,leaf,NULL));
+	if (elems == NULL) return JNI_ERR;
+	for (jsize i = 0; i < len; i++) {
+		char *native = dst + base_cast(size_t,i) * step * w->esize;
+		char *java = elems + base_cast(size_t,i) * w->esize;
+		if (w->store) memcpy(java,native,w->esize);
+		else memcpy(native,java,w->esize);
+	}
+	_ReleasePrimitiveArrayCritical(env,leaf,elems,w->store ? 0 : JNI_ABORT);
+	return JNI_OK;
+}
+
+static jint nd_walk_level(nd_walk *w,jarray array,jint depth,size_t offset) {
+	JNIEnv *env = w->env;
+	if (array == NULL || _GetArrayLength(env,array) != w->shape[depth])
+		return JNI_ERR;
+
+	if (depth == w->rank - 1)
+		return w->buf ? nd_copy_leaf(w,array,offset) : JNI_OK;
+
+	for (jsize i = 0; i < w->shape[depth]; i++) {
+		jarray child = ubase_cast(jarray,_GetObjectArrayElement(env,ubase_cast(jobjectArray,array),i));
+		jint ret = nd_walk_level(w,child,depth + 1,offset + base_cast(size_t,i) * w->strides[depth]);
+		if (child) _DeleteLocalRef(env,child);
+		if (ret != JNI_OK) return ret;
+	}
+	return JNI_OK;
+}
+
+/* Walk the whole tree inside its own frame; at most one reference per level is live. */
+static jint nd_walk_run(nd_walk *w,jarray array) {
+	size_t packed[XJNI_ND_MAX_RANK];
+	if (w->strides == NULL) {
+		GetNDArrayStrides(w->rank,w->shape,packed);
+		w->strides = packed;
+	}
+	if (_PushLocalFrame(w->env,w->rank + 4) != JNI_OK) return JNI_ERR;
+	jint ret = nd_walk_level(w,array,0,0);
+	_PopLocalFrame(w->env,NULL);
+	return ret;
+}
+
+JNIEXPORTC jint JNICALL GetNDArrayShape(JNIEnv *env,jarray array,jint rank,jsize *shape) {
+	if (env == NULL || array == NULL || shape == NULL || rank < 1 || rank > XJNI_ND_MAX_RANK)
+		return JNI_ERR;
+	if (_PushLocalFrame(env,rank + 4) != JNI_OK) return JNI_ERR;
+
+	/* Follow the first element of every level for the candidate shape. */
+	jarray cur = array;
+	jint d = 0;
+	for (; d < rank; d++) {
+		if (cur == NULL) break;
+		shape[d] = _GetArrayLength(env,cur);
+		if (d == rank - 1 || shape[d] == 0) { d++; break; }
+		cur = ubase_cast(jarray,_GetObjectArrayElement(env,ubase_cast(jobjectArray,cur),0));
+	}
+	jboolean missing = (cur == NULL) ? JNI_TRUE : JNI_FALSE;
+	for (; d < rank; d++) shape[d] = 0;
+	_PopLocalFrame(env,NULL);
+	if (missing) return JNI_ERR;
+
+	nd_walk w = { env,XJNI_TYPE_INT,rank,shape,NULL,0,NULL,JNI_FALSE };
+	return nd_walk_run(&w,array);
+}
+
+JNIEXPORTC jint JNICALL GetNDArrayRegion(JNIEnv *env,jarray array,xjni_ElementType type,jint rank,const jsize *shape,const size_t *strides,void *buf) {
+	if (env == NULL || array == NULL || shape == NULL || buf == NULL || rank < 1 || rank > XJNI_ND_MAX_RANK)
+		return JNI_ERR;
+	size_t esize = xjni_ElementSize(type);
+	if (esize == 0) return JNI_ERR;
+	nd_walk w = { env,type,rank,shape,strides,esize,ubase_cast(char*,buf),JNI_FALSE };
+	return nd_walk_run(&w,array);
+}
+
+JNIEXPORTC jint JNICALL SetNDArrayRegion(JNIEnv *env,jarray array,xjni_ElementType type,jint rank,const jsize *shape,const size_t *strides,const void *buf) {
+	if (env == NULL || array == NULL || shape == NULL || buf == NULL || rank < 1 || rank > XJNI_ND_MAX_RANK)
+		return JNI_ERR;
+	size_t esize = xjni_ElementSize(type);
+	if (esize == 0) return JNI_ERR;
+	nd_walk w = { env,type,rank,shape,strides,esize,ubase_cast(char*,buf),JNI_TRUE };
+	return nd_walk_run(&w,array);
+}
+
+static jarray nd_new_level(nd_new *n,jint depth,size_t offset) {
+	JNIEnv *env = n->env;
+	jsize len = n->shape[depth];
+
+	if (depth == n->rank - 1) {
+		jarray leaf = NewPrimitiveArray(env,n->type,len);
+		if (leaf && n->data && len > 0)
+			SetPrimitiveArrayRegion(env,n->type,leaf,0,len,n->data + offset * n->esize);
+		return leaf;
+	}
+
+	jobjectArray outer = _NewObjectArray(env,len,n->classes[depth],NULL);
+	if (outer == NULL) return NULL;
+	for (jsize i = 0; i < len; i++) {
+		jarray child = nd_new_level(n,depth + 1,offset + base_cast(size_t,i) * n->strides[depth]);
+		if (child == NULL) {
+			_DeleteLocalRef(env,outer);
+			return NULL;
+		}
+		_SetObjectArrayElement(env,outer,i,child);
+		_DeleteLocalRef(env,child);
+	}
+	return outer;
+}
+
+JNIEXPORTC jarray JNICALL NewNDArray(JNIEnv *env,xjni_ElementType type,jint rank,const jsize *shape,const void *data) {
+	if (env == NULL || shape == NULL || rank < 1 || rank > XJNI_ND_MAX_RANK)
+		return NULL;
+	size_t esize = xjni_ElementSize(type);
+	if (esize == 0) return NULL;
+	for (jint d = 0; d < rank; d++)
+		if (shape[d] < 0) return NULL;
+
+	size_t strides[XJNI_ND_MAX_RANK];
+	jclass classes[XJNI_ND_MAX_RANK];
+	char sig[XJNI_ND_MAX_RANK + 1];
+	GetNDArrayStrides(rank,shape,strides);
+
+	if (_PushLocalFrame(env,2 * rank + 4) != JNI_OK) return NULL;
+
+	/* classes[d] is the element class of a depth-d array: "[..[T" with rank-1-d brackets */
+	for (jint d = 0; d < rank - 1; d++) {
+		jint dims = rank - 1 - d;
+		memset(sig,'[',base_cast(size_t,dims));
+		sig[dims] = base_cast(char,type);
+		sig[dims + 1] = '\0';
+		classes[d] = _FindClass(env,sig);
+		if (classes[d] == NULL) {
+			_PopLocalFrame(env,NULL);
+			return NULL;
+		}
+	}
+
+	nd_new n = { env,type,rank,shape,strides,esize,ubase_cast(const char*,data),classes };
+	jarray result = nd_new_level(&n,0,0);
+	return ubase_cast(jarray,_PopLocalFrame(env,result));
+}
+
+#define NDArrayFuncs(T,type,jtype)\
+JNIEXPORTC jarray JNICALL New##T##NDArray(JNIEnv *env,jint rank,const jsize *shape,const jtype *data) {\
+	return NewNDArray(env,type,rank,shape,data);\
+}\
+JNIEXPORTC jint JNICALL Get##T##NDArrayRegion(JNIEnv *env,jarray array,jint rank,const jsize *shape,jtype *buf) {\
+	return GetNDArrayRegion(env,array,type,rank,shape,NULL,buf);\
+}\
+JNIEXPORTC jint JNICALL Set##T##NDArrayRegion(JNIEnv *env,jarray array,jint rank,const jsize *shape,const jtype *buf) {\
+	return SetNDArrayRegion(env,array,type,rank,shape,NULL,buf);\
+}
+
+NDArrayFuncs(Boolean,XJNI_TYPE_BOOLEAN,jboolean)
+NDArrayFuncs(Byte,XJNI_TYPE_BYTE,jbyte)
+NDArrayFuncs(Char,XJNI_TYPE_CHAR,jchar)
+NDArrayFuncs(Short,XJNI_TYPE_SHORT,jshort)
+NDArrayFuncs(Int,XJNI_TYPE_INT,jint)
+NDArrayFuncs(Long,XJNI_TYPE_LONG,jlong)
+NDArrayFuncs(Float,XJNI_TYPE_FLOAT,jfloat)
+NDArrayFuncs(Double,XJNI_TYPE_DOUBLE,jdouble)
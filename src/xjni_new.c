@@ -1,13 +1,33 @@
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 #define LOG_TAG "xjni"
 #include "base-jni.h"
 
 #include <xjni.h>
+#include "xjni_lock.h"
 
 static JavaVM* g_vm = NULL;
 static jobject g_classLoader = NULL;
 static jmethodID g_loadClass = NULL;
 
+/* Method IDs resolved by the Call*MethodBuilder functions, keyed by class name, method name, signature and kind */
+#define XJNI_METHOD_CACHE_SIZE 128
+
+typedef struct method_entry {
+	char *className;
+	char *name;
+	char *sig;
+	jboolean isStatic;
+	jclass cls;
+	jmethodID mid;
+} method_entry;
+
+static method_entry methodCache[XJNI_METHOD_CACHE_SIZE];
+static pthread_mutex_t methodCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void method_cache_clear(JNIEnv* env);
+
 JNIEXPORTC jobjectArray JNICALL xjni_NewObjectArray(JNIEnv* env,jclass clz,jsize len) {
 	if (clz == NULL || len < 0) return NULL;
 	jobjectArray a = _NewObjectArray(env,len,clz,NULL);
@@ -96,6 +116,7 @@ JNIEXPORTC void JNICALL XJNI_New_OnUnload(JavaVM* vm,void* reserved,jint ver) {
 		g_classLoader = NULL;
 	}
 
+	method_cache_clear(env);
 	g_loadClass = NULL;
 	g_vm = NULL;
 }
@@ -146,3 +167,263 @@ JNIEXPORTC jobject JNICALL NewObjectBuilder(JNIEnv* env,const char* className,co
 	return obj;
 }
 
+
+static void method_cache_clear(JNIEnv* env) {
+	pthread_mutex_lock(&methodCacheMutex);
+	for (size_t i = 0; i < XJNI_METHOD_CACHE_SIZE; i++) {
+		method_entry* e = &methodCache[i];
+		if (!e->mid) continue;
+		_DeleteGlobalRef(env,e->cls);
+		free(e->className);
+		memset(e,0,sizeof(*e));
+	}
+	pthread_mutex_unlock(&methodCacheMutex);
+}
+
+static size_t method_hash(const char* className,const char* name,const char* sig,jboolean isStatic) {
+	size_t h = isStatic ? 2166136261u : 16777619u;
+	const char* parts[3] = { className,name,sig };
+	for (int k = 0; k < 3; k++)
+		for (const char* p = parts[k]; *p; p++)
+			h = (h ^ (unsigned char)*p) * 16777619u;
+	return h;
+}
+
+/* Entry for the key, or the first free slot on its probe path (NULL when the table is full); lock held */
+static method_entry* method_probe(const char* className,const char* name,const char* sig,jboolean isStatic) {
+	size_t start = method_hash(className,name,sig,isStatic) % XJNI_METHOD_CACHE_SIZE;
+	for (size_t n = 0; n < XJNI_METHOD_CACHE_SIZE; n++) {
+		method_entry* e = &methodCache[(start + n) % XJNI_METHOD_CACHE_SIZE];
+		if (!e->mid)
+			return e;
+		if (e->isStatic == isStatic && !strcmp(e->className,className) && !strcmp(e->name,name) && !strcmp(e->sig,sig))
+			return e;
+	}
+	return NULL;
+}
+
+/*
+ * Resolve a method through the cache. *cls receives the declaring class: a
+ * cached global reference, or a local reference the caller deletes when
+ * *local is set (the table was full). The class is looked up without the
+ * lock held, since loading it may run Java code that calls back in here.
+ */
+static jmethodID method_cached(JNIEnv* env,const char* className,const char* name,const char* sig,jboolean isStatic,jclass* cls,jboolean* local) {
+	*cls = NULL;
+	*local = JNI_FALSE;
+	if (!env || !className || !name || !sig)
+		return NULL;
+
+	pthread_mutex_lock(&methodCacheMutex);
+	method_entry* e = method_probe(className,name,sig,isStatic);
+	if (e && e->mid) {
+		jmethodID mid = e->mid;
+		*cls = e->cls;
+		pthread_mutex_unlock(&methodCacheMutex);
+		return mid;
+	}
+	pthread_mutex_unlock(&methodCacheMutex);
+
+	jclass found = FindClassSafe(env,className);
+	if (!found)
+		return NULL;
+	jmethodID mid = isStatic ? _GetStaticMethodID(env,found,name,sig) : _GetMethodID(env,found,name,sig);
+	if (!mid) {
+		_DeleteLocalRef(env,found);
+		return NULL;
+	}
+
+	size_t lc = strlen(className) + 1,ln = strlen(name) + 1,ls = strlen(sig) + 1;
+	char* keys = (char*)malloc(lc + ln + ls);
+	jclass global = keys ? (jclass)_NewGlobalRef(env,found) : NULL;
+	pthread_mutex_lock(&methodCacheMutex);
+	e = global ? method_probe(className,name,sig,isStatic) : NULL;
+	if (e && !e->mid) {
+		e->className = memcpy(keys,className,lc);
+		e->name = memcpy(keys + lc,name,ln);
+		e->sig = memcpy(keys + lc + ln,sig,ls);
+		e->isStatic = isStatic;
+		e->cls = global;
+		e->mid = mid;
+		keys = NULL;
+		global = NULL;
+	}
+	if (e) {
+		/* ours, or another thread's made meanwhile */
+		mid = e->mid;
+		*cls = e->cls;
+	}
+	pthread_mutex_unlock(&methodCacheMutex);
+	free(keys);
+	if (global) _DeleteGlobalRef(env,global);
+	if (e) {
+		_DeleteLocalRef(env,found);
+	} else {
+		*cls = found;
+		*local = JNI_TRUE;
+	}
+	return mid;
+}
+
+/* Number of parameters in a method signature, -1 if it is malformed */
+static jsize method_arg_count(const char* sig) {
+	if (*sig++ != '(')
+		return -1;
+	jsize count = 0;
+	while (*sig && *sig != ')') {
+		while (*sig == '[') sig++;
+		if (*sig == 'L') {
+			sig = strchr(sig,';');
+			if (!sig) return -1;
+		} else if (!strchr("ZBCSIJFD",*sig)) {
+			return -1;
+		}
+		sig++;
+		count++;
+	}
+	return *sig == ')' ? count : -1;
+}
+
+/* Read the arguments described by sig from ap into args, with the default argument promotions */
+static void method_args(const char* sig,va_list ap,jvalue* args) {
+	jsize i = 0;
+	for (sig++; *sig != ')'; sig++,i++) {
+		if (*sig == '[' || *sig == 'L') {
+			while (*sig == '[') sig++;
+			if (*sig == 'L') sig = strchr(sig,';');
+			args[i].l = va_arg(ap,jobject);
+			continue;
+		}
+		switch (*sig) {
+			case 'Z': args[i].z = (jboolean)va_arg(ap,int); break;
+			case 'B': args[i].b = (jbyte)va_arg(ap,int); break;
+			case 'C': args[i].c = (jchar)va_arg(ap,int); break;
+			case 'S': args[i].s = (jshort)va_arg(ap,int); break;
+			case 'I': args[i].i = va_arg(ap,jint); break;
+			case 'J': args[i].j = va_arg(ap,jlong); break;
+			case 'F': args[i].f = (jfloat)va_arg(ap,double); break;
+			case 'D': args[i].d = va_arg(ap,double); break;
+		}
+	}
+}
+
+/* The jvalue array of a va_list call: on the stack up to XJNI_CALL_STACK_ARGS arguments */
+#define XJNI_CALL_STACK_ARGS 16
+
+#define METHOD_ARGS_BEGIN(sig,ap,zero) \
+	jvalue stack[XJNI_CALL_STACK_ARGS]; \
+	jsize argc = sig ? method_arg_count(sig) : -1; \
+	if (argc < 0) return zero; \
+	jvalue* args = argc <= XJNI_CALL_STACK_ARGS ? stack : (jvalue*)malloc(sizeof(jvalue) * (size_t)argc); \
+	if (!args) return zero; \
+	va_list copy; \
+	va_copy(copy,ap); \
+	method_args(sig,copy,args); \
+	va_end(copy)
+
+#define METHOD_ARGS_END() \
+	if (args != stack) free(args)
+
+#define DEFINE_CALL_BUILDER(Type,jtype,zero) \
+JNIEXPORTC jtype JNICALL Call##Type##MethodBuilderA(JNIEnv* env,jobject obj,const char* className,const char* name,const char* sig,const jvalue* args) { \
+	jclass cls; \
+	jboolean local; \
+	jmethodID mid = method_cached(env,className,name,sig,JNI_FALSE,&cls,&local); \
+	if (local) _DeleteLocalRef(env,cls); \
+	if (!mid || !obj) return zero; \
+	return _Call##Type##MethodA(env,obj,mid,args); \
+} \
+\
+JNIEXPORTC jtype JNICALL Call##Type##MethodBuilderV(JNIEnv* env,jobject obj,const char* className,const char* name,const char* sig,va_list ap) { \
+	METHOD_ARGS_BEGIN(sig,ap,zero); \
+	jtype ret = Call##Type##MethodBuilderA(env,obj,className,name,sig,args); \
+	METHOD_ARGS_END(); \
+	return ret; \
+} \
+\
+JNIEXPORTC jtype JNICALL Call##Type##MethodBuilder(JNIEnv* env,jobject obj,const char* className,const char* name,const char* sig,...) { \
+	va_list ap; \
+	va_start(ap,sig); \
+	jtype ret = Call##Type##MethodBuilderV(env,obj,className,name,sig,ap); \
+	va_end(ap); \
+	return ret; \
+} \
+\
+JNIEXPORTC jtype JNICALL CallStatic##Type##MethodBuilderA(JNIEnv* env,const char* className,const char* name,const char* sig,const jvalue* args) { \
+	jclass cls; \
+	jboolean local; \
+	jmethodID mid = method_cached(env,className,name,sig,JNI_TRUE,&cls,&local); \
+	if (!mid) return zero; \
+	jtype ret = _CallStatic##Type##MethodA(env,cls,mid,args); \
+	if (local) _DeleteLocalRef(env,cls); \
+	return ret; \
+} \
+\
+JNIEXPORTC jtype JNICALL CallStatic##Type##MethodBuilderV(JNIEnv* env,const char* className,const char* name,const char* sig,va_list ap) { \
+	METHOD_ARGS_BEGIN(sig,ap,zero); \
+	jtype ret = CallStatic##Type##MethodBuilderA(env,className,name,sig,args); \
+	METHOD_ARGS_END(); \
+	return ret; \
+} \
+\
+JNIEXPORTC jtype JNICALL CallStatic##Type##MethodBuilder(JNIEnv* env,const char* className,const char* name,const char* sig,...) { \
+	va_list ap; \
+	va_start(ap,sig); \
+	jtype ret = CallStatic##Type##MethodBuilderV(env,className,name,sig,ap); \
+	va_end(ap); \
+	return ret; \
+}
+
+DEFINE_CALL_BUILDER(Object,jobject,NULL)
+DEFINE_CALL_BUILDER(Boolean,jboolean,JNI_FALSE)
+DEFINE_CALL_BUILDER(Byte,jbyte,0)
+DEFINE_CALL_BUILDER(Char,jchar,0)
+DEFINE_CALL_BUILDER(Short,jshort,0)
+DEFINE_CALL_BUILDER(Int,jint,0)
+DEFINE_CALL_BUILDER(Long,jlong,0)
+DEFINE_CALL_BUILDER(Float,jfloat,0)
+DEFINE_CALL_BUILDER(Double,jdouble,0)
+
+JNIEXPORTC void JNICALL CallVoidMethodBuilderA(JNIEnv* env,jobject obj,const char* className,const char* name,const char* sig,const jvalue* args) {
+	jclass cls;
+	jboolean local;
+	jmethodID mid = method_cached(env,className,name,sig,JNI_FALSE,&cls,&local);
+	if (local) _DeleteLocalRef(env,cls);
+	if (!mid || !obj) return;
+	_CallVoidMethodA(env,obj,mid,args);
+}
+
+JNIEXPORTC void JNICALL CallVoidMethodBuilderV(JNIEnv* env,jobject obj,const char* className,const char* name,const char* sig,va_list ap) {
+	METHOD_ARGS_BEGIN(sig,ap,);
+	CallVoidMethodBuilderA(env,obj,className,name,sig,args);
+	METHOD_ARGS_END();
+}
+
+JNIEXPORTC void JNICALL CallVoidMethodBuilder(JNIEnv* env,jobject obj,const char* className,const char* name,const char* sig,...) {
+	va_list ap;
+	va_start(ap,sig);
+	CallVoidMethodBuilderV(env,obj,className,name,sig,ap);
+	va_end(ap);
+}
+
+JNIEXPORTC void JNICALL CallStaticVoidMethodBuilderA(JNIEnv* env,const char* className,const char* name,const char* sig,const jvalue* args) {
+	jclass cls;
+	jboolean local;
+	jmethodID mid = method_cached(env,className,name,sig,JNI_TRUE,&cls,&local);
+	if (!mid) return;
+	_CallStaticVoidMethodA(env,cls,mid,args);
+	if (local) _DeleteLocalRef(env,cls);
+}
+
+JNIEXPORTC void JNICALL CallStaticVoidMethodBuilderV(JNIEnv* env,const char* className,const char* name,const char* sig,va_list ap) {
+	METHOD_ARGS_BEGIN(sig,ap,);
+	CallStaticVoidMethodBuilderA(env,className,name,sig,args);
+	METHOD_ARGS_END();
+}
+
+JNIEXPORTC void JNICALL CallStaticVoidMethodBuilder(JNIEnv* env,const char* className,const char* name,const char* sig,...) {
+	va_list ap;
+	va_start(ap,sig);
+	CallStaticVoidMethodBuilderV(env,className,name,sig,ap);
+	va_end(ap);
+}
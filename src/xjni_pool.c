@@ -0,0 +1,229 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <jni.h>
+
+#define LOG_TAG "xjni"
+#include "base-jni.h"
+
+#include <xjni.h>
+#include "xjni_lock.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+struct xjni_pool {
+	JavaVM *vm;
+	int threads;
+	pthread_t *tids;
+	pthread_mutex_t lock;
+	pthread_mutex_t run_lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	unsigned long generation;
+	int stop;
+	int ready;
+	int failed;
+	/* current run, guarded by lock */
+	xjni_pool_task task;
+	void *arg;
+	jsize count;
+	jsize chunk;
+	jsize next;
+	int active;
+	jint status;
+};
+
+static _Atomic size_t parallelThreshold = XJNI_PARALLEL_THRESHOLD;
+
+JNIEXPORTC void JNICALL xjni_SetParallelThreshold(size_t elements) {
+	atomic_store_explicit(&parallelThreshold,elements,memory_order_relaxed);
+}
+
+JNIEXPORTC size_t JNICALL xjni_GetParallelThreshold(void) {
+	return atomic_load_explicit(&parallelThreshold,memory_order_relaxed);
+}
+
+static int pool_cpu_count(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return base_cast(int,info.dwNumberOfProcessors);
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? base_cast(int,n) : 1;
+#endif
+}
+
+/* Take the next chunk of the current run; the pool lock must be held. */
+static int pool_take(xjni_pool_t *pool,jsize *begin,jsize *end) {
+	if (pool->next >= pool->count) return 0;
+	*begin = pool->next;
+	*end = (pool->count - pool->next > pool->chunk) ? pool->next + pool->chunk : pool->count;
+	pool->next = *end;
+	return 1;
+}
+
+/* Process chunks until the run is exhausted; called and returns with the pool lock held. */
+static void pool_drain(xjni_pool_t *pool,JNIEnv *env,jboolean worker) {
+	jsize begin,end;
+	while (pool_take(pool,&begin,&end)) {
+		xjni_pool_task task = pool->task;
+		void *arg = pool->arg;
+		pthread_mutex_unlock(&pool->lock);
+		jint ret = task(env,arg,begin,end);
+		if (worker && _ExceptionCheck(env)) {
+			_ExceptionClear(env);
+			ret = JNI_ERR;
+		}
+		pthread_mutex_lock(&pool->lock);
+		if (ret != JNI_OK) {
+			pool->status = JNI_ERR;
+			pool->next = pool->count;
+		}
+	}
+}
+
+static void pool_worker(xjni_pool_t *pool) {
+	JNIEnv *env = NULL;
+	jint attached = _AttachCurrentThreadAsDaemon(pool->vm,(void**)&env,NULL);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->ready++;
+	if (attached != JNI_OK) {
+		pool->failed++;
+		pthread_cond_broadcast(&pool->done);
+		pthread_mutex_unlock(&pool->lock);
+		return;
+	}
+	pthread_cond_broadcast(&pool->done);
+
+	unsigned long seen = pool->generation;
+	for (;;) {
+		while (!pool->stop && pool->generation == seen)
+			pthread_cond_wait(&pool->wake,&pool->lock);
+		if (pool->stop) break;
+		seen = pool->generation;
+		pool_drain(pool,env,JNI_TRUE);
+		if (--pool->active == 0)
+			pthread_cond_broadcast(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	_DetachCurrentThread(pool->vm);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI pool_thread(LPVOID arg) {
+	pool_worker(ubase_cast(xjni_pool_t*,arg));
+	return 0;
+}
+#else
+static void *pool_thread(void *arg) {
+	pool_worker(ubase_cast(xjni_pool_t*,arg));
+	return NULL;
+}
+#endif
+
+static void pool_join(xjni_pool_t *pool,int started) {
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (int i = 0; i < started; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(pool->tids[i],INFINITE);
+		CloseHandle(pool->tids[i]);
+#else
+		pthread_join(pool->tids[i],NULL);
+#endif
+	}
+	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->done);
+	pthread_mutex_destroy(&pool->run_lock);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->tids);
+	free(pool);
+}
+
+JNIEXPORTC xjni_pool_t* JNICALL xjni_pool_new(JavaVM *vm,int threads) {
+	if (vm == NULL) return NULL;
+	if (threads <= 0) threads = pool_cpu_count() - 1;
+	if (threads < 1) threads = 1;
+
+	xjni_pool_t *pool = ubase_cast(xjni_pool_t*,calloc(1,sizeof(xjni_pool_t)));
+	if (pool == NULL) return NULL;
+	pool->tids = ubase_cast(pthread_t*,calloc(base_cast(size_t,threads),sizeof(pthread_t)));
+	if (pool->tids == NULL) { free(pool); return NULL; }
+	pool->vm = vm;
+	pool->threads = threads;
+	pool->status = JNI_OK;
+	pthread_mutex_init(&pool->lock,NULL);
+	pthread_mutex_init(&pool->run_lock,NULL);
+	pthread_cond_init(&pool->wake,NULL);
+	pthread_cond_init(&pool->done,NULL);
+
+	int started = 0;
+	for (; started < threads; started++) {
+#ifdef _WIN32
+		pool->tids[started] = CreateThread(NULL,0,pool_thread,pool,0,NULL);
+		if (pool->tids[started] == NULL) break;
+#else
+		if (pthread_create(&pool->tids[started],NULL,pool_thread,pool) != 0) break;
+#endif
+	}
+
+	/* Wait until every started worker is attached (or failed to attach). */
+	pthread_mutex_lock(&pool->lock);
+	while (pool->ready < started)
+		pthread_cond_wait(&pool->done,&pool->lock);
+	int failed = pool->failed;
+	pthread_mutex_unlock(&pool->lock);
+
+	if (started < threads || failed > 0) {
+		BASE_LOGE("xjni_pool_new: only %d of %d workers attached",started - failed,threads);
+		pool_join(pool,started);
+		return NULL;
+	}
+	return pool;
+}
+
+JNIEXPORTC void JNICALL xjni_pool_free(xjni_pool_t *pool) {
+	if (pool == NULL) return;
+	pool_join(pool,pool->threads);
+}
+
+JNIEXPORTC int JNICALL xjni_pool_size(const xjni_pool_t *pool) {
+	return pool ? pool->threads : 0;
+}
+
+JNIEXPORTC jint JNICALL xjni_pool_run(xjni_pool_t *pool,JNIEnv *env,jsize count,xjni_pool_task task,void *arg) {
+	if (pool == NULL || env == NULL || task == NULL || count < 0) return JNI_ERR;
+	if (count == 0) return JNI_OK;
+
+	/* Several chunks per thread keep the load balanced when rows differ in cost. */
+	jsize chunk = count / base_cast(jsize,(pool->threads + 1) * 4);
+	if (chunk < 1) chunk = 1;
+
+	pthread_mutex_lock(&pool->run_lock);
+	pthread_mutex_lock(&pool->lock);
+	pool->task = task;
+	pool->arg = arg;
+	pool->count = count;
+	pool->chunk = chunk;
+	pool->next = 0;
+	pool->status = JNI_OK;
+	pool->active = pool->threads;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+
+	pool_drain(pool,env,JNI_FALSE);
+	while (pool->active > 0)
+		pthread_cond_wait(&pool->done,&pool->lock);
+	jint status = pool->status;
+	pool->task = NULL;
+	pool->arg = NULL;
+	pthread_mutex_unlock(&pool->lock);
+	pthread_mutex_unlock(&pool->run_lock);
+	return status;
+}
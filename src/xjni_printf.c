@@ -1,66 +1,30 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <jni.h>
 
 #define LOG_TAG "xjni"
 #include "base-jni.h"
 
 #include <xjni.h>
+#include "xjni_format.h"
+
+/* Compiled program for a jchar format, cached by its address */
+static xjni_fmt_prog_t *printf_compile(const jchar *format) {
+	return xjni_fmt_compile(XJNI_FMT_C,format,jstrlen(format),JNI_TRUE,JNI_TRUE);
+}
 
 JNIEXPORTC int JNICALL vsjprintf(jchar * __s,const jchar * __format,va_list __arg) {
 	if (!__s || !__format)
 		return -1;
 
-	int ret = -1;
-	char *cformat = NULL;
-	char *cbuffer = NULL;
-
-	/* Convert UTF-16 format to UTF-8 */
-	cformat = xjni_tostring(__format);
-	if (!cformat)
+	xjni_fmt_prog_t *prog = printf_compile(__format);
+	if (!prog)
 		return -1;
 
-	/* ---- size query ---- */
-	va_list aq;
-	va_copy(aq,__arg);
-
-#ifdef _MSC_VER
-	int needed = _vscprintf(cformat,aq);
-#else
-	int needed = vsnprintf(NULL,0,cformat,aq);
-#endif
-
-	va_end(aq);
-
-	if (needed < 0)
-		goto cleanup;
-
-	/* +1 for '\0' */
-	cbuffer = (char *)malloc((size_t)needed + 1);
-	if (!cbuffer)
-		goto cleanup;
-
-	/* ---- actual formatting ---- */
-	va_list ac;
-	va_copy(ac,__arg);
-	ret = vsnprintf(cbuffer,(size_t)needed + 1,cformat,ac);
-	va_end(ac);
-
-	if (ret < 0)
-		goto cleanup;
-
-	/* ---- UTF-8 → UTF-16 ---- */
-	size_t outlen = (size_t)ret + 1;
-	if (!xjni_fromstring(cbuffer,__s,&outlen)) {
-		ret = -1;
-		goto cleanup;
-	}
-
-	ret = (int)outlen;
-
-cleanup:
-	free(cbuffer);
-	free(cformat);
+	/* The destination is unbounded, like sprintf */
+	int ret = xjni_fmt_vprint16(__s,(size_t)-1 / sizeof(jchar),prog,__arg);
+	xjni_fmt_release(prog);
 	return ret;
 }
 
@@ -80,47 +44,16 @@ JNIEXPORTC int JNICALL vsnjprintf(jchar * __s,size_t __maxlen,const jchar * __fo
 	if (!__s || !__format || __maxlen <= 0)
 		return -1;
 
-	int ret = -1;
-	char *cformat = NULL;
-	char *cbuffer = NULL;
-
-	/* Convert format string */
-	cformat = xjni_tostring(__format);
-	if (!cformat)
+	xjni_fmt_prog_t *prog = printf_compile(__format);
+	if (!prog)
 		return -1;
 
-	/* Allocate temporary narrow buffer */
-	cbuffer = (char *)malloc(__maxlen);
-	if (!cbuffer)
-		goto cleanup;
-
-	va_list ac;
-	va_copy(ac,__arg);
+	int ret = xjni_fmt_vprint16(__s,__maxlen,prog,__arg);
+	xjni_fmt_release(prog);
 
-#ifdef _MSC_VER
-	ret = _vsnprintf(cbuffer,__maxlen,cformat,ac);
-	if (ret < 0 || (size_t)ret >= __maxlen) {
-		cbuffer[__maxlen - 1] = '\0';
-		ret = -1;
-	}
-#else
-	ret = vsnprintf(cbuffer,__maxlen,cformat,ac);
+	/* Truncated output is kept, terminated, but reported as an error */
 	if (ret < 0 || (size_t)ret >= __maxlen)
 		ret = -1;
-#endif
-
-	va_end(ac);
-
-	if (ret >= 0) {
-		/* Convert result back to UTF-16 */
-		size_t outlen = __maxlen;
-		if (!xjni_fromstring(cbuffer,__s,&outlen))
-			ret = -1;
-	}
-
-cleanup:
-	free(cbuffer);
-	free(cformat);
 	return ret;
 }
 
@@ -134,13 +67,13 @@ JNIEXPORTC int JNICALL snjprintf(jchar * __s,size_t __maxlen,const jchar * __for
 
 JNIEXPORTC int JNICALL vjfprintf(FILE* __stream,const jchar* __format,va_list __arg) {
 	if (!__stream || !__format) return -1;
-	char* cret = xjni_tostring(__format);
-	if (!cret) return -1;
-	va_list ac;
-	va_copy(ac,__arg);
-	int ret = vfprintf(__stream,cret,ac);
-	va_end(ac);
-	free(cret);
+	xjni_fmt_prog_t *prog = printf_compile(__format);
+	if (!prog) return -1;
+	xjni_sink_t sink;
+	xjni_sink_file(&sink,__stream);
+	int ret = xjni_fmt_vprint(&sink,prog,__arg);
+	xjni_sink_finish(&sink);
+	xjni_fmt_release(prog);
 	return ret;
 }
 
@@ -166,25 +99,13 @@ JNIEXPORTC int JNICALL jprintf(const jchar* __format,...) {
 
 JNIEXPORTC int JNICALL vjdprintf(int fd,const jchar* __format,va_list __arg) {
 	if (fd < 0 || !__format) return -1;
-	int ret;
-	char* cret = xjni_tostring(__format);
-	if (!cret) return -1;
-	va_list ac;
-	va_copy(ac,__arg);
-#ifdef _WIN32
-	FILE* fp = fdopen(fd, "w");
-	if (fp) {
-		ret = vfprintf(fp, cret, ac);
-		fflush(fp);
-	} else {
-		XJNI_LOGE("XJNIPrintf","_fdopen failed for fd %d", fd);
-		ret = -1;
-	}
-#else
-	ret = vdprintf(fd,cret,ac);
-#endif
-	va_end(ac);
-	free(cret);
+	xjni_fmt_prog_t *prog = printf_compile(__format);
+	if (!prog) return -1;
+	xjni_sink_t sink;
+	xjni_sink_fd(&sink,fd);
+	int ret = xjni_fmt_vprint(&sink,prog,__arg);
+	xjni_sink_finish(&sink);
+	xjni_fmt_release(prog);
 	return ret;
 }
 
@@ -195,3 +116,89 @@ JNIEXPORTC int JNICALL jdprintf(int __fd,const jchar* __format,...) {
 	va_end(ac);
 	return ret;
 }
+
+/* ---- Java strings ---- */
+
+/* Per-thread UTF-16 scratch for the jstring formatters, in jchar units */
+#ifndef XJNI_FORMAT_SCRATCH
+#define XJNI_FORMAT_SCRATCH 1024
+#endif
+
+static XJNI_THREAD_LOCAL jchar gScratch[XJNI_FORMAT_SCRATCH];
+static jmethodID gAppendMid = NULL;
+
+/*
+ * Format a UTF-8 format into the thread's scratch, or into a heap buffer
+ * (*heap, to free) when the output is longer. Returns the units or -1.
+ */
+static jint format_utf16(const char *format,va_list arg,jchar **out,jchar **heap) {
+	*heap = NULL;
+	xjni_fmt_prog_t *prog = xjni_fmt_compile(XJNI_FMT_C,format,strlen(format),JNI_FALSE,JNI_TRUE);
+	if (!prog)
+		return -1;
+
+	*out = gScratch;
+	int ret = xjni_fmt_vprint16(gScratch,XJNI_FORMAT_SCRATCH,prog,arg);
+	if (ret >= XJNI_FORMAT_SCRATCH) {
+		*heap = (jchar *)malloc(((size_t)ret + 1) * sizeof(jchar));
+		if (*heap) {
+			*out = *heap;
+			ret = xjni_fmt_vprint16(*heap,(size_t)ret + 1,prog,arg);
+		} else {
+			ret = -1;
+		}
+	}
+	xjni_fmt_release(prog);
+	return ret;
+}
+
+JNIEXPORTC jstring JNICALL xjni_FormatToJStringV(JNIEnv* env,const char* format,va_list arg) {
+	if (!env || !format) return NULL;
+	jchar *out, *heap;
+	jint len = format_utf16(format,arg,&out,&heap);
+	jstring str = len < 0 ? NULL : _NewString(env,out,len);
+	free(heap);
+	return str;
+}
+
+JNIEXPORTC jstring JNICALL xjni_FormatToJString(JNIEnv* env,const char* format,...) {
+	va_list ac;
+	va_start(ac,format);
+	jstring ret = xjni_FormatToJStringV(env,format,ac);
+	va_end(ac);
+	return ret;
+}
+
+JNIEXPORTC jint JNICALL xjni_FormatAppendV(JNIEnv* env,jobject sb,const char* format,va_list arg) {
+	if (!env || !sb || !format) return -1;
+	if (!gAppendMid) {
+		jclass cls = _FindClass(env,"java/lang/StringBuilder");
+		if (!cls) return -1;
+		gAppendMid = _GetMethodID(env,cls,"append","([CII)Ljava/lang/StringBuilder;");
+		_DeleteLocalRef(env,cls);
+		if (!gAppendMid) return -1;
+	}
+
+	jchar *out, *heap;
+	jint len = format_utf16(format,arg,&out,&heap);
+	jcharArray chars = len < 0 ? NULL : _NewCharArray(env,len);
+	if (chars) {
+		_SetCharArrayRegion(env,chars,0,len,out);
+		jobject self = _CallObjectMethod(env,sb,gAppendMid,chars,0,len);
+		if (self) _DeleteLocalRef(env,self);
+		_DeleteLocalRef(env,chars);
+		if (_ExceptionCheck(env)) len = -1;
+	} else {
+		len = -1;
+	}
+	free(heap);
+	return len;
+}
+
+JNIEXPORTC jint JNICALL xjni_FormatAppend(JNIEnv* env,jobject sb,const char* format,...) {
+	va_list ac;
+	va_start(ac,format);
+	jint ret = xjni_FormatAppendV(env,sb,format,ac);
+	va_end(ac);
+	return ret;
+}
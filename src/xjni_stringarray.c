@@ -1,10 +1,117 @@
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
 #include <jni.h>
 
 #define LOG_TAG "xjni"
 #include "base-jni.h"
 
 #include <xjni.h>
+#include "xjni_frame.h"
+#include "xjni_lock.h"
+
+static jclass stringCls = NULL;
+static jclass stringArrayCls = NULL;
+static pthread_mutex_t stringClsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Resolve @p name once into a global reference kept in @p cache. */
+static jclass cached_class(JNIEnv *env,const char *name,jclass *cache) {
+	if (*cache != NULL) return *cache;
+	pthread_mutex_lock(&stringClsMutex);
+	if (*cache == NULL) {
+		jclass local = _FindClass(env,name);
+		if (local != NULL) {
+			*cache = ubase_cast(jclass,_NewGlobalRef(env,local));
+			_DeleteLocalRef(env,local);
+		}
+	}
+	pthread_mutex_unlock(&stringClsMutex);
+	return *cache;
+}
+
+static jclass stringsHelperCls = NULL;
+static jmethodID splitMid = NULL;
+static jmethodID splitLatin1Mid = NULL;
+static jmethodID concatMid = NULL;
+/* Stored with release ordering once the fields above are set, so a lock-free reader that sees it sees them. */
+static _Atomic jboolean stringsHelperResolved = JNI_FALSE;
+static _Atomic jsize packedThreshold = XJNI_STRINGS_PACKED_THRESHOLD;
+
+/*
+ * Resolve the optional xjni.XJNIStrings runtime class once. A missing class
+ * is remembered so later calls go straight to the per-element path.
+ */
+static jboolean strings_helper(JNIEnv *env) {
+	if (atomic_load_explicit(&stringsHelperResolved,memory_order_acquire))
+		return stringsHelperCls != NULL ? JNI_TRUE : JNI_FALSE;
+	pthread_mutex_lock(&stringClsMutex);
+	if (!atomic_load_explicit(&stringsHelperResolved,memory_order_relaxed)) {
+		jclass local = _FindClass(env,"xjni/XJNIStrings");
+		if (local != NULL) {
+			jmethodID split = _GetStaticMethodID(env,local,"split","([C[I[Z)[Ljava/lang/String;");
+			jmethodID splitLatin1 = split ? _GetStaticMethodID(env,local,"splitLatin1","([B[I[Z)[Ljava/lang/String;") : NULL;
+			jmethodID concat = splitLatin1 ? _GetStaticMethodID(env,local,"concat","([Ljava/lang/String;[I)[C") : NULL;
+			if (concat != NULL) {
+				splitMid = split;
+				splitLatin1Mid = splitLatin1;
+				concatMid = concat;
+				stringsHelperCls = ubase_cast(jclass,_NewGlobalRef(env,local));
+			}
+			_DeleteLocalRef(env,local);
+		}
+		if (_ExceptionCheck(env)) _ExceptionClear(env);
+		atomic_store_explicit(&stringsHelperResolved,JNI_TRUE,memory_order_release);
+	}
+	pthread_mutex_unlock(&stringClsMutex);
+	return stringsHelperCls != NULL ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORTC void JNICALL xjni_SetStringArrayPackedThreshold(jsize count) {
+	atomic_store_explicit(&packedThreshold,count < 0 ? 0 : count,memory_order_relaxed);
+}
+
+JNIEXPORTC jsize JNICALL xjni_GetStringArrayPackedThreshold(void) {
+	return atomic_load_explicit(&packedThreshold,memory_order_relaxed);
+}
+
+JNIEXPORTC jclass JNICALL xjni_GetStringClass(JNIEnv *env) {
+	return cached_class(env,"java/lang/String",&stringCls);
+}
+
+JNIEXPORTC jclass JNICALL xjni_GetStringArrayClass(JNIEnv *env) {
+	return cached_class(env,"[Ljava/lang/String;",&stringArrayCls);
+}
+
+JNIEXPORTC jint JNICALL XJNI_StringArray_OnLoad(JavaVM* vm,void* reserved,jint ver) {
+	JNIEnv* env = NULL;
+	(void)reserved;
+	if (_GetEnv(vm,(void**)&env,ver) != JNI_OK)
+		return JNI_ERR;
+	if (xjni_GetStringClass(env) == NULL || xjni_GetStringArrayClass(env) == NULL) {
+		_ExceptionClear(env);
+		return JNI_ERR;
+	}
+	/* Resolved here, with the library's class loader; absence is not an error. */
+	strings_helper(env);
+	return ver;
+}
+
+JNIEXPORTC void JNICALL XJNI_StringArray_OnUnload(JavaVM* vm,void* reserved,jint ver) {
+	JNIEnv* env = NULL;
+	(void)reserved;
+	if (_GetEnv(vm,(void**)&env,ver) != JNI_OK)
+		return;
+	pthread_mutex_lock(&stringClsMutex);
+	if (stringCls) { _DeleteGlobalRef(env,stringCls); stringCls = NULL; }
+	if (stringArrayCls) { _DeleteGlobalRef(env,stringArrayCls); stringArrayCls = NULL; }
+	if (stringsHelperCls) { _DeleteGlobalRef(env,stringsHelperCls); stringsHelperCls = NULL; }
+	splitMid = NULL;
+	splitLatin1Mid = NULL;
+	concatMid = NULL;
+	atomic_store_explicit(&stringsHelperResolved,JNI_FALSE,memory_order_relaxed);
+	pthread_mutex_unlock(&stringClsMutex);
+}
 
 JNIEXPORTC jsize JNICALL GetStringUTFArrayLength(JNIEnv *env,jobjectArray array) {
 	if (array == NULL) return 0;
@@ -15,21 +122,35 @@ JNIEXPORTC jobjectArray JNICALL NewStringUTFArray(JNIEnv *env,const char **utf,j
 	if (utf == NULL)
 		return NULL;
 
-	jclass strclass = _FindClass(env,"java/lang/String");
+	jclass strclass = xjni_GetStringClass(env);
+	if (strclass == NULL)
+		return NULL;
 	jobjectArray stringArray = _NewObjectArray(env,count,strclass,NULL);
-	_DeleteGlobalRef(env,strclass);
 	if (stringArray == NULL)
 		return NULL;
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,count,1) != JNI_OK) {
+		_DeleteLocalRef(env,stringArray);
+		return NULL;
+	}
 	for (jsize i = 0; i < count; i++) {
-		jstring jstr = NULL;
-		jstr = _NewStringUTF(env,utf[i]);
+		if (xjni_frame_next(&frame) != JNI_OK) {
+			_DeleteLocalRef(env,stringArray);
+			return NULL;
+		}
+		if (utf[i] == NULL) continue;
+		jstring jstr = _NewStringUTF(env,utf[i]);
 		if (jstr == NULL) {
 			BASE_LOGE("Failed to create jstring from UTF-8 string: %s\n",utf[i]);
+			xjni_frame_leave(&frame,NULL);
+			_DeleteLocalRef(env,stringArray);
 			return NULL;
 		}
 		_SetObjectArrayElement(env,stringArray,i,jstr);
+		_DeleteLocalRef(env,jstr);
 	}
+	xjni_frame_leave(&frame,NULL);
 
 	return stringArray;
 }
@@ -44,10 +165,18 @@ JNIEXPORTC const char** JNICALL GetStringUTFArrayChars(JNIEnv *env,jobjectArray
 		return NULL;
 	}
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,arrayLength,1) != JNI_OK) {
+		free((void*)strArray);
+		return NULL;
+	}
 	for (jsize i = 0; i < arrayLength; i++) {
+		xjni_frame_next(&frame);
 		jstring str = ubase_cast(jstring,_GetObjectArrayElement(env,array,i));
-		strArray[i] = _GetStringUTFChars(env,str,isCopy);
+		strArray[i] = str ? _GetStringUTFChars(env,str,isCopy) : NULL;
+		if (str) _DeleteLocalRef(env,str);
 	}
+	xjni_frame_leave(&frame,NULL);
 
 	return strArray;
 }
@@ -56,10 +185,17 @@ JNIEXPORTC void JNICALL ReleaseStringUTFArrayChars(JNIEnv *env,jobjectArray arra
 	if (array == NULL) return;
 	jsize arrayLength = _GetArrayLength(env,array);
 
+	xjni_frame_t frame;
+	xjni_frame_enter(&frame,env,arrayLength,1);
 	for (jsize i = 0; i < arrayLength; i++) {
+		xjni_frame_next(&frame);
+		if (elements[i] == NULL) continue;
 		jstring str = ubase_cast(jstring,_GetObjectArrayElement(env,array,i));
+		if (str == NULL) continue;
 		_ReleaseStringUTFChars(env,str,elements[i]);
+		_DeleteLocalRef(env,str);
 	}
+	xjni_frame_leave(&frame,NULL);
 
 	free((void*)elements);
 }
@@ -73,14 +209,19 @@ JNIEXPORTC void JNICALL GetStringUTFArrayRegion(JNIEnv *env,jobjectArray str,jsi
 	if (start >= arrayLength || start + len > arrayLength)
 		return;
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; i++) {
+		xjni_frame_next(&frame);
 		jstring jstr = ubase_cast(jstring,_GetObjectArrayElement(env,str,start + i));
 		if (jstr != NULL) {
 			buf[i] = ubase_cast(char*,_GetStringUTFChars(env,jstr,NULL));
+			_DeleteLocalRef(env,jstr);
 		} else {
 			buf[i] = NULL;
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 }
 
 JNIEXPORTC void JNICALL SetStringUTFArrayRegion(JNIEnv *env,jobjectArray array,jsize start,jsize len,const char **buf) {
@@ -92,42 +233,556 @@ JNIEXPORTC void JNICALL SetStringUTFArrayRegion(JNIEnv *env,jobjectArray array,j
 	if (start >= arrayLength || start + len > arrayLength)
 		return;
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; i++) {
+		if (xjni_frame_next(&frame) != JNI_OK) return;
 		jstring jstr = NULL;
 		if (buf[i] != NULL) {
 			jstr = _NewStringUTF(env,buf[i]);
 			if (jstr == NULL) {
 				BASE_LOGE("Failed to create jstring from UTF-8 string: %s\n",buf[i]);
-				return;
+				break;
 			}
 		}
 		_SetObjectArrayElement(env,array,start + i,jstr);
+		if (jstr) _DeleteLocalRef(env,jstr);
+	}
+	xjni_frame_leave(&frame,NULL);
+}
+
+/* Encode @p n UTF-16 units as standard UTF-8; unpaired surrogates become U+FFFD. Writes at most 3 bytes per unit. */
+static size_t utf16_to_utf8(const jchar *src,jsize n,char *dst) {
+	unsigned char *p = ubase_cast(unsigned char*,dst);
+	for (jsize i = 0; i < n; i++) {
+		uint32_t c = src[i];
+		if (c < 0x80) {
+			*p++ = base_cast(unsigned char,c);
+			continue;
+		}
+		if (c >= 0xD800 && c <= 0xDFFF) {
+			if (c <= 0xDBFF && i + 1 < n && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF) {
+				c = 0x10000 + (((c - 0xD800) << 10) | (src[++i] - 0xDC00u));
+				*p++ = base_cast(unsigned char,0xF0 | (c >> 18));
+				*p++ = base_cast(unsigned char,0x80 | ((c >> 12) & 0x3F));
+				*p++ = base_cast(unsigned char,0x80 | ((c >> 6) & 0x3F));
+				*p++ = base_cast(unsigned char,0x80 | (c & 0x3F));
+				continue;
+			}
+			c = 0xFFFD;
+		}
+		if (c < 0x800) {
+			*p++ = base_cast(unsigned char,0xC0 | (c >> 6));
+			*p++ = base_cast(unsigned char,0x80 | (c & 0x3F));
+		} else {
+			*p++ = base_cast(unsigned char,0xE0 | (c >> 12));
+			*p++ = base_cast(unsigned char,0x80 | ((c >> 6) & 0x3F));
+			*p++ = base_cast(unsigned char,0x80 | (c & 0x3F));
+		}
+	}
+	return base_cast(size_t,p - ubase_cast(unsigned char*,dst));
+}
+
+/*
+ * Block layout: header | offsets[count] | lengths[count] | nulls[count] | data.
+ * The tables are ordered by decreasing alignment so no padding is needed. The
+ * block is grown with realloc while filling, so the table pointers are only
+ * set once it has its final address.
+ */
+JNIEXPORTC jutf8packed_t* JNICALL GetStringUTF8ArrayPacked(JNIEnv *env,jobjectArray array) {
+	if (array == NULL) return NULL;
+	jsize count = _GetArrayLength(env,array);
+
+	size_t head = sizeof(jutf8packed_t) + base_cast(size_t,count) * (sizeof(size_t) + sizeof(jsize) + sizeof(jboolean));
+	size_t capacity = base_cast(size_t,count) * 16 + 64;
+	size_t used = 0;
+	char *block = ubase_cast(char*,malloc(head + capacity));
+	if (block == NULL) {
+		BASE_LOGE("Memory allocation failed for packed string array\n");
+		return NULL;
+	}
+
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,count,1) != JNI_OK) {
+		free(block);
+		return NULL;
+	}
+	for (jsize i = 0; i < count; i++) {
+		xjni_frame_next(&frame);
+		jstring str = ubase_cast(jstring,_GetObjectArrayElement(env,array,i));
+		jsize units = str ? _GetStringLength(env,str) : 0;
+
+		size_t need = base_cast(size_t,units) * 3 + 1;
+		if (capacity - used < need) {
+			size_t grown = capacity * 2;
+			if (grown - used < need) grown = used + need;
+			char *moved = ubase_cast(char*,realloc(block,head + grown));
+			if (moved == NULL) {
+				BASE_LOGE("Memory allocation failed for packed string array\n");
+				if (str) _DeleteLocalRef(env,str);
+				xjni_frame_leave(&frame,NULL);
+				free(block);
+				return NULL;
+			}
+			block = moved;
+			capacity = grown;
+		}
+		size_t *offsets = ubase_cast(size_t*,block + sizeof(jutf8packed_t));
+		jsize *lengths = ubase_cast(jsize*,offsets + count);
+		jboolean *nulls = ubase_cast(jboolean*,lengths + count);
+
+		char *dst = block + head + used;
+		size_t written = 0;
+		if (units > 0) {
+			const jchar *chars = _GetStringCritical(env,str,NULL);
+			if (chars == NULL) {
+				_DeleteLocalRef(env,str);
+				xjni_frame_leave(&frame,NULL);
+				free(block);
+				return NULL;
+			}
+			written = utf16_to_utf8(chars,units,dst);
+			_ReleaseStringCritical(env,str,chars);
+		}
+		dst[written] = '\0';
+		offsets[i] = used;
+		lengths[i] = base_cast(jsize,written);
+		nulls[i] = str ? JNI_FALSE : JNI_TRUE;
+		used += written + 1;
+		if (str) _DeleteLocalRef(env,str);
 	}
+	xjni_frame_leave(&frame,NULL);
+
+	char *fitted = ubase_cast(char*,realloc(block,head + used));
+	if (fitted != NULL) block = fitted;
+
+	jutf8packed_t *packed = ubase_cast(jutf8packed_t*,block);
+	packed->count = count;
+	packed->size = used;
+	packed->offsets = ubase_cast(const size_t*,block + sizeof(jutf8packed_t));
+	packed->lengths = ubase_cast(const jsize*,packed->offsets + count);
+	packed->nulls = ubase_cast(const jboolean*,packed->lengths + count);
+	packed->data = block + head;
+	return packed;
+}
+
+JNIEXPORTC void JNICALL ReleaseStringUTF8ArrayPacked(jutf8packed_t *packed) {
+	free(packed);
 }
 
 JNIEXPORTC jobjectArray JNICALL NewStringArray(JNIEnv *env,const jchar **unicode,jsize len,jsize n) {
 	if (unicode == NULL || len < 0)
 		return NULL;
 
-	jclass strclass = _FindClass(env,"java/lang/String");
+	jclass strclass = xjni_GetStringClass(env);
+	if (strclass == NULL)
+		return NULL;
 	jobjectArray stringArray = _NewObjectArray(env,n,strclass,NULL);
-	_DeleteGlobalRef(env,strclass);
 	if (stringArray == NULL)
 		return NULL;
 
-
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,n,1) != JNI_OK) {
+		_DeleteLocalRef(env,stringArray);
+		return NULL;
+	}
 	for (jsize i = 0; i < n; i++) {
+		if (xjni_frame_next(&frame) != JNI_OK) {
+			_DeleteLocalRef(env,stringArray);
+			return NULL;
+		}
+		if (unicode[i] == NULL) continue;
 		jstring jstr = _NewString(env,unicode[i],len);
 		if (jstr == NULL) {
 			BASE_LOGE("Failed to create jstring from jchar array at index %d",i);
+			xjni_frame_leave(&frame,NULL);
+			_DeleteLocalRef(env,stringArray);
+			return NULL;
+		}
+		_SetObjectArrayElement(env,stringArray,i,jstr);
+		_DeleteLocalRef(env,jstr);
+	}
+	xjni_frame_leave(&frame,NULL);
+
+	return stringArray;
+}
+
+/*
+ * Decode @p n bytes of standard UTF-8 into UTF-16; malformed sequences,
+ * overlong forms and encoded surrogates become U+FFFD. Writes at most one
+ * unit per input byte.
+ */
+static jsize utf8_to_utf16(const char *src,size_t n,jchar *dst) {
+	const unsigned char *s = ubase_cast(const unsigned char*,src);
+	const unsigned char *end = s + n;
+	jchar *p = dst;
+	while (s < end) {
+		uint32_t c = *s;
+		if (c < 0x80) {
+			*p++ = base_cast(jchar,c);
+			s++;
+			continue;
+		}
+		size_t k = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+		size_t i = 1;
+		if (k != 0) {
+			c &= 0x7F >> k;
+			for (; i < k && s + i < end && (s[i] & 0xC0) == 0x80; i++)
+				c = (c << 6) | (s[i] & 0x3F);
+		}
+		if (k == 0 || i < k ||
+			c < (k == 2 ? 0x80u : k == 3 ? 0x800u : 0x10000u) ||
+			c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+			*p++ = 0xFFFD;
+			s += i;
+			continue;
+		}
+		s += k;
+		if (c >= 0x10000) {
+			c -= 0x10000;
+			*p++ = base_cast(jchar,0xD800 | (c >> 10));
+			*p++ = base_cast(jchar,0xDC00 | (c & 0x3FF));
+		} else {
+			*p++ = base_cast(jchar,c);
+		}
+	}
+	return base_cast(jsize,p - dst);
+}
+
+/* Byte range of packed element @p i: explicit lengths, or consecutive offsets. */
+#define PACKED_LENGTH(offsets,lengths,i) \
+	((lengths) ? base_cast(size_t,(lengths)[i]) : (offsets)[(i) + 1] - (offsets)[i])
+
+/* Widen @p n Latin-1 bytes to UTF-16. */
+static jsize latin1_to_utf16(const char *src,size_t n,jchar *dst) {
+	const unsigned char *s = ubase_cast(const unsigned char*,src);
+	for (size_t i = 0; i < n; i++)
+		dst[i] = s[i];
+	return base_cast(jsize,n);
+}
+
+/* Per-element construction from packed 8-bit data, decoded by @p decode into one scratch buffer. */
+static jobjectArray new_packed_decoded(JNIEnv *env,const char *data,const size_t *offsets,const jsize *lengths,jsize count,const jboolean *nulls,jsize (*decode)(const char*,size_t,jchar*)) {
+	if (count < 0 || (count > 0 && (data == NULL || offsets == NULL)))
+		return NULL;
+
+	jclass strclass = xjni_GetStringClass(env);
+	if (strclass == NULL)
+		return NULL;
+
+	size_t longest = 0;
+	for (jsize i = 0; i < count; i++) {
+		size_t n = PACKED_LENGTH(offsets,lengths,i);
+		if (n > longest) longest = n;
+	}
+	if (longest > base_cast(size_t,INT32_MAX)) {
+		BASE_LOGE("Packed string element too long: %zu bytes\n",longest);
+		return NULL;
+	}
+	/* Neither decoder produces more UTF-16 units than it reads bytes. */
+	jchar stack[256];
+	jchar *scratch = longest <= sizeof(stack) / sizeof(stack[0]) ? stack
+		: ubase_cast(jchar*,malloc(longest * sizeof(jchar)));
+	if (scratch == NULL) {
+		BASE_LOGE("Memory allocation failed for UTF-16 scratch buffer\n");
+		return NULL;
+	}
+
+	jobjectArray stringArray = _NewObjectArray(env,count,strclass,NULL);
+	xjni_frame_t frame;
+	if (stringArray == NULL || xjni_frame_enter(&frame,env,count,1) != JNI_OK) {
+		if (stringArray) _DeleteLocalRef(env,stringArray);
+		if (scratch != stack) free(scratch);
+		return NULL;
+	}
+	for (jsize i = 0; i < count; i++) {
+		if (xjni_frame_next(&frame) != JNI_OK) {
+			_DeleteLocalRef(env,stringArray);
+			stringArray = NULL;
+			break;
+		}
+		if (nulls && nulls[i]) continue;
+		size_t n = PACKED_LENGTH(offsets,lengths,i);
+		jsize units = decode(data + offsets[i],n,scratch);
+		jstring jstr = _NewString(env,scratch,units);
+		if (jstr == NULL) {
+			BASE_LOGE("Failed to create jstring from packed element %d\n",i);
+			xjni_frame_leave(&frame,NULL);
+			_DeleteLocalRef(env,stringArray);
+			stringArray = NULL;
+			break;
+		}
+		_SetObjectArrayElement(env,stringArray,i,jstr);
+		_DeleteLocalRef(env,jstr);
+	}
+	if (stringArray != NULL)
+		xjni_frame_leave(&frame,NULL);
+
+	if (scratch != stack) free(scratch);
+	return stringArray;
+}
+
+JNIEXPORTC jobjectArray JNICALL NewStringUTF8ArrayPacked(JNIEnv *env,const char *data,const size_t *offsets,const jsize *lengths,jsize count,const jboolean *nulls) {
+	return new_packed_decoded(env,data,offsets,lengths,count,nulls,utf8_to_utf16);
+}
+
+JNIEXPORTC jobjectArray JNICALL NewStringArrayPacked(JNIEnv *env,const jchar *data,const size_t *offsets,const jsize *lengths,jsize count,const jboolean *nulls) {
+	if (count < 0 || (count > 0 && (data == NULL || offsets == NULL)))
+		return NULL;
+
+	jclass strclass = xjni_GetStringClass(env);
+	if (strclass == NULL)
+		return NULL;
+	jobjectArray stringArray = _NewObjectArray(env,count,strclass,NULL);
+	if (stringArray == NULL)
+		return NULL;
+
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,count,1) != JNI_OK) {
+		_DeleteLocalRef(env,stringArray);
+		return NULL;
+	}
+	for (jsize i = 0; i < count; i++) {
+		if (xjni_frame_next(&frame) != JNI_OK) {
+			_DeleteLocalRef(env,stringArray);
+			return NULL;
+		}
+		if (nulls && nulls[i]) continue;
+		jstring jstr = _NewString(env,data + offsets[i],base_cast(jsize,PACKED_LENGTH(offsets,lengths,i)));
+		if (jstr == NULL) {
+			BASE_LOGE("Failed to create jstring from packed UTF-16 element %d\n",i);
+			xjni_frame_leave(&frame,NULL);
+			_DeleteLocalRef(env,stringArray);
 			return NULL;
 		}
 		_SetObjectArrayElement(env,stringArray,i,jstr);
+		_DeleteLocalRef(env,jstr);
 	}
+	xjni_frame_leave(&frame,NULL);
 
 	return stringArray;
 }
 
+/* Total element length of a packed layout, in elements of the data array. */
+static size_t packed_total(const size_t *offsets,const jsize *lengths,jsize count) {
+	if (count == 0) return 0;
+	if (lengths == NULL) return offsets[count] - offsets[0];
+	size_t total = 0;
+	for (jsize i = 0; i < count; i++)
+		total += base_cast(size_t,lengths[i]);
+	return total;
+}
+
+/*
+ * Copy every packed element of @p esize bytes into one char[] or byte[],
+ * build the matching int[] offsets and make a single call to @p mid.
+ */
+static jobjectArray new_packed_upcall(JNIEnv *env,jmethodID mid,const char *data,size_t esize,const size_t *offsets,const jsize *lengths,jsize count,const jboolean *nulls,size_t total) {
+	jobjectArray result = NULL;
+	jarray chars = esize == sizeof(jchar) ? ubase_cast(jarray,_NewCharArray(env,base_cast(jsize,total)))
+		: ubase_cast(jarray,_NewByteArray(env,base_cast(jsize,total)));
+	jintArray offs = chars ? _NewIntArray(env,count + 1) : NULL;
+	jbooleanArray flags = (offs && nulls) ? _NewBooleanArray(env,count) : NULL;
+	if (offs == NULL || (nulls && flags == NULL))
+		goto done;
+
+	if (total > 0 && lengths == NULL) {
+		/* Contiguous layout: a single region copy. */
+		if (esize == sizeof(jchar))
+			_SetCharArrayRegion(env,chars,0,base_cast(jsize,total),ubase_cast(const jchar*,data + offsets[0] * esize));
+		else
+			_SetByteArrayRegion(env,chars,0,base_cast(jsize,total),ubase_cast(const jbyte*,data + offsets[0] * esize));
+	} else if (total > 0) {
+		char *dst = ubase_cast(char*,_GetPrimitiveArrayCritical(env,chars,NULL));
+		if (dst == NULL) goto done;
+		for (jsize i = 0; i < count; i++) {
+			size_t n = base_cast(size_t,lengths[i]) * esize;
+			memcpy(dst,data + offsets[i] * esize,n);
+			dst += n;
+		}
+		_ReleasePrimitiveArrayCritical(env,chars,dst - total * esize,0);
+	}
+
+	jint *pos = ubase_cast(jint*,_GetPrimitiveArrayCritical(env,offs,NULL));
+	if (pos == NULL) goto done;
+	pos[0] = 0;
+	for (jsize i = 0; i < count; i++)
+		pos[i + 1] = pos[i] + base_cast(jint,PACKED_LENGTH(offsets,lengths,i));
+	_ReleasePrimitiveArrayCritical(env,offs,pos,0);
+
+	if (flags != NULL)
+		_SetBooleanArrayRegion(env,flags,0,count,nulls);
+
+	result = ubase_cast(jobjectArray,_CallStaticObjectMethod(env,stringsHelperCls,mid,chars,offs,flags));
+done:
+	if (flags) _DeleteLocalRef(env,flags);
+	if (offs) _DeleteLocalRef(env,offs);
+	if (chars) _DeleteLocalRef(env,chars);
+	return result;
+}
+
+JNIEXPORTC jobjectArray JNICALL xjni_NewStringArrayPacked(JNIEnv *env,const jchar *data,const size_t *offsets,const jsize *lengths,jsize count,const jboolean *nulls) {
+	if (count < 0 || (count > 0 && (data == NULL || offsets == NULL)))
+		return NULL;
+	size_t total;
+	if (count < xjni_GetStringArrayPackedThreshold() || !strings_helper(env) ||
+		(total = packed_total(offsets,lengths,count)) > base_cast(size_t,INT32_MAX))
+		return NewStringArrayPacked(env,data,offsets,lengths,count,nulls);
+	return new_packed_upcall(env,splitMid,ubase_cast(const char*,data),sizeof(jchar),offsets,lengths,count,nulls,total);
+}
+
+JNIEXPORTC jobjectArray JNICALL xjni_NewStringLatin1ArrayPacked(JNIEnv *env,const char *data,const size_t *offsets,const jsize *lengths,jsize count,const jboolean *nulls) {
+	if (count < 0 || (count > 0 && (data == NULL || offsets == NULL)))
+		return NULL;
+	size_t total;
+	if (count < xjni_GetStringArrayPackedThreshold() || !strings_helper(env) ||
+		(total = packed_total(offsets,lengths,count)) > base_cast(size_t,INT32_MAX))
+		return new_packed_decoded(env,data,offsets,lengths,count,nulls,latin1_to_utf16);
+	return new_packed_upcall(env,splitLatin1Mid,data,1,offsets,lengths,count,nulls,total);
+}
+
+/* Per-element export into one native block; span pointers are set once the block stops moving. */
+static jstringspans_t* get_spans_elements(JNIEnv *env,jobjectArray array,jsize count) {
+	size_t head = sizeof(jstringspans_t) + base_cast(size_t,count) * sizeof(jspan_t);
+	size_t capacity = base_cast(size_t,count) * 8 + 32;
+	size_t used = 0;
+	char *block = ubase_cast(char*,malloc(head + capacity * sizeof(jchar)));
+	if (block == NULL) {
+		BASE_LOGE("Memory allocation failed for string spans\n");
+		return NULL;
+	}
+
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,count,1) != JNI_OK) {
+		free(block);
+		return NULL;
+	}
+	for (jsize i = 0; i < count; i++) {
+		xjni_frame_next(&frame);
+		jspan_t *spans = ubase_cast(jspan_t*,block + sizeof(jstringspans_t));
+		jstring str = ubase_cast(jstring,_GetObjectArrayElement(env,array,i));
+		if (str == NULL) {
+			spans[i].data = NULL;
+			spans[i].length = -1;
+			continue;
+		}
+		jsize len = _GetStringLength(env,str);
+		if (capacity - used < base_cast(size_t,len)) {
+			size_t grown = capacity * 2;
+			if (grown - used < base_cast(size_t,len)) grown = used + base_cast(size_t,len);
+			char *moved = ubase_cast(char*,realloc(block,head + grown * sizeof(jchar)));
+			if (moved == NULL) {
+				BASE_LOGE("Memory allocation failed for string spans\n");
+				_DeleteLocalRef(env,str);
+				xjni_frame_leave(&frame,NULL);
+				free(block);
+				return NULL;
+			}
+			block = moved;
+			capacity = grown;
+			spans = ubase_cast(jspan_t*,block + sizeof(jstringspans_t));
+		}
+		_GetStringRegion(env,str,0,len,ubase_cast(jchar*,block + head) + used);
+		_DeleteLocalRef(env,str);
+		spans[i].length = len;
+		used += base_cast(size_t,len);
+	}
+	xjni_frame_leave(&frame,NULL);
+
+	jstringspans_t *result = ubase_cast(jstringspans_t*,block);
+	jspan_t *spans = ubase_cast(jspan_t*,block + sizeof(jstringspans_t));
+	const jchar *data = ubase_cast(const jchar*,block + head);
+	for (jsize i = 0; i < count; i++) {
+		if (spans[i].length < 0) {
+			spans[i].length = 0;
+		} else {
+			spans[i].data = data;
+			data += spans[i].length;
+		}
+	}
+	result->count = count;
+	result->spans = spans;
+	result->array = NULL;
+	result->pinned = NULL;
+	return result;
+}
+
+/* One XJNIStrings.concat upcall; the char[] stays pinned until xjni_ReleaseStringArrayPacked. */
+static jstringspans_t* get_spans_upcall(JNIEnv *env,jobjectArray array,jsize count,jboolean *fallback) {
+	*fallback = JNI_FALSE;
+	jstringspans_t *result = ubase_cast(jstringspans_t*,malloc(sizeof(jstringspans_t) + base_cast(size_t,count) * sizeof(jspan_t)));
+	if (result == NULL) {
+		BASE_LOGE("Memory allocation failed for string spans\n");
+		return NULL;
+	}
+	jspan_t *spans = ubase_cast(jspan_t*,result + 1);
+
+	jintArray lengths = _NewIntArray(env,count);
+	jcharArray chars = lengths ? ubase_cast(jcharArray,_CallStaticObjectMethod(env,stringsHelperCls,concatMid,array,lengths)) : NULL;
+	if (chars == NULL) {
+		/* A null result without exception means the total does not fit in a char[]. */
+		*fallback = (lengths && !_ExceptionCheck(env)) ? JNI_TRUE : JNI_FALSE;
+		if (lengths) _DeleteLocalRef(env,lengths);
+		free(result);
+		return NULL;
+	}
+
+	const jint *lens = ubase_cast(const jint*,_GetPrimitiveArrayCritical(env,lengths,NULL));
+	if (lens == NULL) {
+		_DeleteLocalRef(env,chars);
+		_DeleteLocalRef(env,lengths);
+		free(result);
+		return NULL;
+	}
+	for (jsize i = 0; i < count; i++)
+		spans[i].length = lens[i];
+	_ReleasePrimitiveArrayCritical(env,lengths,ubase_cast(void*,lens),JNI_ABORT);
+	_DeleteLocalRef(env,lengths);
+
+	jchar *pinned = ubase_cast(jchar*,_GetPrimitiveArrayCritical(env,chars,NULL));
+	if (pinned == NULL) {
+		_DeleteLocalRef(env,chars);
+		free(result);
+		return NULL;
+	}
+	const jchar *data = pinned;
+	for (jsize i = 0; i < count; i++) {
+		if (spans[i].length < 0) {
+			spans[i].data = NULL;
+			spans[i].length = 0;
+		} else {
+			spans[i].data = data;
+			data += spans[i].length;
+		}
+	}
+	result->count = count;
+	result->spans = spans;
+	result->array = chars;
+	result->pinned = pinned;
+	return result;
+}
+
+JNIEXPORTC jstringspans_t* JNICALL xjni_GetStringArrayPacked(JNIEnv *env,jobjectArray array) {
+	if (array == NULL) return NULL;
+	jsize count = _GetArrayLength(env,array);
+	if (count >= xjni_GetStringArrayPackedThreshold() && strings_helper(env)) {
+		jboolean fallback;
+		jstringspans_t *spans = get_spans_upcall(env,array,count,&fallback);
+		if (spans != NULL || !fallback)
+			return spans;
+	}
+	return get_spans_elements(env,array,count);
+}
+
+JNIEXPORTC void JNICALL xjni_ReleaseStringArrayPacked(JNIEnv *env,jstringspans_t *spans) {
+	if (spans == NULL) return;
+	if (spans->array != NULL) {
+		_ReleasePrimitiveArrayCritical(env,spans->array,spans->pinned,JNI_ABORT);
+		_DeleteLocalRef(env,spans->array);
+	}
+	free(spans);
+}
+
 JNIEXPORTC jsize JNICALL GetStringArrayLength(JNIEnv *env,jobjectArray array) {
 	if (array == NULL) return 0;
 	return _GetArrayLength(env,array);
@@ -153,13 +808,22 @@ JNIEXPORTC const jchar** JNICALL GetStringArrayChars(JNIEnv *env,jobjectArray st
 	}
 
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,arrayLength,1) != JNI_OK) {
+		free((void*)strArray);
+		return NULL;
+	}
 	for (jsize i = 0; i < arrayLength; i++) {
+		xjni_frame_next(&frame);
 		jstring jstr = ubase_cast(jstring,_GetObjectArrayElement(env,str,i));
-		if (jstr != NULL)
+		if (jstr != NULL) {
 			strArray[i] = _GetStringChars(env,jstr,isCopy);
-		else
+			_DeleteLocalRef(env,jstr);
+		} else {
 			strArray[i] = NULL;
+		}
 	}
+	xjni_frame_leave(&frame,NULL);
 
 	return strArray;
 }
@@ -177,11 +841,18 @@ JNIEXPORTC void JNICALL ReleaseStringArrayChars(JNIEnv *env,jobjectArray str,con
 		return;
 	}
 
+	xjni_frame_t frame;
+	xjni_frame_enter(&frame,env,arrayLength,1);
 	for (jsize i = 0; i < arrayLength; i++) {
+		xjni_frame_next(&frame);
+		if (chars[i] == NULL) continue;
 		jstring jstr = ubase_cast(jstring,_GetObjectArrayElement(env,str,i));
-		if (jstr != NULL)
+		if (jstr != NULL) {
 			_ReleaseStringChars(env,jstr,chars[i]);
+			_DeleteLocalRef(env,jstr);
+		}
 	}
+	xjni_frame_leave(&frame,NULL);
 
 	free((void*)chars);
 }
@@ -196,13 +867,18 @@ JNIEXPORTC void JNICALL GetStringArrayRegion(JNIEnv *env,jobjectArray str,jsize
 		return;
 
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; i++) {
+		xjni_frame_next(&frame);
 		jstring jstr = ubase_cast(jstring,_GetObjectArrayElement(env,str,start + i));
 		if (jstr != NULL) {
-			const jchar *chars = _GetStringChars(env,jstr,NULL);
-			jmemcpy(buf[i],chars,_GetStringLength(env,jstr) * sizeof(jchar));
+			if (buf[i] != NULL)
+				_GetStringRegion(env,jstr,0,_GetStringLength(env,jstr),buf[i]);
+			_DeleteLocalRef(env,jstr);
 		}
 	}
+	xjni_frame_leave(&frame,NULL);
 }
 
 JNIEXPORTC void JNICALL SetStringArrayRegion(JNIEnv *env,jobjectArray array,jsize start,jsize len,const jchar **buf) {
@@ -214,15 +890,372 @@ JNIEXPORTC void JNICALL SetStringArrayRegion(JNIEnv *env,jobjectArray array,jsiz
 	if (start >= arrayLength || start + len > arrayLength)
 		return;
 
+	xjni_frame_t frame;
+	if (xjni_frame_enter(&frame,env,len,1) != JNI_OK) return;
 	for (jsize i = 0; i < len; i++) {
+		if (xjni_frame_next(&frame) != JNI_OK) return;
 		jstring jstr = NULL;
 		if (buf[i] != NULL) {
-			jstr = _NewString(env,buf[i],len);
+			jstr = _NewString(env,buf[i],base_cast(jsize,jstrlen(buf[i])));
 			if (jstr == NULL) {
 				BASE_LOGE("Failed to create jstring from jchar array at index %d",i);
-				return;
+				break;
 			}
 		}
 		_SetObjectArrayElement(env,array,start + i,jstr);
+		if (jstr) _DeleteLocalRef(env,jstr);
+	}
+	xjni_frame_leave(&frame,NULL);
+}
+
+static void handle_free(jstringarray_t *h) {
+	free(h->refs);
+	free((void*)h->chars);
+	free((void*)h->utf);
+	free(h->cols);
+	free((void*)h->chars2d);
+	free((void*)h->utf2d);
+	free(h);
+}
+
+/* Handle with room for @p capacity strings; it grows as strings are pushed. */
+static jstringarray_t* handle_new(jsize rows,jsize capacity,jboolean unicode,jboolean global) {
+	jstringarray_t *h = ubase_cast(jstringarray_t*,calloc(1,sizeof(jstringarray_t)));
+	if (h == NULL) return NULL;
+	h->unicode = unicode;
+	h->global = global;
+	h->capacity = capacity > 0 ? capacity : 1;
+	h->refs = ubase_cast(jstring*,malloc(base_cast(size_t,h->capacity) * sizeof(jstring)));
+	if (unicode) h->chars = ubase_cast(const jchar**,malloc(base_cast(size_t,h->capacity) * sizeof(const jchar*)));
+	else h->utf = ubase_cast(const char**,malloc(base_cast(size_t,h->capacity) * sizeof(const char*)));
+	if (rows > 0) {
+		h->rows = rows;
+		h->cols = ubase_cast(jsize*,calloc(base_cast(size_t,rows),sizeof(jsize)));
+		if (unicode) h->chars2d = ubase_cast(const jchar***,calloc(base_cast(size_t,rows),sizeof(const jchar**)));
+		else h->utf2d = ubase_cast(const char***,calloc(base_cast(size_t,rows),sizeof(const char**)));
+	}
+	if (h->refs == NULL || (unicode ? h->chars == NULL : h->utf == NULL) ||
+		(rows > 0 && (h->cols == NULL || (unicode ? h->chars2d == NULL : h->utf2d == NULL)))) {
+		BASE_LOGE("Memory allocation failed for string array handle\n");
+		handle_free(h);
+		return NULL;
+	}
+	return h;
+}
+
+/* Append one string, taking over the local reference @p str (may be NULL). */
+static jint handle_push(JNIEnv *env,jstringarray_t *h,jstring str,jboolean *anyCopy) {
+	if (h->count == h->capacity) {
+		jsize grown = h->capacity * 2;
+		jstring *refs = ubase_cast(jstring*,realloc(h->refs,base_cast(size_t,grown) * sizeof(jstring)));
+		if (refs != NULL) h->refs = refs;
+		void *chars = h->unicode ? realloc((void*)h->chars,base_cast(size_t,grown) * sizeof(const jchar*))
+			: realloc((void*)h->utf,base_cast(size_t,grown) * sizeof(const char*));
+		if (chars != NULL) {
+			if (h->unicode) h->chars = ubase_cast(const jchar**,chars);
+			else h->utf = ubase_cast(const char**,chars);
+		}
+		if (refs == NULL || chars == NULL) {
+			BASE_LOGE("Memory allocation failed for string array handle\n");
+			if (str) _DeleteLocalRef(env,str);
+			return JNI_ERR;
+		}
+		h->capacity = grown;
+	}
+	jsize i = h->count++;
+	h->refs[i] = NULL;
+	if (h->unicode) h->chars[i] = NULL;
+	else h->utf[i] = NULL;
+	if (str == NULL) return JNI_OK;
+
+	if (h->global) {
+		jstring local = str;
+		str = ubase_cast(jstring,_NewGlobalRef(env,local));
+		_DeleteLocalRef(env,local);
+		if (str == NULL) return JNI_ERR;
+	} else if (i % XJNI_FRAME_CHUNK == 0 && _EnsureLocalCapacity(env,XJNI_FRAME_CHUNK) != JNI_OK) {
+		// a local handle keeps the reference itself: room is reserved one chunk at a time
+		_DeleteLocalRef(env,str);
+		return JNI_ERR;
+	}
+	jboolean copy = JNI_FALSE;
+	if (h->unicode) h->chars[i] = _GetStringChars(env,str,&copy);
+	else h->utf[i] = _GetStringUTFChars(env,str,&copy);
+	if (h->unicode ? h->chars[i] == NULL : h->utf[i] == NULL) {
+		if (h->global) _DeleteGlobalRef(env,str);
+		else _DeleteLocalRef(env,str);
+		return JNI_ERR;
+	}
+	h->refs[i] = str;
+	if (copy && anyCopy) *anyCopy = JNI_TRUE;
+	return JNI_OK;
+}
+
+/* Retain every element of the String[] @p array. */
+static jint handle_push_array(JNIEnv *env,jstringarray_t *h,jobjectArray array,jsize len,jboolean *anyCopy) {
+	for (jsize i = 0; i < len; i++) {
+		if (handle_push(env,h,ubase_cast(jstring,_GetObjectArrayElement(env,array,i)),anyCopy) != JNI_OK)
+			return JNI_ERR;
+	}
+	return JNI_OK;
+}
+
+static jstringarray_t* get_handle(JNIEnv *env,jobjectArray array,jboolean unicode,jboolean global,jboolean *isCopy) {
+	if (array == NULL) return NULL;
+	jsize len = _GetArrayLength(env,array);
+	jboolean anyCopy = JNI_FALSE;
+	jstringarray_t *h = handle_new(0,len,unicode,global);
+	if (h == NULL) return NULL;
+	if (handle_push_array(env,h,array,len,&anyCopy) != JNI_OK) {
+		ReleaseStringArrayHandle(env,h);
+		return NULL;
+	}
+	if (isCopy) *isCopy = anyCopy;
+	return h;
+}
+
+static jstringarray_t* get_handle_2d(JNIEnv *env,jobjectArray array,jboolean unicode,jboolean global,jboolean *isCopy) {
+	if (array == NULL) return NULL;
+	jsize rows = _GetArrayLength(env,array);
+	jboolean anyCopy = JNI_FALSE;
+	jstringarray_t *h = handle_new(rows,rows * 4,unicode,global);
+	if (h == NULL) return NULL;
+	for (jsize r = 0; r < rows; r++) {
+		jobjectArray inner = ubase_cast(jobjectArray,_GetObjectArrayElement(env,array,r));
+		if (inner == NULL) {
+			h->cols[r] = -1;
+			continue;
+		}
+		jsize len = _GetArrayLength(env,inner);
+		h->cols[r] = len;
+		jint ret = handle_push_array(env,h,inner,len,&anyCopy);
+		_DeleteLocalRef(env,inner);
+		if (ret != JNI_OK) {
+			ReleaseStringArrayHandle(env,h);
+			return NULL;
+		}
+	}
+	/* Row pointers only once the element tables have stopped moving. */
+	jsize start = 0;
+	for (jsize r = 0; r < rows; r++) {
+		if (h->cols[r] < 0) {
+			h->cols[r] = 0;
+			continue;
+		}
+		if (unicode) h->chars2d[r] = h->chars + start;
+		else h->utf2d[r] = h->utf + start;
+		start += h->cols[r];
+	}
+	if (isCopy) *isCopy = anyCopy;
+	return h;
+}
+
+JNIEXPORTC jstringarray_t* JNICALL GetStringUTFArrayHandle(JNIEnv *env,jobjectArray array,jboolean global,jboolean *isCopy) {
+	return get_handle(env,array,JNI_FALSE,global,isCopy);
+}
+
+JNIEXPORTC jstringarray_t* JNICALL GetStringArrayHandle(JNIEnv *env,jobjectArray array,jboolean global,jboolean *isCopy) {
+	return get_handle(env,array,JNI_TRUE,global,isCopy);
+}
+
+JNIEXPORTC jstringarray_t* JNICALL GetStringUTF2DArrayHandle(JNIEnv *env,jobjectArray array,jboolean global,jboolean *isCopy) {
+	return get_handle_2d(env,array,JNI_FALSE,global,isCopy);
+}
+
+JNIEXPORTC jstringarray_t* JNICALL GetString2DArrayHandle(JNIEnv *env,jobjectArray array,jboolean global,jboolean *isCopy) {
+	return get_handle_2d(env,array,JNI_TRUE,global,isCopy);
+}
+
+JNIEXPORTC void JNICALL ReleaseStringArrayHandle(JNIEnv *env,jstringarray_t *handle) {
+	if (handle == NULL) return;
+	for (jsize i = 0; i < handle->count; i++) {
+		if (handle->unicode ? handle->chars[i] == NULL : handle->utf[i] == NULL) continue;
+		jstring str = handle->refs[i];
+		if (handle->unicode) _ReleaseStringChars(env,str,handle->chars[i]);
+		else _ReleaseStringUTFChars(env,str,handle->utf[i]);
+		if (handle->global) _DeleteGlobalRef(env,str);
+		else _DeleteLocalRef(env,str);
+	}
+	handle_free(handle);
+}
+
+static _Atomic(jmethodID) internMid = NULL;
+
+/* Open-addressing table from UTF-8 value to the jstring made for it in this call. */
+typedef struct dedup_entry {
+	uint32_t hash;
+	const char *key;
+	jstring ref;
+} dedup_entry;
+
+typedef struct dedup_table {
+	JNIEnv *env;
+	dedup_entry *slots;
+	size_t mask;
+	size_t used;
+	jmethodID intern; /* String.intern, NULL to keep the strings as made */
+} dedup_table;
+
+/* Resolve String.intern once, under the String class lock; published with release ordering. */
+static jmethodID intern_method(JNIEnv *env) {
+	jmethodID mid = atomic_load_explicit(&internMid,memory_order_acquire);
+	if (mid != NULL) return mid;
+	jclass strclass = xjni_GetStringClass(env);
+	if (strclass == NULL) return NULL;
+	pthread_mutex_lock(&stringClsMutex);
+	mid = atomic_load_explicit(&internMid,memory_order_relaxed);
+	if (mid == NULL) {
+		mid = _GetMethodID(env,strclass,"intern","()Ljava/lang/String;");
+		atomic_store_explicit(&internMid,mid,memory_order_release);
+	}
+	pthread_mutex_unlock(&stringClsMutex);
+	return mid;
+}
+
+static uint32_t dedup_hash(const char *s) {
+	uint32_t h = 2166136261u;
+	for (const unsigned char *p = ubase_cast(const unsigned char*,s); *p; p++)
+		h = (h ^ *p) * 16777619u;
+	return h;
+}
+
+/* The table lives in a local frame holding one reference per distinct value. */
+static jint dedup_init(dedup_table *t,JNIEnv *env,jboolean intern) {
+	t->env = env;
+	t->used = 0;
+	t->mask = 63;
+	t->intern = intern ? intern_method(env) : NULL;
+	if (intern && t->intern == NULL)
+		return JNI_ERR;
+	t->slots = ubase_cast(dedup_entry*,calloc(t->mask + 1,sizeof(dedup_entry)));
+	if (t->slots == NULL) {
+		BASE_LOGE("Memory allocation failed for string dedup table\n");
+		return JNI_ERR;
+	}
+	if (_PushLocalFrame(env,XJNI_FRAME_CHUNK + 16) != JNI_OK) {
+		free(t->slots);
+		return JNI_ERR;
+	}
+	return JNI_OK;
+}
+
+/* Pop the frame, keeping only @p result. */
+static jobject dedup_free(dedup_table *t,jobject result) {
+	free(t->slots);
+	return _PopLocalFrame(t->env,result);
+}
+
+static jboolean dedup_grow(dedup_table *t) {
+	size_t size = (t->mask + 1) * 2;
+	dedup_entry *slots = ubase_cast(dedup_entry*,calloc(size,sizeof(dedup_entry)));
+	if (slots == NULL) return JNI_FALSE;
+	for (size_t i = 0; i <= t->mask; i++) {
+		if (t->slots[i].key == NULL) continue;
+		size_t j = t->slots[i].hash & (size - 1);
+		while (slots[j].key != NULL) j = (j + 1) & (size - 1);
+		slots[j] = t->slots[i];
+	}
+	free(t->slots);
+	t->slots = slots;
+	t->mask = size - 1;
+	return JNI_TRUE;
+}
+
+/*
+ * jstring for @p s: the one already made in this call, or a new one. Once
+ * XJNI_DEDUP_MAX_DISTINCT values are held, new values are not remembered
+ * and *owned tells the caller to delete the returned reference.
+ */
+static jstring dedup_get(dedup_table *t,const char *s,jboolean *owned) {
+	JNIEnv *env = t->env;
+	uint32_t hash = dedup_hash(s);
+	size_t i = hash & t->mask;
+	for (; t->slots[i].key != NULL; i = (i + 1) & t->mask) {
+		if (t->slots[i].hash == hash && strcmp(t->slots[i].key,s) == 0) {
+			*owned = JNI_FALSE;
+			return t->slots[i].ref;
+		}
+	}
+
+	jstring str = _NewStringUTF(env,s);
+	if (str != NULL && t->intern) {
+		jstring interned = ubase_cast(jstring,_CallObjectMethod(env,str,t->intern));
+		_DeleteLocalRef(env,str);
+		str = interned;
+	}
+	if (str == NULL) return NULL;
+
+	*owned = JNI_TRUE;
+	if (t->used >= XJNI_DEDUP_MAX_DISTINCT) return str;
+	if ((t->used + 1) % XJNI_FRAME_CHUNK == 0 && _EnsureLocalCapacity(env,XJNI_FRAME_CHUNK + 16) != JNI_OK) {
+		_ExceptionClear(env);
+		return str;
+	}
+	if ((t->used + 1) * 2 > t->mask + 1) {
+		if (!dedup_grow(t)) return str;
+		for (i = hash & t->mask; t->slots[i].key != NULL; i = (i + 1) & t->mask);
+	}
+	t->slots[i].hash = hash;
+	t->slots[i].key = s;
+	t->slots[i].ref = str;
+	t->used++;
+	*owned = JNI_FALSE;
+	return str;
+}
+
+/* Fill @p array with jstrings for @p utf, sharing equal values through @p t. */
+static jint dedup_fill(dedup_table *t,jobjectArray array,const char **utf,jsize count) {
+	JNIEnv *env = t->env;
+	for (jsize i = 0; i < count; i++) {
+		if (utf[i] == NULL) continue;
+		jboolean owned;
+		jstring str = dedup_get(t,utf[i],&owned);
+		if (str == NULL) {
+			BASE_LOGE("Failed to create jstring from UTF-8 string: %s\n",utf[i]);
+			return JNI_ERR;
+		}
+		_SetObjectArrayElement(env,array,i,str);
+		if (owned) _DeleteLocalRef(env,str);
+	}
+	return JNI_OK;
+}
+
+JNIEXPORTC jobjectArray JNICALL NewStringUTFArrayDedup(JNIEnv *env,const char **utf,jsize count,jboolean intern) {
+	if (utf == NULL || count < 0)
+		return NULL;
+	jclass strclass = xjni_GetStringClass(env);
+	if (strclass == NULL)
+		return NULL;
+
+	dedup_table table;
+	if (dedup_init(&table,env,intern) != JNI_OK)
+		return NULL;
+	jobjectArray stringArray = _NewObjectArray(env,count,strclass,NULL);
+	if (stringArray != NULL && dedup_fill(&table,stringArray,utf,count) != JNI_OK)
+		stringArray = NULL;
+	return ubase_cast(jobjectArray,dedup_free(&table,stringArray));
+}
+
+JNIEXPORTC jobjectArray JNICALL NewStringUTF2DArrayDedup(JNIEnv *env,const char ***utf,jsize row,jsize col,jboolean intern) {
+	if (row < 0 || col < 0)
+		return NULL;
+	jclass strclass = xjni_GetStringClass(env);
+	jclass arrclass = xjni_GetStringArrayClass(env);
+	if (strclass == NULL || arrclass == NULL)
+		return NULL;
+
+	dedup_table table;
+	if (dedup_init(&table,env,intern) != JNI_OK)
+		return NULL;
+	jobjectArray outer = _NewObjectArray(env,row,arrclass,NULL);
+	for (jsize i = 0; outer != NULL && i < row; i++) {
+		jobjectArray inner = _NewObjectArray(env,col,strclass,NULL);
+		if (inner == NULL || (utf && utf[i] && dedup_fill(&table,inner,utf[i],col) != JNI_OK)) {
+			outer = NULL;
+			break;
+		}
+		_SetObjectArrayElement(env,outer,i,inner);
+		_DeleteLocalRef(env,inner);
 	}
+	return ubase_cast(jobjectArray,dedup_free(&table,outer));
 }
@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <string.h>
+#include <jni.h>
+
+#define LOG_TAG "xjni"
+#include "base-jni.h"
+
+#include <xjni.h>
+
+/*
+ * MSD radix sort over the UTF-16 code units of every string, taken as two
+ * bytes each (high byte first), so byte order is code-unit order and the
+ * result matches String.compareTo. Bucket 0 holds strings that end at the
+ * current depth; they are equal and already in input order, which keeps the
+ * sort stable like Arrays.sort.
+ */
+
+#define SORT_BUCKETS 257
+#define SORT_INSERTION 16
+/* Segments handed to the pool; the caller splits until this many or small enough. */
+#define SORT_MAX_SEGMENTS 4096
+
+typedef struct sort_segment {
+	jsize begin;
+	jsize count;
+	jsize depth;
+} sort_segment;
+
+typedef struct sort_ctx {
+	const jspan_t *spans;
+	jint *idx;
+	jint *tmp;
+	sort_segment *segments;
+	jsize nsegments;
+} sort_ctx;
+
+static inline unsigned sort_key(const jspan_t *s,jsize depth) {
+	jsize unit = depth >> 1;
+	if (unit >= s->length) return 0;
+	jchar c = s->data[unit];
+	return (depth & 1 ? (c & 0xFFu) : (c >> 8)) + 1u;
+}
+
+/* Code-unit comparison starting at unit @p from; shorter prefix first. */
+static inline int sort_compare(const jspan_t *a,const jspan_t *b,jsize from) {
+	jsize n = a->length < b->length ? a->length : b->length;
+	for (jsize k = from; k < n; k++)
+		if (a->data[k] != b->data[k]) return a->data[k] < b->data[k] ? -1 : 1;
+	return (a->length > b->length) - (a->length < b->length);
+}
+
+static void sort_insertion(const jspan_t *spans,jint *idx,jsize count,jsize depth) {
+	jsize from = depth >> 1;
+	for (jsize i = 1; i < count; i++) {
+		jint v = idx[i];
+		jsize j = i;
+		while (j > 0 && sort_compare(&spans[idx[j - 1]],&spans[v],from) > 0) {
+			idx[j] = idx[j - 1];
+			j--;
+		}
+		idx[j] = v;
+	}
+}
+
+/* One counting pass on @p seg; fills @p start with the bucket boundaries (relative to seg->begin). */
+static void sort_pass(const sort_ctx *ctx,const sort_segment *seg,jsize start[SORT_BUCKETS + 1]) {
+	jint *idx = ctx->idx + seg->begin;
+	jint *tmp = ctx->tmp + seg->begin;
+	jsize counts[SORT_BUCKETS] = {0};
+	for (jsize i = 0; i < seg->count; i++)
+		counts[sort_key(&ctx->spans[idx[i]],seg->depth)]++;
+	start[0] = 0;
+	for (int b = 0; b < SORT_BUCKETS; b++)
+		start[b + 1] = start[b] + counts[b];
+	jsize fill[SORT_BUCKETS];
+	memcpy(fill,start,sizeof(fill));
+	for (jsize i = 0; i < seg->count; i++)
+		tmp[fill[sort_key(&ctx->spans[idx[i]],seg->depth)]++] = idx[i];
+	memcpy(idx,tmp,base_cast(size_t,seg->count) * sizeof(jint));
+}
+
+/* Sort one segment completely on the calling thread, with an explicit stack instead of recursion. */
+static jint sort_segment_run(const sort_ctx *ctx,sort_segment root) {
+	size_t cap = 64,top = 0;
+	sort_segment *stack = ubase_cast(sort_segment*,malloc(cap * sizeof(sort_segment)));
+	if (stack == NULL) return JNI_ERR;
+	stack[top++] = root;
+	while (top > 0) {
+		sort_segment seg = stack[--top];
+		if (seg.count <= SORT_INSERTION) {
+			sort_insertion(ctx->spans,ctx->idx + seg.begin,seg.count,seg.depth);
+			continue;
+		}
+		jsize start[SORT_BUCKETS + 1];
+		sort_pass(ctx,&seg,start);
+		for (int b = 1; b < SORT_BUCKETS; b++) {
+			jsize n = start[b + 1] - start[b];
+			if (n < 2) continue;
+			if (top == cap) {
+				sort_segment *grown = ubase_cast(sort_segment*,realloc(stack,cap * 2 * sizeof(sort_segment)));
+				if (grown == NULL) { free(stack); return JNI_ERR; }
+				stack = grown;
+				cap *= 2;
+			}
+			stack[top].begin = seg.begin + start[b];
+			stack[top].count = n;
+			stack[top].depth = seg.depth + 1;
+			top++;
+		}
+	}
+	free(stack);
+	return JNI_OK;
+}
+
+static jint sort_task(JNIEnv *env,void *arg,jsize begin,jsize end) {
+	(void)env;
+	const sort_ctx *ctx = ubase_cast(const sort_ctx*,arg);
+	for (jsize s = begin; s < end; s++)
+		if (sort_segment_run(ctx,ctx->segments[s]) != JNI_OK) return JNI_ERR;
+	return JNI_OK;
+}
+
+/*
+ * Split @p all on the caller until no segment is larger than a fair
+ * share of the work, so that one dominant prefix (all-ASCII data shares its
+ * high bytes) does not leave the pool idle.
+ */
+static jint sort_parallel(JNIEnv *env,xjni_pool_t *pool,sort_ctx *ctx,sort_segment all) {
+	ctx->segments = ubase_cast(sort_segment*,malloc(SORT_MAX_SEGMENTS * sizeof(sort_segment)));
+	if (ctx->segments == NULL) return JNI_ERR;
+	ctx->nsegments = 1;
+	ctx->segments[0] = all;
+	jsize share = all.count / base_cast(jsize,(xjni_pool_size(pool) + 1) * 8);
+	if (share < SORT_INSERTION) share = SORT_INSERTION;
+
+	for (;;) {
+		jsize largest = 0;
+		for (jsize s = 1; s < ctx->nsegments; s++)
+			if (ctx->segments[s].count > ctx->segments[largest].count) largest = s;
+		sort_segment seg = ctx->segments[largest];
+		if (seg.count <= share || ctx->nsegments > SORT_MAX_SEGMENTS - SORT_BUCKETS)
+			break;
+		jsize start[SORT_BUCKETS + 1];
+		sort_pass(ctx,&seg,start);
+		ctx->segments[largest] = ctx->segments[--ctx->nsegments];
+		for (int b = 1; b < SORT_BUCKETS; b++) {
+			jsize n = start[b + 1] - start[b];
+			if (n < 2) continue;
+			sort_segment *next = &ctx->segments[ctx->nsegments++];
+			next->begin = seg.begin + start[b];
+			next->count = n;
+			next->depth = seg.depth + 1;
+		}
+		if (ctx->nsegments == 0) break;
+	}
+	jint ret = xjni_pool_run(pool,env,ctx->nsegments,sort_task,ctx);
+	free(ctx->segments);
+	ctx->segments = NULL;
+	return ret;
+}
+
+/*
+ * Apply @p perm to @p array by following its cycles; every slot is read and written once.
+ * At most two local references (the head of the cycle and the element moved) are live at a
+ * time, so no frame is needed, and popping one in the middle of a cycle would free its head.
+ */
+static jint sort_reorder(JNIEnv *env,jobjectArray array,const jint *perm,jsize count) {
+	unsigned char *done = ubase_cast(unsigned char*,calloc(base_cast(size_t,count) + 1,1));
+	if (done == NULL) return JNI_ERR;
+	for (jsize start = 0; start < count; start++) {
+		if (done[start] || perm[start] == start) continue;
+		jobject first = _GetObjectArrayElement(env,array,start);
+		jsize j = start;
+		while (perm[j] != start) {
+			jobject next = _GetObjectArrayElement(env,array,perm[j]);
+			_SetObjectArrayElement(env,array,j,next);
+			if (next) _DeleteLocalRef(env,next);
+			done[j] = 1;
+			j = perm[j];
+		}
+		_SetObjectArrayElement(env,array,j,first);
+		if (first) _DeleteLocalRef(env,first);
+		done[j] = 1;
+	}
+	free(done);
+	return JNI_OK;
+}
+
+/* Copy pinned views into one native block: the views first, then their units. */
+static jspan_t* sort_copy_spans(const jstringspans_t *spans) {
+	size_t units = 0;
+	for (jsize i = 0; i < spans->count; i++)
+		units += base_cast(size_t,spans->spans[i].length);
+	size_t head = (base_cast(size_t,spans->count) * sizeof(jspan_t) + sizeof(jchar) - 1) / sizeof(jchar) * sizeof(jchar);
+	jspan_t *copy = ubase_cast(jspan_t*,malloc(head + units * sizeof(jchar) + 1));
+	if (copy == NULL) {
+		BASE_LOGE("Memory allocation failed for string sort\n");
+		return NULL;
+	}
+	jchar *data = ubase_cast(jchar*,ubase_cast(char*,copy) + head);
+	for (jsize i = 0; i < spans->count; i++) {
+		const jspan_t *s = &spans->spans[i];
+		copy[i].length = s->length;
+		copy[i].data = s->data ? data : NULL;
+		if (s->data) {
+			memcpy(data,s->data,base_cast(size_t,s->length) * sizeof(jchar));
+			data += s->length;
+		}
+	}
+	return copy;
+}
+
+JNIEXPORTC jint JNICALL xjni_SortStringArray(JNIEnv *env,xjni_pool_t *pool,jobjectArray array,jint *perm,jboolean reorder) {
+	if (array == NULL || (perm == NULL && !reorder)) return JNI_ERR;
+	jstringspans_t *spans = xjni_GetStringArrayPacked(env,array);
+	if (spans == NULL) return JNI_ERR;
+	jsize count = spans->count;
+
+	sort_ctx ctx;
+	ctx.spans = spans->spans;
+	ctx.segments = NULL;
+	ctx.idx = perm ? perm : ubase_cast(jint*,malloc((base_cast(size_t,count) + 1) * sizeof(jint)));
+	ctx.tmp = ubase_cast(jint*,malloc((base_cast(size_t,count) + 1) * sizeof(jint)));
+	if (ctx.idx == NULL || ctx.tmp == NULL) {
+		BASE_LOGE("Memory allocation failed for string sort\n");
+		xjni_ReleaseStringArrayPacked(env,spans);
+		if (ctx.idx != perm) free(ctx.idx);
+		free(ctx.tmp);
+		return JNI_ERR;
+	}
+
+	/* Null elements first, in input order; they do not take part in the radix passes. */
+	jsize nulls = 0;
+	for (jsize i = 0; i < count; i++)
+		if (spans->spans[i].data == NULL) ctx.idx[nulls++] = i;
+	jsize k = nulls;
+	for (jsize i = 0; i < count; i++)
+		if (spans->spans[i].data != NULL) ctx.idx[k++] = i;
+
+	jint ret = JNI_OK;
+	sort_segment all = { nulls,count - nulls,0 };
+	jboolean parallel = pool != NULL && all.count > 1 && base_cast(size_t,all.count) >= xjni_GetParallelThreshold();
+	jspan_t *copied = NULL;
+	if (parallel && spans->array != NULL) {
+		/* Pool runs block and the workers make JNI calls: unpin before dispatching. */
+		copied = sort_copy_spans(spans);
+		xjni_ReleaseStringArrayPacked(env,spans);
+		spans = NULL;
+		if (copied == NULL) ret = JNI_ERR;
+		ctx.spans = copied;
+	}
+	if (ret == JNI_OK && all.count > 1) {
+		if (parallel)
+			ret = sort_parallel(env,pool,&ctx,all);
+		else
+			ret = sort_segment_run(&ctx,all);
+	}
+	free(ctx.tmp);
+	free(copied);
+	/* Unpin before touching the Java array again. */
+	xjni_ReleaseStringArrayPacked(env,spans);
+
+	if (ret == JNI_OK && reorder)
+		ret = sort_reorder(env,array,ctx.idx,count);
+	if (ctx.idx != perm) free(ctx.idx);
+	return ret;
+}
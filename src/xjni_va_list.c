@@ -8,90 +8,23 @@
 
 #define LOG_TAG "xjni"
 #include "base-jni.h"
-
-static jclass gStringCls = NULL;
-static jmethodID gFormatMid = NULL;
-
-static jboolean ensureStringFormat(JNIEnv *env) {
-	if (gStringCls && gFormatMid) return JNI_TRUE;
-
-	jclass local = _FindClass(env, "java/lang/String");
-	if (!local) return JNI_FALSE;
-
-	jclass global = _NewGlobalRef(env, local);
-	_DeleteLocalRef(env, local);
-	if (!global) return JNI_FALSE;
-
-	jmethodID mid = _GetStaticMethodID(env, global,"format","(Ljava/lang/String;[Ljava/lang/Object;)Ljava/lang/String;");
-	if (!mid) {
-		_DeleteGlobalRef(env, global);
-		return JNI_FALSE;
-	}
-	/* publish atomically */
-	gStringCls = global;
-	gFormatMid = mid;
-	return JNI_TRUE;
-}
+#include "xjni_format.h"
 
 JNIEXPORTC void JNICALL JSnPrintf(JNIEnv *env, char *s, size_t maxlen,jstring format, jargs_t args) {
-	jstring result = NULL;
-	const char *utf = NULL;
-	if (!ensureStringFormat(env)) {
-		XJNI_LOGE("XJniVaList", "String.format init failed");
-		return;
-	}
-	if (args) result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format, args);
-	else result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format);
-	if (_ExceptionCheck(env) || !result) {
-		XJNI_LOGE("XJniVaList", "String.format threw");
-		_ExceptionClear(env);
-		goto cleanup;
-	}
-	utf = _GetStringUTFChars(env, result, NULL);
-	if (!utf) {
-		XJNI_LOGE("XJniVaList", "GetStringUTFChars failed");
-		goto cleanup;
-	}
-	snprintf(s,maxlen,"%s",utf);
-cleanup:
-	if (utf) _ReleaseStringUTFChars(env, result, utf);
-	if (result) _DeleteLocalRef(env, result);
+	xjni_sink_t sink;
+	xjni_sink_buffer(&sink, s, maxlen);
+	xjni_format(env, &sink, format, NULL, args);
 }
 
 JNIEXPORTC void JNICALL JSPrintf(JNIEnv *env,char* s,jstring format,jargs_t args) {
-	jstring result = NULL;
-	const char *utf = NULL;
-	if (!ensureStringFormat(env)) {
-		XJNI_LOGE("XJniVaList", "String.format init failed");
-		return;
-	}
-	if (args) result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format, args);
-	else result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format);
-	if (_ExceptionCheck(env) || !result) {
-		XJNI_LOGE("XJniVaList", "String.format threw");
-		_ExceptionClear(env);
-		goto cleanup;
-	}
-	utf = _GetStringUTFChars(env, result, NULL);
-	if (!utf) {
-		XJNI_LOGE("XJniVaList", "GetStringUTFChars failed");
-		goto cleanup;
-	}
-	sprintf(s,"%s",utf);
-cleanup:
-	if (utf) _ReleaseStringUTFChars(env, result, utf);
-	if (result) _DeleteLocalRef(env, result);
+	JSnPrintf(env,s,SIZE_MAX,format,args);
 }
 
 JNIEXPORTC void JNICALL JSnPrintfUTF(JNIEnv *env,char* s,size_t maxlen,const char* format,jargs_t args) {
 	if (format == NULL) return;
-	jstring jstr = _NewStringUTF(env,format);
-	if (jstr == NULL || _ExceptionCheck(env)) {
-		_ExceptionClear(env);
-		return;
-	}
-	JSnPrintf(env,s,maxlen,jstr,args);
-	_DeleteLocalRef(env,jstr);
+	xjni_sink_t sink;
+	xjni_sink_buffer(&sink, s, maxlen);
+	xjni_format(env, &sink, NULL, format, args);
 }
 
 JNIEXPORTC void JNICALL JSPrintfUTF(JNIEnv *env,char* s,const char* format,jargs_t args) {
@@ -99,39 +32,16 @@ JNIEXPORTC void JNICALL JSPrintfUTF(JNIEnv *env,char* s,const char* format,jargs
 }
 
 JNIEXPORTC void JNICALL JFPrintf(JNIEnv *env,FILE* fp,jstring format, jargs_t args) {
-	jstring result = NULL;
-	const char *utf = NULL;
-	if (!ensureStringFormat(env)) {
-		XJNI_LOGE("XJniVaList", "String.format init failed");
-		return;
-	}
-	if (args) result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format, args);
-	else result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format);
-	if (_ExceptionCheck(env) || !result) {
-		XJNI_LOGE("XJniVaList", "String.format threw");
-		_ExceptionClear(env);
-		goto cleanup;
-	}
-	utf = _GetStringUTFChars(env, result, NULL);
-	if (!utf) {
-		XJNI_LOGE("XJniVaList", "GetStringUTFChars failed");
-		goto cleanup;
-	}
-	fprintf(fp,"%s",utf);
-cleanup:
-	if (utf) _ReleaseStringUTFChars(env, result, utf);
-	if (result) _DeleteLocalRef(env, result);
+	xjni_sink_t sink;
+	xjni_sink_file(&sink, fp);
+	xjni_format(env, &sink, format, NULL, args);
 }
 
 JNIEXPORTC void JNICALL JFPrintfUTF(JNIEnv *env,FILE* fp,const char* format,jargs_t args) {
 	if (format == NULL) return;
-	jstring jstr = _NewStringUTF(env,format);
-	if (jstr == NULL || _ExceptionCheck(env)) {
-		_ExceptionClear(env);
-		return;
-	}
-	JFPrintf(env,fp,jstr,args);
-	_DeleteLocalRef(env,jstr);
+	xjni_sink_t sink;
+	xjni_sink_file(&sink, fp);
+	xjni_format(env, &sink, NULL, format, args);
 }
 
 
@@ -144,48 +54,69 @@ JNIEXPORTC void JNICALL JPrintfUTF(JNIEnv *env,const char* format, jargs_t args)
 }
 
 JNIEXPORTC void JNICALL JDPrintf(JNIEnv *env,int fd,jstring format, jargs_t args) {
-	jstring result = NULL;
-	const char *utf = NULL;
-	if (!ensureStringFormat(env)) {
-		XJNI_LOGE("XJniVaList", "String.format init failed");
-		return;
-	}
-	if (args) result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format, args);
-	else result = (jstring)_CallStaticObjectMethod(env, gStringCls, gFormatMid, format);
-	if (_ExceptionCheck(env) || !result) {
-		XJNI_LOGE("XJniVaList", "String.format threw");
-		_ExceptionClear(env);
-		goto cleanup;
-	}
-	utf = _GetStringUTFChars(env, result, NULL);
-	if (!utf) {
-		XJNI_LOGE("XJniVaList", "GetStringUTFChars failed");
-		goto cleanup;
-	}
-#ifdef _WIN32
-	FILE* fp = fdopen(fd, "w");
-	if (fp) {
-		fprintf(fp,"%s",utf);
-		fflush(fp);
-	} else {
-		XJNI_LOGE("XJniVaList","_fdopen failed for fd %d", fd);
-		goto cleanup;
-	}
-#else
-	dprintf(fd,"%s",utf);
-#endif
-cleanup:
-	if (utf) _ReleaseStringUTFChars(env, result, utf);
-	if (result) _DeleteLocalRef(env, result);
+	xjni_sink_t sink;
+	xjni_sink_fd(&sink, fd);
+	xjni_format(env, &sink, format, NULL, args);
 }
 
 JNIEXPORTC void JNICALL JDPrintfUTF(JNIEnv *env,int fd,const char* format,jargs_t args) {
 	if (format == NULL) return;
-	jstring jstr = _NewStringUTF(env,format);
-	if (jstr == NULL || _ExceptionCheck(env)) {
-		_ExceptionClear(env);
-		return;
-	}
-	JDPrintf(env,fd,jstr,args);
-	_DeleteLocalRef(env,jstr);
+	xjni_sink_t sink;
+	xjni_sink_fd(&sink, fd);
+	xjni_format(env, &sink, NULL, format, args);
+}
+
+// Materialize the stage, run call with it as args, release the array; only
+// an exception raised by the boxing is cleared, one pending before or thrown
+// by call is left to the caller
+#define JARGS_STAGED_CALL(call) do { \
+	if (_ExceptionCheck(env)) return; \
+	jargs_t args = JArgsStageToJArgs(env,stage); \
+	if (!args) { \
+		XJNI_LOGE("XJniVaList", "staged arguments could not be boxed"); \
+		if (_ExceptionCheck(env)) _ExceptionClear(env); \
+		return; \
+	} \
+	call; \
+	_DeleteLocalRef(env,args); \
+} while (0)
+
+JNIEXPORTC void JNICALL JSnPrintfStage(JNIEnv *env,char* s,size_t maxlen,jstring format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JSnPrintf(env,s,maxlen,format,args));
+}
+
+JNIEXPORTC void JNICALL JSnPrintfUTFStage(JNIEnv *env,char* s,size_t maxlen,const char* format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JSnPrintfUTF(env,s,maxlen,format,args));
+}
+
+JNIEXPORTC void JNICALL JSPrintfStage(JNIEnv *env,char* s,jstring format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JSPrintf(env,s,format,args));
+}
+
+JNIEXPORTC void JNICALL JSPrintfUTFStage(JNIEnv *env,char* s,const char* format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JSPrintfUTF(env,s,format,args));
+}
+
+JNIEXPORTC void JNICALL JFPrintfStage(JNIEnv *env,FILE* fp,jstring format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JFPrintf(env,fp,format,args));
+}
+
+JNIEXPORTC void JNICALL JFPrintfUTFStage(JNIEnv *env,FILE* fp,const char* format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JFPrintfUTF(env,fp,format,args));
+}
+
+JNIEXPORTC void JNICALL JDPrintfStage(JNIEnv *env,int fd,jstring format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JDPrintf(env,fd,format,args));
+}
+
+JNIEXPORTC void JNICALL JDPrintfUTFStage(JNIEnv *env,int fd,const char* format,const jargs_stage_t *stage) {
+	JARGS_STAGED_CALL(JDPrintfUTF(env,fd,format,args));
+}
+
+JNIEXPORTC void JNICALL JPrintfStage(JNIEnv *env,jstring format,const jargs_stage_t *stage) {
+	JFPrintfStage(env,stdout,format,stage);
+}
+
+JNIEXPORTC void JNICALL JPrintfUTFStage(JNIEnv *env,const char* format,const jargs_stage_t *stage) {
+	JFPrintfUTFStage(env,stdout,format,stage);
 }
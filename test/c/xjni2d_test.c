@@ -40,3 +40,23 @@ Java_Array2DTest_nativeTest(JNIEnv *env, jobject obj) {
 
     ReleaseStringUTF2DArrayChars(env, strArr, strs, 0);
 }
+
+JNIEXPORT jfloatArray JNICALL
+Java_Array2DTest_nativeColMajor(JNIEnv *env, jclass cls, jobjectArray arr, jint cols) {
+    (void)cls;
+    jsize rows = (*env)->GetArrayLength(env, arr);
+    jfloat *buf = (jfloat *)malloc(((size_t)rows * (size_t)cols + 1) * sizeof(jfloat));
+    if (!buf) return NULL;
+
+    jfloatArray out = NULL;
+    if (xjni_Export2DArray(env, arr, XJNI_TYPE_INT, rows, cols, XJNI_TYPE_FLOAT, XJNI_COL_MAJOR, 0, buf) == JNI_OK) {
+        out = (*env)->NewFloatArray(env, rows * cols);
+        if (out) (*env)->SetFloatArrayRegion(env, out, 0, rows * cols, buf);
+
+        /* round trip: write -x back through the column-major import */
+        for (jsize i = 0; i < rows * cols; i++) buf[i] = -buf[i];
+        xjni_Import2DArray(env, arr, XJNI_TYPE_INT, rows, cols, XJNI_TYPE_FLOAT, XJNI_COL_MAJOR, 0, buf);
+    }
+    free(buf);
+    return out;
+}
@@ -42,3 +42,45 @@ JNIEXPORT void JNICALL Java_ArrayFieldTest_nativeTest(JNIEnv *env, jobject obj)
     sints[1] = 777;
     (*env)->ReleaseIntArrayElements(env, sIntArr, sints, 0);
 }
+
+/* ===== name-based accessors ===== */
+
+JNIEXPORT void JNICALL Java_ArrayFieldTest_nativeByName(JNIEnv *env, jobject obj) {
+    jclass cls = (*env)->GetObjectClass(env, obj);
+
+    // pin char[] by name and upper-case it in place
+    jcharArray chars;
+    jchar *c = GetCharArrayFieldElements(env, obj, "charArray", &chars, NULL);
+    if (c != NULL) {
+        jsize len = (*env)->GetArrayLength(env, chars);
+        for (jsize i = 0; i < len; i++)
+            if (c[i] >= 'a' && c[i] <= 'z') c[i] = (jchar)(c[i] - 'a' + 'A');
+    }
+    ReleaseCharArrayFieldElements(env, chars, c, 0);
+
+    // flip every boolean, the cached field ID is reused on the second lookup
+    for (int pass = 0; pass < 2; pass++) {
+        jbooleanArray flags;
+        jboolean *z = GetBooleanArrayFieldElements(env, obj, "flags", &flags, NULL);
+        if (z != NULL && pass == 0) {
+            jsize len = (*env)->GetArrayLength(env, flags);
+            for (jsize i = 0; i < len; i++) z[i] = !z[i];
+        }
+        ReleaseBooleanArrayFieldElements(env, flags, z, pass == 0 ? 0 : JNI_ABORT);
+    }
+
+    // replace short[] and the static int[] by name
+    jshortArray shorts = (*env)->NewShortArray(env, 2);
+    jshort sv[2] = { 7, 8 };
+    (*env)->SetShortArrayRegion(env, shorts, 0, 2, sv);
+    SetShortArrayFieldByName(env, obj, "shortArray", shorts);
+
+    jintArray ints = (*env)->NewIntArray(env, 1);
+    jint iv = 4242;
+    (*env)->SetIntArrayRegion(env, ints, 0, 1, &iv);
+    SetStaticArrayField(env, cls, xjni_GetStaticFieldIDCached(env, cls, "staticIntArray", "[I"), ints);
+
+    jobjectArray names = GetObjectArrayFieldByName(env, obj, "stringArray", "[Ljava/lang/String;");
+    if (names != NULL)
+        SetStaticObjectArrayFieldByName(env, cls, "staticStringArray", "[Ljava/lang/String;", names);
+}
@@ -0,0 +1,46 @@
+#include <jni.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xjni_arrow.h>
+
+/* =========================
+ * Native test
+ * ========================= */
+
+/* rank 0: String[], rank 1: primitive array, rank 2: primitive 2D array */
+static jint export_any(JNIEnv *env, jobject array, jchar type, jint rank, struct ArrowArray *out, struct ArrowSchema *schema) {
+    if (rank == 0)
+        return xjni_ExportArrowStringArray(env, (jobjectArray)array, out, schema);
+    if (rank == 1)
+        return xjni_ExportArrowArray(env, (jarray)array, (xjni_ElementType)type, out, schema);
+    return xjni_Export2DArrowArray(env, (jobjectArray)array, (xjni_ElementType)type, out, schema);
+}
+
+JNIEXPORT jobject JNICALL
+Java_ArrowTest_nativeRoundTrip(JNIEnv *env, jclass cls, jobject array, jchar type, jint rank) {
+    (void)cls;
+    struct ArrowArray out;
+    struct ArrowSchema schema;
+    if (export_any(env, array, type, rank, &out, &schema) != JNI_OK)
+        return NULL;
+
+    jobject result = xjni_ImportArrowArray(env, &out, &schema);
+    out.release(&out);
+    schema.release(&schema);
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_ArrowTest_nativeFormat(JNIEnv *env, jclass cls, jobject array, jchar type, jint rank) {
+    (void)cls;
+    struct ArrowArray out;
+    struct ArrowSchema schema;
+    if (export_any(env, array, type, rank, &out, &schema) != JNI_OK)
+        return NULL;
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s/%lld", schema.format, (long long)out.null_count);
+    out.release(&out);
+    schema.release(&schema);
+    return (*env)->NewStringUTF(env, buf);
+}
@@ -0,0 +1,98 @@
+#include <jni.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xjni_marshal.h>
+
+/* =========================
+ * Native test
+ * ========================= */
+
+typedef struct record_t {
+    jint id;
+    jdouble score;
+    jboolean active;
+    const char *name;
+    xjni_view_t values;
+} record_t;
+
+static const xjni_field_t recordFields[] = {
+    XJNI_FIELD(record_t, id, "id", "I"),
+    XJNI_FIELD(record_t, score, "score", "D"),
+    XJNI_FIELD(record_t, active, "active", "Z"),
+    XJNI_FIELD(record_t, name, "name", "Ljava/lang/String;"),
+    XJNI_FIELD(record_t, values, "values", "[I"),
+};
+
+/* Same checksum as MarshalTest.checksum(), computed from the marshalled structs. */
+JNIEXPORT jlong JNICALL
+Java_MarshalTest_nativeChecksum(JNIEnv *env, jclass cls, jobjectArray records) {
+    (void)cls;
+    jclass recordCls = (*env)->FindClass(env, "MarshalTest$Record");
+    if (recordCls == NULL) return -1;
+    xjni_marshal_t *m = xjni_MarshalCompile(env, recordCls, recordFields, sizeof(recordFields) / sizeof(recordFields[0]), sizeof(record_t));
+    (*env)->DeleteLocalRef(env, recordCls);
+    if (m == NULL) return -1;
+
+    jsize n = (*env)->GetArrayLength(env, records);
+    record_t *out = (record_t *)malloc(sizeof(record_t) * (size_t)(n ? n : 1));
+    xjni_arena_t *arena = xjni_ArenaNew(0);
+    jlong sum = -1;
+    if (out != NULL && arena != NULL && xjni_MarshalObjectArray(env, m, records, out, arena) == JNI_OK) {
+        sum = 0;
+        for (jsize i = 0; i < n; i++) {
+            const record_t *r = &out[i];
+            sum = sum * 31 + r->id + (jlong)(r->score * 2) + (r->active ? 1 : 0);
+            sum = sum * 31 + (r->name ? (jlong)strlen(r->name) : -1);
+            for (jsize k = 0; k < r->values.length; k++)
+                sum = sum * 31 + ((const jint *)r->values.data)[k];
+        }
+    }
+    xjni_ArenaFree(arena);
+    free(out);
+    xjni_MarshalFree(env, m);
+    return sum;
+}
+
+/* Build n records natively, mode 0 through AllocObject, 1 through the constructor, 2 through the factory. */
+JNIEXPORT jobjectArray JNICALL
+Java_MarshalTest_nativeBuild(JNIEnv *env, jclass cls, jint n, jint mode) {
+    jclass recordCls = (*env)->FindClass(env, "MarshalTest$Record");
+    if (recordCls == NULL) return NULL;
+    xjni_marshal_t *m = xjni_MarshalCompileBuilder(env, recordCls, recordFields, sizeof(recordFields) / sizeof(recordFields[0]), sizeof(record_t), mode == 1);
+    (*env)->DeleteLocalRef(env, recordCls);
+    if (m == NULL) return NULL;
+    if (mode == 2 && xjni_MarshalSetFactory(env, m, recordFields, cls, "fromColumns", NULL) != JNI_OK) {
+        xjni_MarshalFree(env, m);
+        return NULL;
+    }
+
+    record_t *in = (record_t *)calloc((size_t)(n ? n : 1), sizeof(record_t));
+    char *names = (char *)malloc((size_t)n * 24 + 1);
+    jint *values = (jint *)malloc(sizeof(jint) * ((size_t)n * 3 + 1));
+    jobjectArray result = NULL;
+    if (in != NULL && names != NULL && values != NULL) {
+        for (jint i = 0; i < n; i++) {
+            record_t *r = &in[i];
+            r->id = i;
+            r->score = i * 0.5;
+            r->active = (i % 2 == 0) ? JNI_TRUE : JNI_FALSE;
+            if (i % 7 != 0) {
+                snprintf(names + (size_t)i * 24, 24, "record-%d", i);
+                r->name = names + (size_t)i * 24;
+            }
+            if (i % 5 != 0) {
+                jint *v = values + (size_t)i * 3;
+                v[0] = i; v[1] = -i; v[2] = i % 17;
+                r->values.data = v;
+                r->values.length = 3;
+            }
+        }
+        result = xjni_BuildObjectArray(env, m, in, n);
+    }
+    free(values);
+    free(names);
+    free(in);
+    xjni_MarshalFree(env, m);
+    return result;
+}
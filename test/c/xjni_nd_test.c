@@ -0,0 +1,68 @@
+#include <jni.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xjni_nd.h>
+
+/* =========================
+ * Native test
+ * ========================= */
+
+JNIEXPORT jfloatArray JNICALL
+Java_ArrayNDTest_nativeFlatten(JNIEnv *env, jclass cls, jobjectArray arr) {
+    (void)cls;
+    jsize shape[3];
+    if (GetNDArrayShape(env, arr, 3, shape) != JNI_OK)
+        return NULL;
+
+    size_t count = GetNDArrayCount(3, shape);
+    jfloat *buf = (jfloat *)malloc((count ? count : 1) * sizeof(jfloat));
+    if (!buf) return NULL;
+
+    jfloatArray out = NULL;
+    if (GetFloatNDArrayRegion(env, arr, 3, shape, buf) == JNI_OK) {
+        out = (*env)->NewFloatArray(env, (jsize)count);
+        if (out) (*env)->SetFloatArrayRegion(env, out, 0, (jsize)count, buf);
+    }
+    free(buf);
+    return out;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_ArrayNDTest_nativeBuild(JNIEnv *env, jclass cls, jint d0, jint d1, jint d2, jint d3) {
+    (void)cls;
+    jsize shape[4] = { d0, d1, d2, d3 };
+    size_t count = GetNDArrayCount(4, shape);
+    jdouble *data = (jdouble *)malloc((count ? count : 1) * sizeof(jdouble));
+    if (!data) return NULL;
+    for (size_t i = 0; i < count; i++)
+        data[i] = (jdouble)i;
+
+    jobjectArray out = (jobjectArray)NewDoubleNDArray(env, 4, shape, data);
+    free(data);
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_ArrayNDTest_nativeTranspose(JNIEnv *env, jclass cls, jobjectArray src, jobjectArray dst) {
+    (void)cls;
+    jsize shape[2];
+    if (GetNDArrayShape(env, src, 2, shape) != JNI_OK)
+        return;
+
+    jint *buf = (jint *)malloc(GetNDArrayCount(2, shape) * sizeof(jint) + 1);
+    if (!buf) return;
+
+    /* read src with column-major strides, write it back packed into dst */
+    size_t strides[2] = { 1, (size_t)shape[0] };
+    jsize tshape[2] = { shape[1], shape[0] };
+    if (GetNDArrayRegion(env, src, XJNI_TYPE_INT, 2, shape, strides, buf) == JNI_OK)
+        SetIntNDArrayRegion(env, dst, 2, tshape, buf);
+    free(buf);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_ArrayNDTest_nativeIsRectangular(JNIEnv *env, jclass cls, jobjectArray arr, jint rank) {
+    (void)cls;
+    jsize shape[XJNI_ND_MAX_RANK];
+    return GetNDArrayShape(env, arr, rank, shape) == JNI_OK ? JNI_TRUE : JNI_FALSE;
+}
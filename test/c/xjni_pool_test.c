@@ -0,0 +1,61 @@
+#include <jni.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xjni.h>
+
+/* =========================
+ * Native test
+ * ========================= */
+
+static xjni_pool_t *pool = NULL;
+
+JNIEXPORT jboolean JNICALL
+Java_Array2DParallelTest_nativeInit(JNIEnv *env, jclass cls, jint threads) {
+    (void)cls;
+    JavaVM *vm = NULL;
+    if ((*env)->GetJavaVM(env, &vm) != JNI_OK)
+        return JNI_FALSE;
+    pool = xjni_pool_new(vm, threads);
+    xjni_SetParallelThreshold(0);
+    return pool != NULL ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_Array2DParallelTest_nativeFree(JNIEnv *env, jclass cls) {
+    (void)env; (void)cls;
+    xjni_pool_free(pool);
+    pool = NULL;
+}
+
+/* Copy arr into a flat buffer (serially or through the pool) and return its checksum. */
+JNIEXPORT jdouble JNICALL
+Java_Array2DParallelTest_nativeSum(JNIEnv *env, jclass cls, jobjectArray arr, jint cols, jboolean parallel) {
+    (void)cls;
+    jsize rows = (*env)->GetArrayLength(env, arr);
+    jdouble *buf = (jdouble *)malloc(((size_t)rows * (size_t)cols + 1) * sizeof(jdouble));
+    if (!buf) return -1.0;
+
+    jint ret = parallel
+        ? GetDouble2DArrayFlatRegionParallel(env, pool, arr, 0, rows, cols, buf)
+        : GetDouble2DArrayFlatRegion(env, arr, 0, rows, cols, buf);
+
+    jdouble sum = 0.0;
+    for (size_t i = 0; ret == JNI_OK && i < (size_t)rows * (size_t)cols; i++)
+        sum += buf[i] * (jdouble)(i % 7);
+    free(buf);
+    return ret == JNI_OK ? sum : -1.0;
+}
+
+/* Write i into element i of arr through the pool. */
+JNIEXPORT jboolean JNICALL
+Java_Array2DParallelTest_nativeFill(JNIEnv *env, jclass cls, jobjectArray arr, jint cols) {
+    (void)cls;
+    jsize rows = (*env)->GetArrayLength(env, arr);
+    jint *buf = (jint *)malloc(((size_t)rows * (size_t)cols + 1) * sizeof(jint));
+    if (!buf) return JNI_FALSE;
+    for (size_t i = 0; i < (size_t)rows * (size_t)cols; i++)
+        buf[i] = (jint)i;
+    jint ret = SetInt2DArrayFlatRegionParallel(env, pool, arr, 0, rows, cols, buf);
+    free(buf);
+    return ret == JNI_OK ? JNI_TRUE : JNI_FALSE;
+}
@@ -54,3 +54,156 @@ JNIEXPORT void JNICALL Java_TestStringArray_printStringArray(JNIEnv *env, jobjec
 		(*env)->ReleaseStringUTFChars(env, element, str);
 	}
 }
+
+/* Round-trip a large String[] through the bulk helpers; run with -Xcheck:jni. */
+JNIEXPORT jobjectArray JNICALL Java_TestStringArrayLarge_roundTrip(JNIEnv *env, jclass cls, jobjectArray input) {
+	(void)cls;
+	jsize len = GetStringUTFArrayLength(env, input);
+	const char **chars = GetStringUTFArrayChars(env, input, NULL);
+	if (chars == NULL) return NULL;
+
+	jobjectArray result = NewStringUTFArray(env, chars, len);
+	if (result != NULL)
+		SetStringUTFArrayRegion(env, result, 0, len, chars);
+	ReleaseStringUTFArrayChars(env, input, chars, 0);
+	return result;
+}
+
+/* UTF-8 byte length of every element through the packed export, -1 for null elements. */
+JNIEXPORT jintArray JNICALL Java_TestStringArrayLarge_packedLengths(JNIEnv *env, jclass cls, jobjectArray input) {
+	(void)cls;
+	jutf8packed_t *packed = GetStringUTF8ArrayPacked(env, input);
+	if (packed == NULL) return NULL;
+
+	jintArray result = (*env)->NewIntArray(env, packed->count);
+	if (result != NULL) {
+		jint *lengths = (jint *)malloc(sizeof(jint) * (packed->count ? packed->count : 1));
+		if (lengths != NULL) {
+			for (jsize i = 0; i < packed->count; i++) {
+				const char *s = jutf8packed_at(packed, i);
+				lengths[i] = s ? (jint)strlen(s) : -1;
+				if (s && lengths[i] != packed->lengths[i]) lengths[i] = -2;
+			}
+			(*env)->SetIntArrayRegion(env, result, 0, packed->count, lengths);
+			free(lengths);
+		}
+	}
+	ReleaseStringUTF8ArrayPacked(packed);
+	return result;
+}
+
+/* Export through the packed UTF-8 block and rebuild the String[] from it. */
+JNIEXPORT jobjectArray JNICALL Java_TestStringArrayLarge_packedRoundTrip(JNIEnv *env, jclass cls, jobjectArray input) {
+	(void)cls;
+	jutf8packed_t *packed = GetStringUTF8ArrayPacked(env, input);
+	if (packed == NULL) return NULL;
+	jobjectArray result = NewStringUTF8ArrayPacked(env, packed->data, packed->offsets, packed->lengths, packed->count, packed->nulls);
+	ReleaseStringUTF8ArrayPacked(packed);
+	return result;
+}
+
+/* Packed columns shared by StringArrayPackedTest: "s0".."s<n-1>", every 10th element null. */
+static char *packedLatin1 = NULL;
+static jchar *packedUtf16 = NULL;
+static size_t *packedOffsets = NULL;
+static jboolean *packedNulls = NULL;
+static jsize packedCount = 0;
+
+JNIEXPORT void JNICALL Java_StringArrayPackedTest_prepare(JNIEnv *env, jclass cls, jint count) {
+	(void)env; (void)cls;
+	free(packedLatin1); free(packedUtf16); free(packedOffsets); free(packedNulls);
+	packedLatin1 = (char *)malloc((size_t)count * 12 + 1);
+	packedUtf16 = (jchar *)malloc(((size_t)count * 12 + 1) * sizeof(jchar));
+	packedOffsets = (size_t *)malloc(((size_t)count + 1) * sizeof(size_t));
+	packedNulls = (jboolean *)malloc((size_t)count + 1);
+	packedCount = count;
+	size_t pos = 0;
+	for (jint i = 0; i < count; i++) {
+		packedOffsets[i] = pos;
+		packedNulls[i] = (i % 10 == 9) ? JNI_TRUE : JNI_FALSE;
+		if (!packedNulls[i])
+			pos += (size_t)sprintf(packedLatin1 + pos, "s%d", i);
+	}
+	packedOffsets[count] = pos;
+	for (size_t k = 0; k < pos; k++)
+		packedUtf16[k] = (jchar)(unsigned char)packedLatin1[k];
+}
+
+JNIEXPORT jobjectArray JNICALL Java_StringArrayPackedTest_build(JNIEnv *env, jclass cls, jboolean latin1, jboolean upcall) {
+	(void)cls;
+	xjni_SetStringArrayPackedThreshold(upcall ? 0 : 0x7fffffff);
+	return latin1
+		? xjni_NewStringLatin1ArrayPacked(env, packedLatin1, packedOffsets, NULL, packedCount, packedNulls)
+		: xjni_NewStringArrayPacked(env, packedUtf16, packedOffsets, NULL, packedCount, packedNulls);
+}
+
+/* Hash every element through xjni_GetStringArrayPacked; null elements count as -1. */
+JNIEXPORT jlong JNICALL Java_StringArrayPackedTest_exportHash(JNIEnv *env, jclass cls, jobjectArray input, jboolean upcall) {
+	(void)cls;
+	xjni_SetStringArrayPackedThreshold(upcall ? 0 : 0x7fffffff);
+	jstringspans_t *spans = xjni_GetStringArrayPacked(env, input);
+	if (spans == NULL) return 0;
+	jlong hash = 0;
+	for (jsize i = 0; i < spans->count; i++) {
+		if (spans->spans[i].data == NULL) {
+			hash = hash * 31 - 1;
+			continue;
+		}
+		for (jsize k = 0; k < spans->spans[i].length; k++)
+			hash = hash * 31 + spans->spans[i].data[k];
+	}
+	xjni_ReleaseStringArrayPacked(env, spans);
+	return hash;
+}
+
+/* Round trip through a retained handle; release must not touch the input array again. */
+JNIEXPORT jobjectArray JNICALL Java_TestStringArrayLarge_handleRoundTrip(JNIEnv *env, jclass cls, jobjectArray input, jboolean global) {
+	(void)cls;
+	jstringarray_t *handle = GetStringUTFArrayHandle(env, input, global, NULL);
+	if (handle == NULL) return NULL;
+	jobjectArray result = NewStringUTFArray(env, handle->utf, handle->count);
+	ReleaseStringArrayHandle(env, handle);
+	return result;
+}
+
+/* Build n cells cycling over a few status codes, plus one unique value per cell when unique is set. */
+JNIEXPORT jobjectArray JNICALL Java_TestStringArrayLarge_dedup(JNIEnv *env, jclass cls, jint n, jboolean unique, jboolean intern) {
+	(void)cls;
+	static const char *codes[] = { "OK", "FAIL", "PENDING", "RETRY" };
+	const char **utf = (const char **)malloc(sizeof(char *) * (size_t)(n ? n : 1));
+	char *buf = unique ? (char *)malloc((size_t)n * 16 + 1) : NULL;
+	if (utf == NULL || (unique && buf == NULL)) { free(utf); free(buf); return NULL; }
+	for (jint i = 0; i < n; i++) {
+		if (unique) {
+			snprintf(buf + (size_t)i * 16, 16, "u%d", i);
+			utf[i] = buf + (size_t)i * 16;
+		} else {
+			utf[i] = (i % 13 == 0) ? NULL : codes[i % 4];
+		}
+	}
+	jobjectArray result = NewStringUTFArrayDedup(env, utf, n, intern);
+	free(buf);
+	free(utf);
+	return result;
+}
+
+/* Sort input in place and return the permutation; the parallel run uses its own pool. */
+JNIEXPORT jintArray JNICALL Java_TestStringArrayLarge_sort(JNIEnv *env, jclass cls, jobjectArray input, jboolean parallel) {
+	(void)cls;
+	xjni_pool_t *pool = NULL;
+	if (parallel) {
+		JavaVM *vm = NULL;
+		if ((*env)->GetJavaVM(env, &vm) != JNI_OK || (pool = xjni_pool_new(vm, 0)) == NULL) return NULL;
+	}
+	jsize len = (*env)->GetArrayLength(env, input);
+	jint *perm = (jint *)malloc(sizeof(jint) * (size_t)(len ? len : 1));
+	jintArray result = NULL;
+	if (perm != NULL && xjni_SortStringArray(env, pool, input, perm, JNI_TRUE) == JNI_OK) {
+		result = (*env)->NewIntArray(env, len);
+		if (result != NULL)
+			(*env)->SetIntArrayRegion(env, result, 0, len, perm);
+	}
+	free(perm);
+	xjni_pool_free(pool);
+	return result;
+}
@@ -78,3 +78,25 @@ JNIEXPORT void Java_TestXJNI_testUnsupportedEncodingException(JNIEnv* env, jobje
     throwUnsupportedEncodingException(env, "xjni_test", "Stress UnsupportedEncodingException from C");
 }
 
+
+/* TestXJNI.mix(true, -2, 'a', 300, 40000, 5000000000L, 1.5f, 2.25, "x") */
+#define TestXJNI_MIX_EXPECTED 5000040412LL
+
+/* Call back into TestXJNI with mixed arguments, no boxing; returns the number of failed checks. */
+JNIEXPORT jint JNICALL
+Java_TestXJNI_testCallBuilders(JNIEnv *env, jobject thiz) {
+	jint failed = 0;
+	jstring s = (*env)->NewStringUTF(env, "x");
+	for (int round = 0; round < 2; round++) { /* the second round hits the method cache */
+		jlong sum = CallStaticLongMethodBuilder(env, "TestXJNI", "mix", "(ZBCSIJFDLjava/lang/String;)J",
+			JNI_TRUE, (jbyte)-2, (jchar)'a', (jshort)300, (jint)40000, (jlong)5000000000LL, 1.5f, 2.25, s);
+		if (sum != TestXJNI_MIX_EXPECTED) failed++;
+		if (CallIntMethodBuilder(env, thiz, "TestXJNI", "scale", "(I)I", 21) != 42) failed++;
+		jvalue args[1];
+		args[0].i = 7;
+		if (CallIntMethodBuilderA(env, thiz, "TestXJNI", "scale", "(I)I", args) != 14) failed++;
+		CallVoidMethodBuilder(env, thiz, "TestXJNI", "touch", "()V");
+	}
+	(*env)->DeleteLocalRef(env, s);
+	return failed;
+}
@@ -1,4 +1,7 @@
+#include <stdlib.h>
+#include <string.h>
 #include "xjni_args.h"
+#include <xjni.h>
 #include <xjni_va_list.h>
 
 JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_formatWithJNI
@@ -29,3 +32,137 @@ JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_formatWithJNINoArgs
     (*env)->DeleteLocalRef(env, args);
     return (*env)->NewStringUTF(env, buffer);
 }
+
+JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_formatWithJNIBuilder
+  (JNIEnv *env, jobject thiz) {
+
+    jargs_builder_t *builder = NewJArgsBuilder(env, 10, (*env)->FindClass(env,"java/lang/Object"));
+    if (!builder) return NULL;
+
+    // same sequence as formatWithJNINoArgs, tracked by the native cursor
+    JArgsBuilderAppendChar(env, builder, 'A');
+    JArgsBuilderInsertDouble(env, builder, 3.14, 1);
+    JArgsBuilderAppendInt(env, builder, 42);
+    jstring helloStr = (*env)->NewStringUTF(env, "hello");
+    JArgsBuilderAppendString(env, builder, helloStr);
+    JArgsBuilderAppendBoolean(env, builder, JNI_TRUE);
+    JArgsBuilderReplaceInt(env, builder,(jchar)0x754C,0);
+    (*env)->DeleteLocalRef(env, helloStr);
+    jargs_t args = JArgsBuilderFinish(builder);
+
+    char buffer[4096];
+    JSnPrintfUTF(env, buffer, sizeof(buffer), "Char: %c, Double: %f, Int: %d, String: %s, Boolean: %b", args);
+    (*env)->DeleteLocalRef(env, args);
+    return (*env)->NewStringUTF(env, buffer);
+}
+
+JNIEXPORT jobjectArray JNICALL Java_TestXJNIPrintf_buildInts
+  (JNIEnv *env, jobject thiz, jint n) {
+    jargs_builder_t *builder = NewJArgsBuilder(env, n, (*env)->FindClass(env,"java/lang/Integer"));
+    if (!builder) return NULL;
+    // 1..n-1 appended, then 0 inserted in front
+    for (jint i = 1; i < n; i++)
+        JArgsBuilderAppendInt(env, builder, i);
+    JArgsBuilderInsertInt(env, builder, 0, 0);
+    if (JArgsBuilderSize(builder) != n) {
+        JArgsBuilderFree(env, builder);
+        return NULL;
+    }
+    return JArgsBuilderFinish(builder);
+}
+
+JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_formatWithJNIStage
+  (JNIEnv *env, jobject thiz) {
+
+    jargs_stage_t *stage = JArgsStageNew(0);
+    if (!stage) return NULL;
+
+    // same arguments as formatWithJNINoArgs, built out of order natively
+    JArgsStageAppendBoolean(stage, JNI_TRUE);
+    JArgsStageInsertStringUTF(stage, "hello", 0);
+    JArgsStageInsertInt(stage, 42, 0);
+    JArgsStageInsertDouble(stage, 3.14, 0);
+    JArgsStageInsertLong(stage, 7, 0);
+    JArgsStageInsertChar(stage, 'A', 0);
+    JArgsStageDelete(stage, 1);
+    JArgsStageReplaceInt(stage, (jchar)0x754C, 0);
+
+    char buffer[4096];
+    JSnPrintfUTFStage(env, buffer, sizeof(buffer), "Char: %c, Double: %f, Int: %d, String: %s, Boolean: %b", stage);
+    JArgsStageFree(stage);
+    return (*env)->NewStringUTF(env, buffer);
+}
+
+JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_decodeAll
+  (JNIEnv *env, jobject thiz, jargs_t args) {
+    jsize len = (*env)->GetArrayLength(env, args);
+    jvalue values[16];
+    char types[16];
+    if (len > 16 || GetJArgsAll(env, args, values, types) != len) return NULL;
+
+    // one "<type><value>" token per element, "-" for null
+    char buffer[512];
+    size_t pos = 0;
+    for (jsize i = 0; i < len && pos < sizeof(buffer) - 64; i++) {
+        const char *sep = i ? " " : "";
+        switch (types[i]) {
+            case 'Z': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sZ%d", sep, values[i].z); break;
+            case 'B': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sB%d", sep, values[i].b); break;
+            case 'C': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sC%c", sep, (char)values[i].c); break;
+            case 'S': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sS%d", sep, values[i].s); break;
+            case 'I': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sI%d", sep, values[i].i); break;
+            case 'J': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sJ%lld", sep, (long long)values[i].j); break;
+            case 'F': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sF%.1f", sep, values[i].f); break;
+            case 'D': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sD%.1f", sep, values[i].d); break;
+            case 'L': pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%sL", sep); break;
+            default: pos += snprintf(buffer + pos, sizeof(buffer) - pos, "%s-", sep); break;
+        }
+    }
+    buffer[pos] = '\0';
+    return (*env)->NewStringUTF(env, buffer);
+}
+
+JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_jcharFormat
+  (JNIEnv *env, jobject thiz, jstring s) {
+    jchar format[64], out[256];
+    size_t flen = 64;
+    if (!xjni_fromstring("%ls=%d %s|%-6S|%.3f", format, &flen)) return NULL;
+
+    const jchar *chars = (*env)->GetStringChars(env, s, NULL);
+    if (!chars) return NULL;
+    jsize n = (*env)->GetStringLength(env, s);
+    jchar *copy = (jchar *)malloc(((size_t)n + 1) * sizeof(jchar));
+    int len = -1;
+    if (copy) {
+        memcpy(copy, chars, (size_t)n * sizeof(jchar));
+        copy[n] = 0;
+        // written straight as UTF-16: %ls / %S take jchar strings, %s UTF-8
+        len = snjprintf(out, 256, format, copy, 42, "\xc3\xa9t\xc3\xa9", copy, 2.5);
+    }
+    free(copy);
+    (*env)->ReleaseStringChars(env, s, chars);
+    return len < 0 ? NULL : (*env)->NewString(env, out, len);
+}
+
+JNIEXPORT jstring JNICALL Java_TestXJNIPrintf_formatToJava
+  (JNIEnv *env, jobject thiz, jobject sb) {
+    if (xjni_FormatAppend(env, sb, "%s:%05d", "sb", 42) != 8) return NULL;
+    return xjni_FormatToJString(env, "%s %.1f %x \xf0\x9f\x98\x80", "\xc3\xa9", 0.5, 255);
+}
+
+/* Print through JFPrintf or JDPrintf into the file at path, truncating it first. */
+JNIEXPORT jboolean JNICALL Java_TestXJNIPrintf_printToPath
+  (JNIEnv *env, jobject thiz, jstring path, jboolean fd, jstring format, jargs_t args) {
+    const char *name = (*env)->GetStringUTFChars(env, path, NULL);
+    if (!name) return JNI_FALSE;
+    FILE *fp = fopen(name, "wb");
+    (*env)->ReleaseStringUTFChars(env, path, name);
+    if (!fp) return JNI_FALSE;
+    if (fd) {
+        fflush(fp);
+        JDPrintf(env, fileno(fp), format, args);
+    } else {
+        JFPrintf(env, fp, format, args);
+    }
+    return fclose(fp) == 0 ? JNI_TRUE : JNI_FALSE;
+}
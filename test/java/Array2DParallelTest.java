@@ -0,0 +1,70 @@
+public class Array2DParallelTest {
+    static { System.loadLibrary("xjni_test"); }
+
+    private static native boolean nativeInit(int threads);
+    private static native void nativeFree();
+    private static native double nativeSum(double[][] arr, int cols, boolean parallel);
+    private static native boolean nativeFill(int[][] arr, int cols);
+
+    private static double expected(double[][] arr, int cols) {
+        double sum = 0.0;
+        long n = 0;
+        for (double[] row : arr)
+            for (int j = 0; j < cols; j++, n++)
+                sum += row[j] * (n % 7);
+        return sum;
+    }
+
+    private static long time(double[][] arr, int cols, boolean parallel, int reps) {
+        long best = Long.MAX_VALUE;
+        for (int r = 0; r < reps; r++) {
+            long t0 = System.nanoTime();
+            nativeSum(arr, cols, parallel);
+            best = Math.min(best, System.nanoTime() - t0);
+        }
+        return best;
+    }
+
+    public static void main(String[] args) {
+        if (!nativeInit(0)) {
+            System.out.println("pool: FAIL");
+            return;
+        }
+
+        int cols = 64;
+        double[][] small = new double[37][cols];
+        for (int i = 0; i < small.length; i++)
+            for (int j = 0; j < cols; j++)
+                small[i][j] = i * cols + j;
+        double want = expected(small, cols);
+        boolean ok = nativeSum(small, cols, false) == want && nativeSum(small, cols, true) == want;
+        System.out.println("serial/parallel get: " + (ok ? "OK" : "FAIL"));
+
+        int[][] ints = new int[1000][5];
+        ok = nativeFill(ints, 5);
+        for (int i = 0; ok && i < ints.length; i++)
+            for (int j = 0; j < 5; j++)
+                ok &= ints[i][j] == i * 5 + j;
+        System.out.println("parallel set: " + (ok ? "OK" : "FAIL"));
+
+        double[][] ragged = { new double[cols], new double[cols - 1] };
+        System.out.println("short row rejected: " + (nativeSum(ragged, cols, true) == -1.0 ? "OK" : "FAIL"));
+
+        // Crossover benchmark: best of several runs per size
+        System.out.println("rows x " + cols + " doubles: serial us / parallel us");
+        int crossover = -1;
+        for (int rows = 16; rows <= 131072; rows *= 4) {
+            double[][] arr = new double[rows][cols];
+            time(arr, cols, false, 3);
+            time(arr, cols, true, 3);
+            long s = time(arr, cols, false, 10);
+            long p = time(arr, cols, true, 10);
+            System.out.println(rows + ": " + (s / 1000) + " / " + (p / 1000));
+            if (crossover < 0 && p < s)
+                crossover = rows;
+        }
+        System.out.println("parallel faster from rows: " + (crossover < 0 ? "never" : ((long)crossover * cols) + " elements"));
+
+        nativeFree();
+    }
+}
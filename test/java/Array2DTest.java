@@ -4,6 +4,7 @@ public class Array2DTest {
     public String[][] str2d;
 
     private native void nativeTest();
+    private static native float[] nativeColMajor(int[][] arr, int cols);
 
     public static void main(String[] args) {
         Array2DTest t = new Array2DTest();
@@ -29,5 +30,16 @@ public class Array2DTest {
         for (int i = 0; i < t.str2d.length; i++)
             for (int j = 0; j < t.str2d[i].length; j++)
                 System.out.println("str2d[" + i + "][" + j + "] = " + t.str2d[i][j]);
+
+        int[][] m = new int[40][35];
+        for (int i = 0; i < 40; i++)
+            for (int j = 0; j < 35; j++)
+                m[i][j] = i * 100 + j;
+        float[] cm = nativeColMajor(m, 35);
+        boolean ok = cm != null && cm.length == 40 * 35;
+        for (int i = 0; ok && i < 40; i++)
+            for (int j = 0; j < 35; j++)
+                ok &= cm[j * 40 + i] == i * 100 + j && m[i][j] == -(i * 100 + j);
+        System.out.println("int[][] -> column-major float and back: " + (ok ? "OK" : "FAIL"));
     }
 }
@@ -4,6 +4,9 @@ public class ArrayFieldTest {
     // ===== instance fields =====
     public String[] stringArray;
     public int[] intArray;
+    public char[] charArray;
+    public short[] shortArray;
+    public boolean[] flags;
 
     // ===== static fields =====
     public static String[] staticStringArray;
@@ -11,6 +14,7 @@ public class ArrayFieldTest {
 
     // native test entry
     private native void nativeTest();
+    private native void nativeByName();
 
     public static void main(String[] args) {
         ArrayFieldTest t = new ArrayFieldTest();
@@ -35,5 +39,20 @@ public class ArrayFieldTest {
 
         for (int i : staticIntArray)
             System.out.println("staticIntArray: " + i);
+
+        t.charArray = "hello".toCharArray();
+        t.shortArray = new short[] { 1 };
+        t.flags = new boolean[] { true, false, true };
+        t.nativeByName();
+        boolean ok = new String(t.charArray).equals("HELLO");
+        System.out.println("char[] elements by name: " + (ok ? "OK" : "FAIL"));
+        ok = !t.flags[0] && t.flags[1] && !t.flags[2];
+        System.out.println("boolean[] elements by name: " + (ok ? "OK" : "FAIL"));
+        ok = t.shortArray.length == 2 && t.shortArray[0] == 7 && t.shortArray[1] == 8;
+        System.out.println("short[] set by name: " + (ok ? "OK" : "FAIL"));
+        ok = staticIntArray.length == 1 && staticIntArray[0] == 4242;
+        System.out.println("SetStaticArrayField: " + (ok ? "OK" : "FAIL"));
+        ok = staticStringArray == t.stringArray;
+        System.out.println("String[] by name: " + (ok ? "OK" : "FAIL"));
     }
 }
@@ -0,0 +1,39 @@
+public class ArrayNDTest {
+    static { System.loadLibrary("xjni_test"); }
+
+    private static native float[] nativeFlatten(float[][][] arr);
+    private static native double[][][][] nativeBuild(int d0, int d1, int d2, int d3);
+    private static native void nativeTranspose(int[][] src, int[][] dst);
+    private static native boolean nativeIsRectangular(Object arr, int rank);
+
+    public static void main(String[] args) {
+        float[][][] f3 = new float[2][3][4];
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 3; j++)
+                for (int k = 0; k < 4; k++)
+                    f3[i][j][k] = i * 100 + j * 10 + k;
+
+        float[] flat = nativeFlatten(f3);
+        boolean ok = flat != null && flat.length == 24;
+        for (int n = 0; ok && n < 24; n++)
+            ok = flat[n] == f3[n / 12][(n / 4) % 3][n % 4];
+        System.out.println("flatten float[2][3][4]: " + (ok ? "OK" : "FAIL"));
+
+        double[][][][] d4 = nativeBuild(2, 2, 3, 2);
+        ok = d4 != null && d4.length == 2 && d4[1][1][2].length == 2 && d4[1][1][2][1] == 23.0;
+        System.out.println("build double[2][2][3][2]: " + (ok ? "OK" : "FAIL"));
+
+        int[][] src = { {1, 2, 3}, {4, 5, 6} };
+        int[][] dst = new int[3][2];
+        nativeTranspose(src, dst);
+        ok = true;
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 3; j++)
+                ok &= dst[j][i] == src[i][j];
+        System.out.println("strided transpose int[2][3]: " + (ok ? "OK" : "FAIL"));
+
+        int[][] ragged = { {1, 2}, {3} };
+        System.out.println("ragged detected: " + (!nativeIsRectangular(ragged, 2) ? "OK" : "FAIL"));
+        System.out.println("empty rectangular: " + (nativeIsRectangular(new int[0][5][7], 3) ? "OK" : "FAIL"));
+    }
+}
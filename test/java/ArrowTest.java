@@ -0,0 +1,36 @@
+import java.util.Arrays;
+
+public class ArrowTest {
+    static { System.loadLibrary("xjni_test"); }
+
+    /* rank 0: String[], rank 1: primitive array, rank 2: primitive 2D array */
+    private static native Object nativeRoundTrip(Object array, char type, int rank);
+    private static native String nativeFormat(Object array, char type, int rank);
+
+    public static void main(String[] args) {
+        int[] ints = new int[1000];
+        for (int i = 0; i < ints.length; i++) ints[i] = i * 7 - 500;
+        boolean ok = Arrays.equals(ints, (int[]) nativeRoundTrip(ints, 'I', 1)) && "i/0".equals(nativeFormat(ints, 'I', 1));
+        System.out.println("int[] round trip: " + (ok ? "OK" : "FAIL"));
+
+        boolean[] bools = new boolean[13];
+        for (int i = 0; i < bools.length; i++) bools[i] = i % 3 == 0;
+        ok = Arrays.equals(bools, (boolean[]) nativeRoundTrip(bools, 'Z', 1)) && "b/0".equals(nativeFormat(bools, 'Z', 1));
+        System.out.println("bit-packed boolean[] round trip: " + (ok ? "OK" : "FAIL"));
+
+        double[][] rect = new double[4][3];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 3; j++)
+                rect[i][j] = i + j / 10.0;
+        ok = Arrays.deepEquals(rect, (double[][]) nativeRoundTrip(rect, 'D', 2)) && "+w:3/0".equals(nativeFormat(rect, 'D', 2));
+        System.out.println("double[4][3] as FixedSizeList: " + (ok ? "OK" : "FAIL"));
+
+        int[][] ragged = { {1, 2, 3}, null, {}, {4} };
+        ok = Arrays.deepEquals(ragged, (int[][]) nativeRoundTrip(ragged, 'I', 2)) && "+l/1".equals(nativeFormat(ragged, 'I', 2));
+        System.out.println("ragged int[][] with null row as List: " + (ok ? "OK" : "FAIL"));
+
+        String[] strings = { "a", "", null, "h\u00e9llo \u20ac\ud83d\ude00", "zz" };
+        ok = Arrays.equals(strings, (String[]) nativeRoundTrip(strings, 'L', 0)) && "u/1".equals(nativeFormat(strings, 'L', 0));
+        System.out.println("String[] as utf8 with validity: " + (ok ? "OK" : "FAIL"));
+    }
+}
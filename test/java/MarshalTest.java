@@ -0,0 +1,93 @@
+import java.nio.charset.StandardCharsets;
+
+public class MarshalTest {
+    static { System.loadLibrary("xjni_test"); }
+
+    static class Record {
+        int id;
+        double score;
+        boolean active;
+        String name;
+        int[] values;
+
+        Record() {}
+
+        Record(int id, double score, boolean active, String name, int[] values) {
+            this.id = id;
+            this.score = score;
+            this.active = active;
+            this.name = name;
+            this.values = values;
+        }
+    }
+
+    static Object[] fromColumns(int[] id, double[] score, boolean[] active, String[] name, int[][] values) {
+        Record[] out = new Record[id.length];
+        for (int i = 0; i < id.length; i++)
+            out[i] = new Record(id[i], score[i], active[i], name[i], values[i]);
+        return out;
+    }
+
+    private static native long nativeChecksum(Record[] records);
+    private static native Object[] nativeBuild(int n, int mode);
+
+    static boolean builtOk(Object[] built, int n) {
+        if (built == null || built.length != n) return false;
+        for (int i = 0; i < n; i++) {
+            if (!(built[i] instanceof Record)) return false;
+            Record r = (Record) built[i];
+            if (r.id != i || r.score != i * 0.5 || r.active != (i % 2 == 0)) return false;
+            String name = (i % 7 == 0) ? null : "record-" + i;
+            if (name == null ? r.name != null : !name.equals(r.name)) return false;
+            int[] values = (i % 5 == 0) ? null : new int[] { i, -i, i % 17 };
+            if (!java.util.Arrays.equals(values, r.values)) return false;
+        }
+        return true;
+    }
+
+    static long checksum(Record[] records) {
+        long sum = 0;
+        for (Record r : records) {
+            if (r == null) {
+                sum = sum * 31;
+                sum = sum * 31 - 1;
+                continue;
+            }
+            sum = sum * 31 + r.id + (long) (r.score * 2) + (r.active ? 1 : 0);
+            sum = sum * 31 + (r.name == null ? -1 : r.name.getBytes(StandardCharsets.UTF_8).length);
+            if (r.values != null)
+                for (int v : r.values)
+                    sum = sum * 31 + v;
+        }
+        return sum;
+    }
+
+    public static void main(String[] args) {
+        int n = 50000;
+        Record[] records = new Record[n];
+        for (int i = 0; i < n; i++) {
+            if (i % 1000 == 999) continue;
+            Record r = new Record();
+            r.id = i;
+            r.score = i * 0.5;
+            r.active = i % 2 == 0;
+            r.name = (i % 7 == 0) ? null : "record-" + i + (i % 3 == 0 ? "\u00e9" : "");
+            r.values = (i % 5 == 0) ? null : new int[] { i, -i, i % 17 };
+            records[i] = r;
+        }
+
+        long expected = checksum(records);
+        long t0 = System.nanoTime();
+        long actual = nativeChecksum(records);
+        long t1 = System.nanoTime();
+        System.out.println("marshal 50k records: " + (actual == expected ? "OK" : "FAIL") + " (" + (t1 - t0) / 1000 + " us)");
+
+        String[] modes = { "fields", "constructor", "factory" };
+        for (int mode = 0; mode < modes.length; mode++) {
+            t0 = System.nanoTime();
+            Object[] built = nativeBuild(n, mode);
+            t1 = System.nanoTime();
+            System.out.println("build 50k records (" + modes[mode] + "): " + (builtOk(built, n) ? "OK" : "FAIL") + " (" + (t1 - t0) / 1000 + " us)");
+        }
+    }
+}
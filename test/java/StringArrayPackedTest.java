@@ -0,0 +1,94 @@
+public class StringArrayPackedTest {
+    static { System.loadLibrary("xjni_test"); }
+
+    private static native void prepare(int count);
+    private static native String[] build(boolean latin1, boolean upcall);
+    private static native long exportHash(String[] input, boolean upcall);
+
+    private static long hash(String[] input) {
+        long hash = 0;
+        for (String s : input) {
+            if (s == null) {
+                hash = hash * 31 - 1;
+                continue;
+            }
+            for (int k = 0; k < s.length(); k++)
+                hash = hash * 31 + s.charAt(k);
+        }
+        return hash;
+    }
+
+    private static long timeExport(String[] input, boolean upcall, int reps) {
+        long best = Long.MAX_VALUE;
+        for (int r = 0; r < reps; r++) {
+            long t0 = System.nanoTime();
+            exportHash(input, upcall);
+            best = Math.min(best, System.nanoTime() - t0);
+        }
+        return best;
+    }
+
+    private static boolean check(String[] out, int n) {
+        if (out == null || out.length != n)
+            return false;
+        for (int i = 0; i < n; i++) {
+            String want = (i % 10 == 9) ? null : "s" + i;
+            if (want == null ? out[i] != null : !want.equals(out[i]))
+                return false;
+        }
+        return true;
+    }
+
+    private static long time(boolean latin1, boolean upcall, int reps) {
+        long best = Long.MAX_VALUE;
+        for (int r = 0; r < reps; r++) {
+            long t0 = System.nanoTime();
+            build(latin1, upcall);
+            best = Math.min(best, System.nanoTime() - t0);
+        }
+        return best;
+    }
+
+    public static void main(String[] args) {
+        int[] sizes = { 10, 1000, 1000000 };
+        for (int n : sizes) {
+            prepare(n);
+            boolean ok = check(build(false, false), n) && check(build(false, true), n)
+                && check(build(true, false), n) && check(build(true, true), n);
+            System.out.println(n + " strings packed construction: " + (ok ? "OK" : "FAIL"));
+
+            String[] input = build(false, true);
+            input[0] = "\u00e9\ud83d\ude00";
+            long want = hash(input);
+            ok = exportHash(input, false) == want && exportHash(input, true) == want;
+            System.out.println(n + " strings packed export: " + (ok ? "OK" : "FAIL"));
+        }
+
+        // Per-element NewString vs one XJNIStrings upcall: best of several runs per size
+        System.out.println("strings: per-element us / upcall UTF-16 us / upcall Latin-1 us");
+        for (int n : sizes) {
+            prepare(n);
+            int reps = n >= 1000000 ? 5 : 200;
+            time(false, false, 3);
+            time(false, true, 3);
+            time(true, true, 3);
+            long e = time(false, false, reps);
+            long u = time(false, true, reps);
+            long l = time(true, true, reps);
+            System.out.println(n + ": " + (e / 1000.0) + " / " + (u / 1000.0) + " / " + (l / 1000.0));
+        }
+
+        // Per-element GetStringRegion vs one XJNIStrings.concat upcall
+        System.out.println("strings: per-element export us / upcall export us");
+        for (int n : sizes) {
+            prepare(n);
+            String[] input = build(false, true);
+            int reps = n >= 1000000 ? 5 : 200;
+            timeExport(input, false, 3);
+            timeExport(input, true, 3);
+            long e = timeExport(input, false, reps);
+            long u = timeExport(input, true, reps);
+            System.out.println(n + ": " + (e / 1000.0) + " / " + (u / 1000.0));
+        }
+    }
+}
@@ -0,0 +1,107 @@
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.Random;
+
+public class TestStringArrayLarge {
+    static { System.loadLibrary("xjni_test"); }
+
+    private static native String[] roundTrip(String[] input);
+    private static native int[] packedLengths(String[] input);
+    private static native String[] packedRoundTrip(String[] input);
+    private static native String[] handleRoundTrip(String[] input, boolean global);
+    private static native String[] dedup(int n, boolean unique, boolean intern);
+    private static native int[] sort(String[] input, boolean parallel);
+
+    public static void main(String[] args) {
+        int n = 1000000;
+        String[] input = new String[n];
+        for (int i = 0; i < n; i++)
+            input[i] = (i % 1000 == 0) ? null : "s" + i;
+
+        String[] output = roundTrip(input);
+        boolean ok = output != null && output.length == n;
+        for (int i = 0; ok && i < n; i++)
+            ok = (input[i] == null) ? output[i] == null : input[i].equals(output[i]);
+        System.out.println("1M-element String[] round trip: " + (ok ? "OK" : "FAIL"));
+
+        for (int i = 0; i < n; i++)
+            if (input[i] != null && i % 3 == 0)
+                input[i] += "\u00e9\u20ac\ud83d\ude00";
+        int[] lengths = packedLengths(input);
+        ok = lengths != null && lengths.length == n;
+        for (int i = 0; ok && i < n; i++)
+            ok = lengths[i] == (input[i] == null ? -1 : input[i].getBytes(StandardCharsets.UTF_8).length);
+        System.out.println("1M-element packed UTF-8 export: " + (ok ? "OK" : "FAIL"));
+
+        output = packedRoundTrip(input);
+        ok = output != null && output.length == n;
+        for (int i = 0; ok && i < n; i++)
+            ok = (input[i] == null) ? output[i] == null : input[i].equals(output[i]);
+        System.out.println("1M-element packed UTF-8 round trip: " + (ok ? "OK" : "FAIL"));
+
+        for (boolean global : new boolean[] { false, true }) {
+            output = handleRoundTrip(input, global);
+            ok = output != null && output.length == n;
+            for (int i = 0; ok && i < n; i++)
+                ok = (input[i] == null) ? output[i] == null : input[i].equals(output[i]);
+            System.out.println("1M-element " + (global ? "global" : "local") + " handle round trip: " + (ok ? "OK" : "FAIL"));
+        }
+
+        String[] codes = { "OK", "FAIL", "PENDING", "RETRY" };
+        output = dedup(n, false, false);
+        ok = output != null && output.length == n;
+        for (int i = 0; ok && i < n; i++) {
+            String want = (i % 13 == 0) ? null : codes[i % 4];
+            ok = (want == null) ? output[i] == null : want.equals(output[i]);
+            if (ok && want != null && i >= 4 && output[i - 4] != null)
+                ok = output[i - 4] == output[i];
+        }
+        System.out.println("1M-element dedup shares equal values: " + (ok ? "OK" : "FAIL"));
+
+        output = dedup(1000, false, true);
+        ok = output != null && output[1] == "FAIL" && output[2] == "PENDING";
+        System.out.println("dedup with intern matches literals: " + (ok ? "OK" : "FAIL"));
+
+        output = dedup(n, true, false);
+        ok = output != null && output.length == n;
+        for (int i = 0; ok && i < n; i++)
+            ok = ("u" + i).equals(output[i]);
+        System.out.println("1M-element dedup of unique values: " + (ok ? "OK" : "FAIL"));
+
+        /* Code-unit order: surrogate pairs sort below U+FF00 like String.compareTo, unlike code point order. */
+        Random random = new Random(36);
+        String[] alphabet = { "a", "ab", "b", "\u00e9", "\uff01", "\ud83d\ude00", "" };
+        for (boolean parallel : new boolean[] { false, true }) {
+            String[] unsorted = new String[n];
+            for (int i = 0; i < n; i++) {
+                if (i % 997 == 0) continue;
+                StringBuilder sb = new StringBuilder();
+                for (int k = random.nextInt(4); k >= 0; k--)
+                    sb.append(alphabet[random.nextInt(alphabet.length)]);
+                unsorted[i] = sb.toString();
+            }
+            String[] expected = unsorted.clone();
+            Arrays.sort(expected, Comparator.nullsFirst(Comparator.<String>naturalOrder()));
+            String[] sorted = unsorted.clone();
+            int[] perm = sort(sorted, parallel);
+            ok = perm != null && perm.length == n;
+            for (int i = 0; ok && i < n; i++)
+                ok = sorted[i] == unsorted[perm[i]] && (expected[i] == null ? sorted[i] == null : expected[i].equals(sorted[i]))
+                    && (i == 0 || !(sorted[i] == null ? sorted[i - 1] == null : sorted[i].equals(sorted[i - 1])) || perm[i - 1] < perm[i]);
+            System.out.println("1M-element " + (parallel ? "parallel" : "serial") + " native sort: " + (ok ? "OK" : "FAIL"));
+        }
+
+        /* A rotated array sorts through one cycle over every element, far past a 256-reference frame chunk. */
+        int m = 100000;
+        String[] rotated = new String[m];
+        for (int i = 0; i < m; i++)
+            rotated[i] = String.format("r%06d", (i + 1) % m);
+        String[] cycled = rotated.clone();
+        int[] perm = sort(cycled, false);
+        ok = perm != null && perm.length == m;
+        for (int i = 0; ok && i < m; i++)
+            ok = perm[i] == (i + m - 1) % m && cycled[i] == rotated[perm[i]] && cycled[i].equals(String.format("r%06d", i));
+        System.out.println("100K-element single-cycle native sort: " + (ok ? "OK" : "FAIL"));
+    }
+}
@@ -12,6 +12,17 @@ public class TestXJNI {
     public native void testFileNotFoundException() throws java.io.FileNotFoundException;
     public native void testUnsupportedEncodingException() throws java.io.UnsupportedEncodingException;
     public native void testStringUtilities(char[] input);
+    public native int testCallBuilders();
+
+    private int touched;
+
+    static long mix(boolean z, byte b, char c, short s, int i, long j, float f, double d, String str) {
+        return (z ? 1 : 0) + b + c + s + i + j + (long) (f * 4) + (long) (d * 4) + str.length();
+    }
+
+    int scale(int v) { return v * 2; }
+
+    void touch() { touched++; }
 
     private static final int THREADS = 8;
     private static final int ITERATIONS = 50;
@@ -60,5 +71,8 @@ public class TestXJNI {
 
         char[] input = "Hello JNI".toCharArray();
         t.testStringUtilities(input);
+
+        int failed = t.testCallBuilders();
+        System.out.println("call builders: " + (failed == 0 && t.touched == 2 ? "OK" : "FAIL (" + failed + ")"));
     }
 }
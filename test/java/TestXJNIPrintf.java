@@ -1,5 +1,9 @@
+import java.io.File;
 import java.math.BigInteger;
 import java.math.BigDecimal;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.Arrays;
 
 public class TestXJNIPrintf {
 
@@ -9,8 +13,15 @@ public class TestXJNIPrintf {
 
 	private native String formatWithJNI(String format, Object... args);
 	private native String formatWithJNINoArgs();
+	private native String formatWithJNIBuilder();
+	private native String formatWithJNIStage();
+	private native Object[] buildInts(int n);
+	private native String decodeAll(Object... args);
+	private native String jcharFormat(String s);
+	private native String formatToJava(StringBuilder sb);
+	private native boolean printToPath(String path, boolean fd, String format, Object... args);
 
-	public static void main(String[] args) {
+	public static void main(String[] args) throws Exception {
 		TestXJNIPrintf t = new TestXJNIPrintf();
 
 		String result = t.formatWithJNI(
@@ -33,5 +44,69 @@ public class TestXJNIPrintf {
 
 		result = t.formatWithJNINoArgs();
 		System.out.println(result);
+
+		String built = t.formatWithJNIBuilder();
+		System.out.println("builder format: " + (result.equals(built) ? "OK" : "FAIL"));
+
+		String staged = t.formatWithJNIStage();
+		System.out.println("staged format: " + (result.equals(staged) ? "OK" : "FAIL"));
+
+		Object[][] cases = {
+			{ "%-12s|%5.2s|%S", "Hello", "xyz", true },
+			{ "%+06d % d %x %#o %#010X", 42, 7, (byte) -1, 8, -255 },
+			{ "%2$s %1$s %<s %n", "a", "b" },
+			{ "%.2f %.1f %.0f %.20f %08.3f", 0.125, 0.25, 2.5, 0.1, -3.14159f },
+			{ "%e %.0e %#.0e %E %.3e", 12345.678, 5.0, 5.0, -0.0, 1e-300 },
+			{ "%f %f %-10.2f| %b %b %c %c", Double.NaN, Double.NEGATIVE_INFINITY, 1.005, null, "x", 'q', 0x754C },
+			{ "%d %s %c %b %%", null, null, null, null },
+			{ "%,d %g %s %h", 1234567, 1.5, 2.5, "fallback" },
+		};
+		boolean same = true;
+		for (Object[] c : cases) {
+			String format = (String) c[0];
+			Object[] rest = java.util.Arrays.copyOfRange(c, 1, c.length);
+			String expected = String.format(format, rest);
+			String actual = t.formatWithJNI(format, rest);
+			if (!expected.equals(actual)) {
+				same = false;
+				System.out.println("  [" + format + "] expected [" + expected + "] got [" + actual + "]");
+			}
+		}
+		System.out.println("native format: " + (same ? "OK" : "FAIL"));
+
+		String jchars = t.jcharFormat("k\u754C\uD83D\uDE00");
+		String jexpected = String.format("%s=%d %s|%-6s|%.3f", "k\u754C\uD83D\uDE00", 42, "\u00E9t\u00E9", "k\u754C\uD83D\uDE00", 2.5);
+		System.out.println("jchar format: " + (jexpected.equals(jchars) ? "OK" : "FAIL " + jchars));
+
+		StringBuilder sb = new StringBuilder(">");
+		String direct = t.formatToJava(sb);
+		System.out.println("format to jstring: " + ("\u00E9 0.5 ff \uD83D\uDE00".equals(direct) && ">sb:00042".equals(sb.toString()) ? "OK" : "FAIL " + direct + " " + sb));
+
+		/* String.format fallback streamed as UTF-8, longer than the FMT_CHARS * FMT_IOV chunks of one writev */
+		StringBuilder longText = new StringBuilder();
+		for (int i = 0; i < 600; i++)
+			longText.append("\uD83D\uDE00\u00E9\u754Cx");
+		String fallbackFormat = "%,d %h [%s]%n";
+		Object[] fallbackArgs = { 1234567, longText.toString(), longText.toString() };
+		byte[] want = String.format(fallbackFormat, fallbackArgs).getBytes(StandardCharsets.UTF_8);
+		for (boolean fd : new boolean[] { false, true }) {
+			File out = File.createTempFile("xjni-printf", ".txt");
+			boolean written = t.printToPath(out.getPath(), fd, fallbackFormat, fallbackArgs);
+			byte[] got = Files.readAllBytes(out.toPath());
+			out.delete();
+			System.out.println((fd ? "JDPrintf" : "JFPrintf") + " fallback stream: " + (written && Arrays.equals(want, got) ? "OK" : "FAIL " + got.length + "/" + want.length));
+		}
+
+		String decoded = t.decodeAll(true, (byte) -3, 'x', (short) 300, 42, 7L, 1.5f, 2.5, "s", null, 43);
+		System.out.println("decode all: " + ("Z1 B-3 Cx S300 I42 J7 F1.5 D2.5 L - I43".equals(decoded) ? "OK" : "FAIL " + decoded));
+
+		int n = 100000;
+		long t0 = System.nanoTime();
+		Object[] ints = t.buildInts(n);
+		long t1 = System.nanoTime();
+		boolean ok = ints != null && ints.length == n;
+		for (int i = 0; ok && i < n; i++)
+			ok = ints[i] instanceof Integer && (Integer) ints[i] == i;
+		System.out.println("builder 100k appends: " + (ok ? "OK" : "FAIL") + " (" + (t1 - t0) / 1000 + " us)");
 	}
 }